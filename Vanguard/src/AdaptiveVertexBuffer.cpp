@@ -0,0 +1,69 @@
+#include "AdaptiveVertexBuffer.h"
+
+vg::AdaptiveCPUVertexBuffer::AdaptiveCPUVertexBuffer(VertexBuffer&& vb, GLuint vertex_count, bool is_mutable, AdaptiveSplitPolicy policy)
+	: _layout(vb.layout()), _is_mutable(is_mutable), _policy(policy), _frames_written(_layout->attributes().size(), 0),
+	_written(_layout->attributes().size(), false), _blocks(_layout->attributes().size(), COLD_BLOCK)
+{
+	_interleaved.emplace(std::move(vb), vertex_count, is_mutable);
+}
+
+void vg::AdaptiveCPUVertexBuffer::bind_vao() const
+{
+	if (_split)
+		_split->bind_vao();
+	else
+		_interleaved->bind_vao();
+}
+
+void vg::AdaptiveCPUVertexBuffer::attach_index_buffer(ids::GLBuffer ib)
+{
+	_ib = ib;
+	if (_split)
+		_split->attach_index_buffer(ib);
+	else
+		_interleaved->attach_index_buffer(ib);
+}
+
+bool vg::AdaptiveCPUVertexBuffer::is_dirty() const
+{
+	if (!_split)
+		return _interleaved->is_dirty();
+	return _split->is_dirty(HOT_BLOCK) || _split->is_dirty(COLD_BLOCK);
+}
+
+void vg::AdaptiveCPUVertexBuffer::flush()
+{
+	if (_split)
+		_split->flush();
+	else
+		_interleaved->flush();
+	if (_frames < _policy.warmup_frames)
+		end_frame();
+}
+
+void vg::AdaptiveCPUVertexBuffer::end_frame()
+{
+	for (GLuint a = 0; a < _written.size(); ++a)
+	{
+		if (_written[a])
+			++_frames_written[a];
+		_written[a] = false;
+	}
+	if (++_frames < _policy.warmup_frames)
+		return;
+
+	std::vector<std::vector<GLuint>> blocks(2);
+	for (GLuint a = 0; a < _frames_written.size(); ++a)
+	{
+		_blocks[a] = _frames_written[a] >= _policy.hot_fraction * _policy.warmup_frames ? HOT_BLOCK : COLD_BLOCK;
+		blocks[_blocks[a]].push_back(a);
+	}
+	if (blocks[HOT_BLOCK].empty() || blocks[COLD_BLOCK].empty())
+		return;
+
+	// The interleaved buffer was just flushed, so the transcoded copy uploaded by the block constructor is current.
+	_split.emplace(VertexBufferBlock(_layout, blocks), *_interleaved, _is_mutable);
+	if (_ib)
+		_split->attach_index_buffer(_ib);
+	_interleaved.reset();
+}
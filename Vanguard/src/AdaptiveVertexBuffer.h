@@ -0,0 +1,117 @@
+#pragma once
+
+#include <optional>
+
+#include "Renderable.h"
+
+namespace vg
+{
+	struct AdaptiveSplitPolicy
+	{
+		GLuint warmup_frames = 60;
+		float hot_fraction = 0.5f;
+	};
+
+	// AdaptiveCPUVertexBuffer starts out as an interleaved CPUVertexBuffer and counts, per attribute, the frames in which the mutable accessors wrote to it. After a warm-up window of
+	// flush() calls, attributes written in at least a hot_fraction of those frames move into a hot block of their own and the rest stay packed in a cold block, so that later flushes
+	// upload only the hot stream's bytes instead of whole vertices. The split is made once: if every attribute or no attribute is hot, the buffer stays interleaved.
+	// Vertex offsets change when the buffer splits, so access goes through (vertex, attrib) only.
+	class AdaptiveCPUVertexBuffer
+	{
+	public:
+		static constexpr GLuint HOT_BLOCK = 0;
+		static constexpr GLuint COLD_BLOCK = 1;
+
+	private:
+		std::shared_ptr<VertexBufferLayout> _layout;
+		std::optional<CPUVertexBuffer> _interleaved;
+		std::optional<CPUVertexBufferBlock> _split;
+		ids::GLBuffer _ib;
+		bool _is_mutable;
+		AdaptiveSplitPolicy _policy;
+		GLuint _frames = 0;
+		std::vector<GLuint> _frames_written;
+		std::vector<bool> _written;
+		std::vector<GLuint> _blocks;
+
+		void record(GLuint attrib) { if (_frames < _policy.warmup_frames) _written[attrib] = true; }
+		void end_frame();
+
+	public:
+		AdaptiveCPUVertexBuffer(VertexBuffer&& vb, GLuint vertex_count, bool is_mutable, AdaptiveSplitPolicy policy = {});
+
+		const std::shared_ptr<VertexBufferLayout>& layout() const { return _layout; }
+		bool is_split() const { return _split.has_value(); }
+		// Only meaningful once is_split(): HOT_BLOCK or COLD_BLOCK.
+		GLuint block(GLuint attrib) const { return _blocks[attrib]; }
+		ids::VertexArray vao() const { return _split ? _split->vao() : _interleaved->vao(); }
+		void bind_vao() const;
+		void attach_index_buffer(ids::GLBuffer ib);
+
+		GLuint vertex_count() const { return _split ? _split->vertex_count(HOT_BLOCK) : _interleaved->vertex_count(); }
+
+		bool is_dirty() const;
+		// Uploads dirty ranges, then closes the current frame of the warm-up window. The frame that ends the window also performs the split.
+		void flush();
+
+		template<typename Type>
+		const Type& ref(GLuint vertex, GLuint attrib) const
+		{
+			return _split ? _split->template ref<Type>(_blocks[attrib], vertex, attrib) : _interleaved->template ref<Type>(vertex, attrib);
+		}
+
+		template<typename Type>
+		Type& ref(GLuint vertex, GLuint attrib)
+		{
+			record(attrib);
+			return _split ? _split->template ref<Type>(_blocks[attrib], vertex, attrib) : _interleaved->template ref<Type>(vertex, attrib);
+		}
+
+		template<typename Type>
+		Type val(GLuint vertex, GLuint attrib) const
+		{
+			return _split ? _split->template val<Type>(_blocks[attrib], vertex, attrib) : _interleaved->template val<Type>(vertex, attrib);
+		}
+
+		template<typename Type>
+		void set_attribute(GLuint attrib, GLuint starting_vertex, GLuint count, const Type& obj)
+		{
+			record(attrib);
+			if (_split)
+				_split->set_attribute(_blocks[attrib], attrib, starting_vertex, count, obj);
+			else
+				_interleaved->set_attribute(attrib, starting_vertex, count, obj);
+		}
+
+		template<typename Type>
+		void set_attribute(GLuint attrib, const Type& obj)
+		{
+			set_attribute(attrib, 0, vertex_count(), obj);
+		}
+
+		template<typename Type>
+		void set_attributes(GLuint attrib, GLuint starting_vertex, const Type* objs, GLuint count)
+		{
+			record(attrib);
+			if (_split)
+				_split->set_attributes(_blocks[attrib], attrib, starting_vertex, objs, count);
+			else
+				_interleaved->set_attributes(attrib, starting_vertex, objs, count);
+		}
+
+		template<typename Type, size_t N>
+		void set_attributes(GLuint attrib, GLuint starting_vertex, const std::array<Type, N>& objs)
+		{
+			set_attributes(attrib, starting_vertex, objs.data(), (GLuint)N);
+		}
+
+		template<typename Type>
+		void get_attributes(GLuint attrib, GLuint starting_vertex, Type* objs, GLuint count) const
+		{
+			if (_split)
+				_split->get_attributes(_blocks[attrib], attrib, starting_vertex, objs, count);
+			else
+				_interleaved->get_attributes(attrib, starting_vertex, objs, count);
+		}
+	};
+}
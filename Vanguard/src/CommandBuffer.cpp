@@ -0,0 +1,213 @@
+#include "CommandBuffer.h"
+
+#include "Errors.h"
+
+// Key layout, most significant first: layer (8 bits), framebuffer (8), shader (16), VAO (16), texture set (16). Each field holds a dense slot assigned in order of first use,
+// not the GL name, so it always fits. Slots past a field's range wrap around, which only weakens grouping, since replay binds from the recorded state and not from the key.
+static GLuint64 pack_key(GLuint layer, GLuint framebuffer, GLuint shader, GLuint vao, GLuint texture_set)
+{
+	return (GLuint64(layer & 0xFF) << 56) | (GLuint64(framebuffer & 0xFF) << 48) | (GLuint64(shader & 0xFFFF) << 32) | (GLuint64(vao & 0xFFFF) << 16) | GLuint64(texture_set & 0xFFFF);
+}
+
+static GLuint slot_of(std::unordered_map<GLuint, GLuint>& slots, GLuint name)
+{
+	return slots.try_emplace(name, (GLuint)slots.size()).first->second;
+}
+
+static bool same_state(const vg::DrawState& a, const vg::DrawState& b)
+{
+	return a.shader == b.shader && a.vao == b.vao && a.vertex_buffer == b.vertex_buffer && a.framebuffer == b.framebuffer && a.layer == b.layer && a.textures == b.textures;
+}
+
+GLuint vg::CommandBuffer::state_index(const DrawState& state)
+{
+	if (!state.shader)
+		throw Error(ErrorCode::NULL_POINTER, "draw state has no shader");
+	if (!_states.empty() && same_state(_states.back(), state))
+		return (GLuint)_states.size() - 1;
+
+	std::array<GLuint, DrawState::MAX_TEXTURE_SLOTS> texture_names;
+	for (GLuint i = 0; i < DrawState::MAX_TEXTURE_SLOTS; ++i)
+		texture_names[i] = state.textures[i];
+	GLuint texture_set = _texture_set_slots.try_emplace(texture_names, (GLuint)_texture_set_slots.size()).first->second;
+
+	// Buffers that share a VAO sort together, since swapping one into the VAO is cheaper than switching VAOs.
+	ids::VertexArray vao = state.vertex_buffer ? state.vertex_buffer->vao() : state.vao;
+	_state_keys.push_back(pack_key(state.layer, slot_of(_framebuffer_slots, state.framebuffer), slot_of(_shader_slots, *state.shader), slot_of(_vao_slots, vao), texture_set));
+	_states.push_back(state);
+	return (GLuint)_states.size() - 1;
+}
+
+void vg::CommandBuffer::record(const DrawState& state, Command command)
+{
+	command.state = state_index(state);
+	_commands.push_back(command);
+}
+
+void vg::CommandBuffer::arrays(const DrawState& state, DrawMode mode, GLint first_vertex, GLsizei vertex_count)
+{
+	Command command{ CommandType::ARRAYS, mode };
+	command.first = first_vertex;
+	command.count = vertex_count;
+	record(state, command);
+}
+
+void vg::CommandBuffer::elements(const DrawState& state, DrawMode mode, GLsizei index_count, GLuint first_index, IndexDataType idt)
+{
+	Command command{ CommandType::ELEMENTS, mode, idt };
+	command.first = first_index;
+	command.count = index_count;
+	record(state, command);
+}
+
+void vg::CommandBuffer::base_vertex_elements(const DrawState& state, DrawMode mode, GLsizei index_count, GLuint first_index, GLint base_vertex, IndexDataType idt)
+{
+	Command command{ CommandType::ELEMENTS_BASE_VERTEX, mode, idt };
+	command.first = first_index;
+	command.count = index_count;
+	command.base_vertex = base_vertex;
+	record(state, command);
+}
+
+void vg::CommandBuffer::instanced_arrays(const DrawState& state, DrawMode mode, GLint first_vertex, GLsizei vertex_count, GLsizei instance_count, GLuint first_instance)
+{
+	Command command{ CommandType::INSTANCED_ARRAYS, mode };
+	command.first = first_vertex;
+	command.count = vertex_count;
+	command.instance_count = instance_count;
+	command.first_instance = first_instance;
+	record(state, command);
+}
+
+void vg::CommandBuffer::instanced_base_vertex_elements(const DrawState& state, DrawMode mode, GLsizei index_count, GLuint first_index, GLsizei instance_count, GLint base_vertex,
+	GLuint first_instance, IndexDataType idt)
+{
+	Command command{ CommandType::INSTANCED_ELEMENTS_BASE_VERTEX, mode, idt };
+	command.first = first_index;
+	command.count = index_count;
+	command.base_vertex = base_vertex;
+	command.instance_count = instance_count;
+	command.first_instance = first_instance;
+	record(state, command);
+}
+
+void vg::CommandBuffer::multi_indirect(const DrawState& state, const GPUIndirectElementsBlock& indirect, DrawMode mode, GLuint first, GLuint count, IndexDataType idt)
+{
+	Command command{ CommandType::MULTI_INDIRECT, mode, idt };
+	command.first = first;
+	command.count = count;
+	command.indirect = &indirect;
+	record(state, command);
+}
+
+void vg::CommandBuffer::sort()
+{
+	_sorted.resize(_commands.size());
+	for (GLuint i = 0; i < _commands.size(); ++i)
+		_sorted[i] = { _state_keys[_commands[i].state], i };
+	_scratch.resize(_sorted.size());
+
+	// LSD radix sort on 8-bit digits. Each pass is stable, so equal keys keep their recorded order. Passes where every key has the same digit are skipped,
+	// which with dense slots is most of the high digits.
+	for (GLuint shift = 0; shift < 64; shift += 8)
+	{
+		size_t counts[256] = {};
+		for (const SortEntry& entry : _sorted)
+			++counts[(entry.key >> shift) & 0xFF];
+		if (counts[(_sorted[0].key >> shift) & 0xFF] == _sorted.size())
+			continue;
+
+		size_t offset = 0;
+		for (size_t& count : counts)
+		{
+			size_t c = count;
+			count = offset;
+			offset += c;
+		}
+		for (const SortEntry& entry : _sorted)
+			_scratch[counts[(entry.key >> shift) & 0xFF]++] = entry;
+		_sorted.swap(_scratch);
+	}
+}
+
+void vg::CommandBuffer::submit()
+{
+	if (_commands.empty())
+		return;
+	sort();
+
+	const DrawState* prev = nullptr;
+	for (const SortEntry& entry : _sorted)
+	{
+		const Command& command = _commands[entry.command];
+		const DrawState& state = _states[command.state];
+
+		if (!prev || prev->framebuffer != state.framebuffer)
+		{
+			framebuffers::bind(state.framebuffer, framebuffers::Target::DRAW);
+			++_binds_issued;
+		}
+		else
+			++_binds_skipped;
+		if (!prev || prev->shader != state.shader)
+		{
+			bind_shader(*state.shader);
+			++_binds_issued;
+		}
+		else
+			++_binds_skipped;
+		if (!prev || prev->vao != state.vao || prev->vertex_buffer != state.vertex_buffer)
+		{
+			if (state.vertex_buffer)
+				state.vertex_buffer->bind_vao();
+			else
+				bind_vertex_array(state.vao);
+			++_binds_issued;
+		}
+		else
+			++_binds_skipped;
+		if (!prev || prev->textures != state.textures)
+		{
+			bind_textures_to_slots(state.textures.data(), 0, DrawState::MAX_TEXTURE_SLOTS);
+			++_binds_issued;
+		}
+		else
+			++_binds_skipped;
+		prev = &state;
+
+		switch (command.type)
+		{
+		case CommandType::ARRAYS:
+			draw::arrays(command.mode, command.first, command.count);
+			break;
+		case CommandType::ELEMENTS:
+			draw::elements(command.mode, command.count, command.first, command.idt);
+			break;
+		case CommandType::ELEMENTS_BASE_VERTEX:
+			draw::base_vertex::elements(command.mode, command.count, command.first, command.base_vertex, command.idt);
+			break;
+		case CommandType::INSTANCED_ARRAYS:
+			draw::instanced::arrays(command.mode, command.first, command.count, command.instance_count, command.first_instance);
+			break;
+		case CommandType::INSTANCED_ELEMENTS_BASE_VERTEX:
+			draw::instanced_base_vertex::elements(command.mode, command.count, command.first, command.instance_count, command.base_vertex, command.first_instance, command.idt);
+			break;
+		case CommandType::MULTI_INDIRECT:
+			command.indirect->bind();
+			draw::multi_indirect(*command.indirect, command.mode, command.first, command.count, command.idt);
+			break;
+		}
+	}
+	clear();
+}
+
+void vg::CommandBuffer::clear()
+{
+	_states.clear();
+	_state_keys.clear();
+	_commands.clear();
+	_framebuffer_slots.clear();
+	_shader_slots.clear();
+	_vao_slots.clear();
+	_texture_set_slots.clear();
+}
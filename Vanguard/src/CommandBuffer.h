@@ -0,0 +1,104 @@
+#pragma once
+
+#include <array>
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+#include "Draw.h"
+#include "raii/FrameBuffer.h"
+
+namespace vg
+{
+	// DrawState is everything a recorded draw needs bound: the target framebuffer (0 for the window), shader, VAO, and the textures in slots 0 to MAX_TEXTURE_SLOTS - 1.
+	// layer orders draws before any state does, e.g. to keep opaque geometry ahead of transparent geometry. Set vertex_buffer instead of vao for a VertexBuffer, whose VAO is
+	// shared with other buffers of its layout: replay then swaps the buffer into the shared VAO.
+	struct DrawState
+	{
+		static const GLuint MAX_TEXTURE_SLOTS = 8;
+
+		const Shader* shader = nullptr;
+		ids::VertexArray vao;
+		const VertexBuffer* vertex_buffer = nullptr;
+		ids::FrameBuffer framebuffer;
+		std::array<ids::Texture, MAX_TEXTURE_SLOTS> textures;
+		GLubyte layer = 0;
+	};
+
+	// CommandBuffer records draw calls with the state they need instead of issuing them. submit() radix sorts them by a packed 64-bit key (layer, framebuffer, shader, VAO, textures, in order
+	// of decreasing bind cost), then replays them, binding a framebuffer, shader, VAO or texture set only when it differs from the previous draw's. Draws with identical keys keep their recorded order.
+	class CommandBuffer
+	{
+		enum class CommandType : char
+		{
+			ARRAYS,
+			ELEMENTS,
+			ELEMENTS_BASE_VERTEX,
+			INSTANCED_ARRAYS,
+			INSTANCED_ELEMENTS_BASE_VERTEX,
+			MULTI_INDIRECT
+		};
+
+		struct Command
+		{
+			CommandType type = CommandType::ARRAYS;
+			DrawMode mode = DrawMode::TRIANGLES;
+			IndexDataType idt = IndexDataType::UINT;
+			GLuint state = 0;
+			GLuint first = 0;
+			GLsizei count = 0;
+			GLint base_vertex = 0;
+			GLsizei instance_count = 0;
+			GLuint first_instance = 0;
+			const GPUIndirectElementsBlock* indirect = nullptr;
+		};
+
+		struct SortEntry
+		{
+			GLuint64 key;
+			GLuint command;
+		};
+
+		std::vector<DrawState> _states;
+		std::vector<GLuint64> _state_keys;
+		std::vector<Command> _commands;
+		std::vector<SortEntry> _sorted;
+		std::vector<SortEntry> _scratch;
+
+		std::unordered_map<GLuint, GLuint> _framebuffer_slots;
+		std::unordered_map<GLuint, GLuint> _shader_slots;
+		std::unordered_map<GLuint, GLuint> _vao_slots;
+		std::map<std::array<GLuint, DrawState::MAX_TEXTURE_SLOTS>, GLuint> _texture_set_slots;
+
+		GLuint _binds_issued = 0;
+		GLuint _binds_skipped = 0;
+
+		GLuint state_index(const DrawState& state);
+		void record(const DrawState& state, Command command);
+		void sort();
+
+	public:
+		CommandBuffer() = default;
+
+		void arrays(const DrawState& state, DrawMode mode, GLint first_vertex, GLsizei vertex_count);
+		void elements(const DrawState& state, DrawMode mode, GLsizei index_count, GLuint first_index, IndexDataType idt);
+		void base_vertex_elements(const DrawState& state, DrawMode mode, GLsizei index_count, GLuint first_index, GLint base_vertex, IndexDataType idt);
+		void instanced_arrays(const DrawState& state, DrawMode mode, GLint first_vertex, GLsizei vertex_count, GLsizei instance_count, GLuint first_instance = 0);
+		void instanced_base_vertex_elements(const DrawState& state, DrawMode mode, GLsizei index_count, GLuint first_index, GLsizei instance_count, GLint base_vertex,
+			GLuint first_instance, IndexDataType idt);
+		void multi_indirect(const DrawState& state, const GPUIndirectElementsBlock& indirect, DrawMode mode, GLuint first, GLuint count, IndexDataType idt);
+
+		void index_buffer(const DrawState& state, const CPUIndexBuffer& ib, DrawMode mode) { elements(state, mode, ib.size(), 0, ib.data_type()); }
+		void mesh(const DrawState& state, const MeshHeap& heap, MeshHeap::Mesh mesh, DrawMode mode)
+		{
+			base_vertex_elements(state, mode, heap.index_count(mesh), heap.first_index(mesh), heap.base_vertex(mesh), heap.data_type());
+		}
+
+		GLuint size() const { return (GLuint)_commands.size(); }
+		GLuint binds_issued() const { return _binds_issued; }
+		GLuint binds_skipped() const { return _binds_skipped; }
+
+		void submit();
+		void clear();
+	};
+}
@@ -1,5 +1,7 @@
 #include "Draw.h"
 
+#include <vector>
+
 void vg::draw::arrays(DrawMode mode, GLint first_vertex, GLsizei vertex_count)
 {
 	glDrawArrays((GLenum)mode, first_vertex, vertex_count);
@@ -95,6 +97,16 @@ void vg::draw::indirect(const CPUIndirectArrays& indirect, DrawMode mode)
 	draw::indirect(indirect.gpu_arrays(), mode);
 }
 
+void vg::draw::indirect(const CPUIndirectArraysBlock& indirect, GLuint i, DrawMode mode)
+{
+	draw::indirect(indirect.gpu_arrays(), i, mode);
+}
+
+void vg::draw::multi_indirect(const CPUIndirectArraysBlock& indirect, DrawMode mode, GLuint first, GLuint count)
+{
+	draw::multi_indirect(indirect.gpu_arrays(), mode, first, count);
+}
+
 void vg::draw::indirect(const GPUIndirectElements& indirect, DrawMode mode, IndexDataType idt)
 {
 	glDrawElementsIndirect((GLenum)mode, (GLenum)idt, 0);
@@ -120,6 +132,16 @@ void vg::draw::indirect(const CPUIndirectElements& indirect, DrawMode mode)
 	draw::indirect(indirect.gpu_elements(), mode, indirect.idt);
 }
 
+void vg::draw::indirect(const CPUIndirectElementsBlock& indirect, GLuint i, DrawMode mode)
+{
+	draw::indirect(indirect.gpu_elements(), i, mode, indirect.idt);
+}
+
+void vg::draw::multi_indirect(const CPUIndirectElementsBlock& indirect, DrawMode mode, GLuint first, GLuint count)
+{
+	draw::multi_indirect(indirect.gpu_elements(), mode, first, count, indirect.idt);
+}
+
 void vg::draw::index_buffer::full(const CPUIndexBuffer& ib, DrawMode mode)
 {
 	elements(mode, ib.size(), 0, ib.data_type());
@@ -135,6 +157,11 @@ void vg::draw::index_buffer::part(const CPUIndexBuffer& ib, DrawMode mode, GLuin
 	elements(mode, count, first, ib.data_type());
 }
 
+void vg::draw::index_buffer::full(const QuadIndexView& quads, DrawMode mode)
+{
+	elements(mode, quads.index_count(), 0, quads.data_type());
+}
+
 void vg::draw::index_buffer::instanced(const CPUIndexBuffer& ib, DrawMode mode, GLuint instance_count)
 {
 	instanced::elements(mode, ib.size(), 0, instance_count, ib.data_type());
@@ -239,3 +266,42 @@ void vg::draw::vertex_buffer::part(const CPUVertexBufferBlock& vbb, GLuint i, Dr
 {
 	arrays(mode, first, vbb.vertex_count(i) - first);
 }
+
+#if VANGUARD_MIN_OPENGL_VERSION_IS_AT_LEAST(4, 4)
+
+void vg::draw::vertex_buffer::full(const StreamVertexBuffer& svb, DrawMode mode)
+{
+	arrays(mode, svb.first_vertex(), svb.vertex_count());
+}
+
+void vg::draw::vertex_buffer::part(const StreamVertexBuffer& svb, DrawMode mode, GLuint first)
+{
+	arrays(mode, svb.first_vertex() + first, svb.vertex_count() - first);
+}
+
+#endif
+
+void vg::draw::mesh_heap::single(const MeshHeap& heap, MeshHeap::Mesh mesh, DrawMode mode)
+{
+	base_vertex::elements(mode, heap.index_count(mesh), heap.first_index(mesh), heap.base_vertex(mesh), heap.data_type());
+}
+
+void vg::draw::mesh_heap::instanced(const MeshHeap& heap, MeshHeap::Mesh mesh, DrawMode mode, GLuint instance_count)
+{
+	instanced_base_vertex::elements(mode, heap.index_count(mesh), heap.first_index(mesh), instance_count, heap.base_vertex(mesh), heap.data_type());
+}
+
+void vg::draw::mesh_heap::multi(const MeshHeap& heap, const MeshHeap::Mesh* meshes, GLsizei count, DrawMode mode)
+{
+	std::vector<GLsizei> index_counts(count);
+	std::vector<GLintptr> first_index_bytes(count);
+	std::vector<GLint> base_vertices(count);
+	GLintptr index_size = index_data_type_size(heap.data_type());
+	for (GLsizei i = 0; i < count; ++i)
+	{
+		index_counts[i] = heap.index_count(meshes[i]);
+		first_index_bytes[i] = heap.first_index(meshes[i]) * index_size;
+		base_vertices[i] = heap.base_vertex(meshes[i]);
+	}
+	multi::elements_base_vertex(mode, index_counts.data(), first_index_bytes.data(), heap.data_type(), base_vertices.data(), count);
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Renderable.h"
+#include "QuadIndices.h"
 
 namespace vg
 {
@@ -58,17 +59,22 @@ namespace vg
 		extern void indirect(const GPUIndirectArraysBlock& indirect, GLuint i, DrawMode mode);
 		extern void multi_indirect(const GPUIndirectArraysBlock& indirect, DrawMode mode, GLuint first, GLuint count);
 		extern void indirect(const CPUIndirectArrays& indirect, DrawMode mode);
+		extern void indirect(const CPUIndirectArraysBlock& indirect, GLuint i, DrawMode mode);
+		extern void multi_indirect(const CPUIndirectArraysBlock& indirect, DrawMode mode, GLuint first, GLuint count);
 		
 		extern void indirect(const GPUIndirectElements& indirect, DrawMode mode, IndexDataType idt);
 		extern void indirect(const GPUIndirectElementsBlock& indirect, GLuint i, DrawMode mode, IndexDataType idt);
 		extern void multi_indirect(const GPUIndirectElementsBlock& indirect, DrawMode mode, GLuint first, GLuint count, IndexDataType idt);
 		extern void indirect(const CPUIndirectElements& indirect, DrawMode mode);
+		extern void indirect(const CPUIndirectElementsBlock& indirect, GLuint i, DrawMode mode);
+		extern void multi_indirect(const CPUIndirectElementsBlock& indirect, DrawMode mode, GLuint first, GLuint count);
 
 		namespace index_buffer
 		{
 			extern void full(const CPUIndexBuffer& ib, DrawMode mode);
 			extern void part(const CPUIndexBuffer& ib, DrawMode mode, GLuint first);
 			extern void part(const CPUIndexBuffer& ib, DrawMode mode, GLuint first, GLuint count);
+			extern void full(const QuadIndexView& quads, DrawMode mode);
 
 			extern void instanced(const CPUIndexBuffer& ib, DrawMode mode, GLuint instance_count);
 			extern void instanced(const CPUIndexBuffer& ib, DrawMode mode, GLuint instance_count, GLuint first);
@@ -101,6 +107,18 @@ namespace vg
 
 			extern void full(const CPUVertexBufferBlock& vbb, GLuint i, DrawMode mode);
 			extern void part(const CPUVertexBufferBlock& vbb, GLuint i, DrawMode mode, GLuint first);
+
+#if VANGUARD_MIN_OPENGL_VERSION_IS_AT_LEAST(4, 4)
+			extern void full(const StreamVertexBuffer& svb, DrawMode mode);
+			extern void part(const StreamVertexBuffer& svb, DrawMode mode, GLuint first);
+#endif
+		}
+
+		namespace mesh_heap
+		{
+			extern void single(const MeshHeap& heap, MeshHeap::Mesh mesh, DrawMode mode);
+			extern void instanced(const MeshHeap& heap, MeshHeap::Mesh mesh, DrawMode mode, GLuint instance_count);
+			extern void multi(const MeshHeap& heap, const MeshHeap::Mesh* meshes, GLsizei count, DrawMode mode);
 		}
 	}
 }
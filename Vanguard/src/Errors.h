@@ -24,6 +24,14 @@ namespace vg
 		SUBSHADER_COMPILATION,
 		SHADER_LINKAGE,
 		INVALID_TEXTURE_SLOT,
+		BUFFER_MAPPING,
+		FENCE_WAIT,
+		HEAP_ALLOCATION,
+		VERTEX_LAYOUT_MISMATCH,
+		INDEX_TYPE_OVERFLOW,
+		INVALID_TRIANGLE_LIST,
+		UNSUPPORTED_TEXTURE_TARGET,
+		INVALID_UPLOAD_RANGE,
 	};
 
 	struct Error : public std::runtime_error
@@ -0,0 +1,296 @@
+#include "GLState.h"
+
+// Marks a binding point whose GL value is not known, so the next bind is always issued.
+static const GLuint UNKNOWN = GLuint(-1);
+
+static const GLenum BUFFER_TARGETS[] = {
+	GL_ARRAY_BUFFER, GL_ATOMIC_COUNTER_BUFFER, GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, GL_DISPATCH_INDIRECT_BUFFER, GL_DRAW_INDIRECT_BUFFER, GL_ELEMENT_ARRAY_BUFFER,
+	GL_PIXEL_PACK_BUFFER, GL_PIXEL_UNPACK_BUFFER, GL_QUERY_BUFFER, GL_SHADER_STORAGE_BUFFER, GL_TEXTURE_BUFFER, GL_TRANSFORM_FEEDBACK_BUFFER, GL_UNIFORM_BUFFER
+};
+static const GLuint BUFFER_TARGET_COUNT = sizeof(BUFFER_TARGETS) / sizeof(GLenum);
+static const GLuint INDEX_BUFFER_SLOT = 6;
+
+static const GLenum TEXTURE_TARGETS[] = {
+	GL_TEXTURE_1D, GL_TEXTURE_2D, GL_TEXTURE_1D_ARRAY, GL_TEXTURE_RECTANGLE, GL_TEXTURE_3D, GL_TEXTURE_2D_ARRAY, GL_TEXTURE_CUBE_MAP, GL_TEXTURE_CUBE_MAP_ARRAY,
+	GL_TEXTURE_2D_MULTISAMPLE, GL_TEXTURE_2D_MULTISAMPLE_ARRAY, GL_TEXTURE_BUFFER
+};
+static const GLuint TEXTURE_TARGET_COUNT = sizeof(TEXTURE_TARGETS) / sizeof(GLenum);
+// Matches the slot range accepted by select_texture_slot(). Units past it are passed through uncached.
+static const GLuint TEXTURE_UNIT_COUNT = 32;
+
+static struct
+{
+	GLuint buffers[BUFFER_TARGET_COUNT];
+	GLuint vao;
+	GLuint active_unit;
+	GLuint textures[TEXTURE_UNIT_COUNT][TEXTURE_TARGET_COUNT];
+	// The texture last bound to each unit with glBindTextureUnit/glBindTextures, which bind without naming a target.
+	GLuint unit_textures[TEXTURE_UNIT_COUNT];
+	GLuint draw_framebuffer;
+	GLuint read_framebuffer;
+	GLuint program;
+} cache; // Zero-initialized, which is the state of a new context: every binding point at 0 and unit 0 active.
+
+static vg::state::Counters stats;
+
+static GLuint buffer_slot(GLenum target)
+{
+	for (GLuint i = 0; i < BUFFER_TARGET_COUNT; ++i)
+		if (BUFFER_TARGETS[i] == target)
+			return i;
+	return UNKNOWN;
+}
+
+static GLuint texture_slot(GLenum target)
+{
+	for (GLuint i = 0; i < TEXTURE_TARGET_COUNT; ++i)
+		if (TEXTURE_TARGETS[i] == target)
+			return i;
+	return UNKNOWN;
+}
+
+static bool update(GLuint& cached, GLuint value, vg::state::Counter& counter)
+{
+	if (cached == value)
+	{
+		++counter.skipped;
+		return false;
+	}
+	cached = value;
+	++counter.issued;
+	return true;
+}
+
+static void set_unit_from_unit_bind(GLuint unit, GLuint texture)
+{
+	// Binding 0 unbinds every target of the unit. Otherwise only the texture's own target changes, and that target is not known here.
+	for (GLuint t = 0; t < TEXTURE_TARGET_COUNT; ++t)
+		cache.textures[unit][t] = texture == 0 ? 0 : UNKNOWN;
+	cache.unit_textures[unit] = texture;
+}
+
+void vg::state::bind_buffer(GLenum target, GLuint buffer)
+{
+	GLuint slot = buffer_slot(target);
+	if (slot == UNKNOWN)
+	{
+		++stats.buffers.issued;
+		glBindBuffer(target, buffer);
+	}
+	else if (update(cache.buffers[slot], buffer, stats.buffers))
+		glBindBuffer(target, buffer);
+}
+
+GLuint vg::state::bound_buffer(GLenum target)
+{
+	GLuint slot = buffer_slot(target);
+	return slot == UNKNOWN ? UNKNOWN : cache.buffers[slot];
+}
+
+void vg::state::bind_vertex_array(GLuint vao)
+{
+	if (update(cache.vao, vao, stats.vertex_arrays))
+	{
+		glBindVertexArray(vao);
+		// The index buffer binding is part of VAO state.
+		cache.buffers[INDEX_BUFFER_SLOT] = UNKNOWN;
+	}
+}
+
+void vg::state::set_vertex_array_index_buffer(GLuint vao, GLuint buffer)
+{
+	if (cache.vao == vao)
+		cache.buffers[INDEX_BUFFER_SLOT] = buffer;
+	else if (cache.vao == UNKNOWN)
+		cache.buffers[INDEX_BUFFER_SLOT] = UNKNOWN;
+}
+
+void vg::state::active_texture(GLuint unit)
+{
+	if (update(cache.active_unit, unit, stats.active_texture))
+		glActiveTexture(GL_TEXTURE0 + unit);
+}
+
+void vg::state::bind_texture(GLenum target, GLuint texture)
+{
+	GLuint unit = cache.active_unit;
+	GLuint slot = texture_slot(target);
+	if (unit >= TEXTURE_UNIT_COUNT || slot == UNKNOWN)
+	{
+		++stats.textures.issued;
+		glBindTexture(target, texture);
+	}
+	else if (update(cache.textures[unit][slot], texture, stats.textures))
+	{
+		glBindTexture(target, texture);
+		cache.unit_textures[unit] = UNKNOWN;
+	}
+}
+
+GLuint vg::state::bound_texture(GLenum target)
+{
+	GLuint unit = cache.active_unit;
+	GLuint slot = texture_slot(target);
+	return unit >= TEXTURE_UNIT_COUNT || slot == UNKNOWN ? UNKNOWN : cache.textures[unit][slot];
+}
+
+void vg::state::bind_texture_unit(GLuint unit, GLuint texture)
+{
+	if (unit >= TEXTURE_UNIT_COUNT)
+	{
+		++stats.textures.issued;
+		glBindTextureUnit(unit, texture);
+	}
+	else if (cache.unit_textures[unit] == texture)
+		++stats.textures.skipped;
+	else
+	{
+		++stats.textures.issued;
+		glBindTextureUnit(unit, texture);
+		set_unit_from_unit_bind(unit, texture);
+	}
+}
+
+void vg::state::bind_texture_units(GLuint first_unit, GLuint count, const GLuint* textures)
+{
+	bool redundant = first_unit + count <= TEXTURE_UNIT_COUNT;
+	for (GLuint i = 0; redundant && i < count; ++i)
+		redundant = cache.unit_textures[first_unit + i] == (textures ? textures[i] : 0);
+	if (redundant)
+	{
+		++stats.textures.skipped;
+		return;
+	}
+
+	++stats.textures.issued;
+	glBindTextures(first_unit, count, textures);
+	for (GLuint i = 0; i < count && first_unit + i < TEXTURE_UNIT_COUNT; ++i)
+		set_unit_from_unit_bind(first_unit + i, textures ? textures[i] : 0);
+}
+
+void vg::state::bind_framebuffer(GLenum target, GLuint framebuffer)
+{
+	if (target == GL_DRAW_FRAMEBUFFER)
+	{
+		if (update(cache.draw_framebuffer, framebuffer, stats.framebuffers))
+			glBindFramebuffer(target, framebuffer);
+	}
+	else if (target == GL_READ_FRAMEBUFFER)
+	{
+		if (update(cache.read_framebuffer, framebuffer, stats.framebuffers))
+			glBindFramebuffer(target, framebuffer);
+	}
+	else if (cache.draw_framebuffer == framebuffer && cache.read_framebuffer == framebuffer)
+		++stats.framebuffers.skipped;
+	else
+	{
+		++stats.framebuffers.issued;
+		glBindFramebuffer(target, framebuffer);
+		cache.draw_framebuffer = framebuffer;
+		cache.read_framebuffer = framebuffer;
+	}
+}
+
+void vg::state::use_program(GLuint program)
+{
+	if (update(cache.program, program, stats.programs))
+		glUseProgram(program);
+}
+
+GLuint vg::state::bound_program()
+{
+	return cache.program;
+}
+
+void vg::state::set_bound_program(GLuint program)
+{
+	cache.program = program;
+}
+
+void vg::state::forget_buffers(const GLuint* buffers, GLuint count)
+{
+	for (GLuint i = 0; i < count; ++i)
+	{
+		if (buffers[i] == 0)
+			continue;
+		for (GLuint& bound : cache.buffers)
+			if (bound == buffers[i])
+				bound = 0;
+	}
+}
+
+void vg::state::forget_vertex_arrays(const GLuint* vaos, GLuint count)
+{
+	for (GLuint i = 0; i < count; ++i)
+	{
+		if (vaos[i] != 0 && cache.vao == vaos[i])
+		{
+			// Deleting the bound VAO reverts to VAO 0, whose index buffer binding is not tracked.
+			cache.vao = 0;
+			cache.buffers[INDEX_BUFFER_SLOT] = UNKNOWN;
+		}
+	}
+}
+
+void vg::state::forget_textures(const GLuint* textures, GLuint count)
+{
+	for (GLuint i = 0; i < count; ++i)
+	{
+		if (textures[i] == 0)
+			continue;
+		for (GLuint unit = 0; unit < TEXTURE_UNIT_COUNT; ++unit)
+		{
+			for (GLuint& bound : cache.textures[unit])
+				if (bound == textures[i])
+					bound = 0;
+			if (cache.unit_textures[unit] == textures[i])
+				cache.unit_textures[unit] = UNKNOWN;
+		}
+	}
+}
+
+void vg::state::forget_framebuffers(const GLuint* framebuffers, GLuint count)
+{
+	for (GLuint i = 0; i < count; ++i)
+	{
+		if (framebuffers[i] == 0)
+			continue;
+		if (cache.draw_framebuffer == framebuffers[i])
+			cache.draw_framebuffer = 0;
+		if (cache.read_framebuffer == framebuffers[i])
+			cache.read_framebuffer = 0;
+	}
+}
+
+void vg::state::forget_program(GLuint program)
+{
+	if (program != 0 && cache.program == program)
+		cache.program = UNKNOWN;
+}
+
+void vg::state::invalidate()
+{
+	for (GLuint& bound : cache.buffers)
+		bound = UNKNOWN;
+	cache.vao = UNKNOWN;
+	cache.active_unit = UNKNOWN;
+	for (GLuint unit = 0; unit < TEXTURE_UNIT_COUNT; ++unit)
+	{
+		for (GLuint& bound : cache.textures[unit])
+			bound = UNKNOWN;
+		cache.unit_textures[unit] = UNKNOWN;
+	}
+	cache.draw_framebuffer = UNKNOWN;
+	cache.read_framebuffer = UNKNOWN;
+	cache.program = UNKNOWN;
+}
+
+const vg::state::Counters& vg::state::counters()
+{
+	return stats;
+}
+
+void vg::state::reset_counters()
+{
+	stats = {};
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "Vendor.h"
+
+namespace vg
+{
+	// state mirrors the binding points of the current context, so that binding an object that is already bound costs no GL call. Every bind in Vanguard goes through it.
+	// Call invalidate() after binding objects with raw GL calls, or after switching contexts, so that the next bind of each point is issued unconditionally.
+	namespace state
+	{
+		struct Counter
+		{
+			GLuint issued = 0;
+			GLuint skipped = 0;
+		};
+
+		struct Counters
+		{
+			Counter buffers;
+			Counter vertex_arrays;
+			Counter active_texture;
+			Counter textures;
+			Counter framebuffers;
+			Counter programs;
+
+			GLuint issued() const { return buffers.issued + vertex_arrays.issued + active_texture.issued + textures.issued + framebuffers.issued + programs.issued; }
+			GLuint skipped() const { return buffers.skipped + vertex_arrays.skipped + active_texture.skipped + textures.skipped + framebuffers.skipped + programs.skipped; }
+		};
+
+		extern void bind_buffer(GLenum target, GLuint buffer);
+		// The buffer the cache holds as bound to target, or GLuint(-1) if it is not known.
+		extern GLuint bound_buffer(GLenum target);
+		extern void bind_vertex_array(GLuint vao);
+		// Records a DSA index buffer change on vao so the cached INDEX binding stays right when vao is bound.
+		extern void set_vertex_array_index_buffer(GLuint vao, GLuint buffer);
+		extern void active_texture(GLuint unit);
+		extern void bind_texture(GLenum target, GLuint texture);
+		// The texture the cache holds as bound to target on the active unit, or GLuint(-1) if it is not known.
+		extern GLuint bound_texture(GLenum target);
+		extern void bind_texture_unit(GLuint unit, GLuint texture);
+		extern void bind_texture_units(GLuint first_unit, GLuint count, const GLuint* textures);
+		extern void bind_framebuffer(GLenum target, GLuint framebuffer);
+		extern void use_program(GLuint program);
+		extern GLuint bound_program();
+		extern void set_bound_program(GLuint program);
+
+		// GL implicitly unbinds deleted objects from the current context, so the raii destructors report deletions here to keep the cache in step.
+		extern void forget_buffers(const GLuint* buffers, GLuint count);
+		extern void forget_vertex_arrays(const GLuint* vaos, GLuint count);
+		extern void forget_textures(const GLuint* textures, GLuint count);
+		extern void forget_framebuffers(const GLuint* framebuffers, GLuint count);
+		extern void forget_program(GLuint program);
+
+		extern void invalidate();
+		extern const Counters& counters();
+		extern void reset_counters();
+	}
+}
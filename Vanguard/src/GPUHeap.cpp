@@ -0,0 +1,168 @@
+#include "GPUHeap.h"
+
+#include <algorithm>
+
+#include "Errors.h"
+
+vg::GPUHeap::GPUHeap(BufferTarget target, GLuint unit_bytes, GLuint capacity)
+	: _target(target), _unit_bytes(unit_bytes), _capacity(capacity)
+{
+	buffers::set_category(_b, buffers::target_category(target));
+	buffers::init_immutable(_b, (GLsizeiptr)_capacity * _unit_bytes);
+	if (_capacity > 0)
+		_free_blocks[0] = _capacity;
+}
+
+void vg::GPUHeap::bind() const
+{
+	buffers::bind(_b, _target);
+}
+
+const vg::GPUHeap::Allocation& vg::GPUHeap::allocation(Handle handle) const
+{
+	if (!is_valid(handle))
+		throw block_index_out_of_range(_allocations.size(), handle);
+	return _allocations[handle];
+}
+
+vg::GPUHeap::Stats vg::GPUHeap::stats() const
+{
+	Stats stats;
+	stats.capacity = _capacity;
+	stats.used = _used;
+	stats.free = _capacity - _used;
+	stats.free_block_count = (GLuint)_free_blocks.size();
+	stats.allocation_count = (GLuint)(_allocations.size() - _free_handles.size());
+	for (const auto& [offset, count] : _free_blocks)
+		stats.largest_free_block = std::max(stats.largest_free_block, count);
+	return stats;
+}
+
+vg::GPUHeap::Handle vg::GPUHeap::allocate(GLuint count)
+{
+	if (count == 0)
+		throw Error(ErrorCode::HEAP_ALLOCATION, "cannot allocate 0 units");
+
+	// Best fit, so that small allocations do not split up the large blocks that big meshes need.
+	auto best = _free_blocks.end();
+	for (auto it = _free_blocks.begin(); it != _free_blocks.end(); ++it)
+	{
+		if (it->second >= count && (best == _free_blocks.end() || it->second < best->second))
+		{
+			best = it;
+			if (best->second == count)
+				break;
+		}
+	}
+	if (best == _free_blocks.end())
+		throw Error(ErrorCode::HEAP_ALLOCATION, "no free block of " + std::to_string(count) + " units (" + std::to_string(_capacity - _used) + " free in "
+			+ std::to_string(_free_blocks.size()) + " blocks)");
+
+	Allocation alloc{ best->first, count };
+	GLuint remaining = best->second - count;
+	_free_blocks.erase(best);
+	if (remaining > 0)
+		_free_blocks[alloc.offset + count] = remaining;
+	_used += count;
+
+	Handle handle;
+	if (_free_handles.empty())
+	{
+		handle = (Handle)_allocations.size();
+		_allocations.push_back(alloc);
+	}
+	else
+	{
+		handle = _free_handles.back();
+		_free_handles.pop_back();
+		_allocations[handle] = alloc;
+	}
+	return handle;
+}
+
+void vg::GPUHeap::free(Handle handle)
+{
+	Allocation alloc = allocation(handle);
+	release_block(alloc.offset, alloc.count);
+	_used -= alloc.count;
+	_allocations[handle] = {};
+	_free_handles.push_back(handle);
+}
+
+void vg::GPUHeap::release_block(GLuint offset, GLuint count)
+{
+	auto next = _free_blocks.lower_bound(offset);
+	if (next != _free_blocks.begin())
+	{
+		auto prev = std::prev(next);
+		if (prev->first + prev->second == offset)
+		{
+			offset = prev->first;
+			count += prev->second;
+			_free_blocks.erase(prev);
+		}
+	}
+	if (next != _free_blocks.end() && offset + count == next->first)
+	{
+		count += next->second;
+		_free_blocks.erase(next);
+	}
+	_free_blocks[offset] = count;
+}
+
+void vg::GPUHeap::write(Handle handle, const void* data) const
+{
+	const Allocation& alloc = allocation(handle);
+	buffers::subsend(_b, (GLintptr)alloc.offset * _unit_bytes, (GLsizeiptr)alloc.count * _unit_bytes, data);
+}
+
+void vg::GPUHeap::write(Handle handle, GLuint first, GLuint count, const void* data) const
+{
+	const Allocation& alloc = allocation(handle);
+	if (first + count > alloc.count)
+		throw offset_out_of_range(alloc.count, first, count);
+	buffers::subsend(_b, ((GLintptr)alloc.offset + first) * _unit_bytes, (GLsizeiptr)count * _unit_bytes, data);
+}
+
+void vg::GPUHeap::defragment()
+{
+	if (_free_blocks.empty() || (_free_blocks.size() == 1 && _free_blocks.begin()->first == _used))
+		return;
+
+	std::vector<Handle> live;
+	live.reserve(_allocations.size() - _free_handles.size());
+	for (Handle handle = 0; handle < _allocations.size(); ++handle)
+		if (_allocations[handle].count > 0)
+			live.push_back(handle);
+	std::sort(live.begin(), live.end(), [this](Handle a, Handle b) { return _allocations[a].offset < _allocations[b].offset; });
+
+	// Allocations before the first hole are already packed and stay where they are.
+	GLuint packed = 0;
+	size_t first_moved = 0;
+	while (first_moved < live.size() && _allocations[live[first_moved]].offset == packed)
+		packed += _allocations[live[first_moved++]].count;
+
+	// glCopyBufferSubData does not allow overlapping ranges within one buffer, so the moved allocations are packed into a scratch buffer and copied back in one go.
+	// Copying back into the same buffer object keeps any VAO or index binding that refers to it valid.
+	GLuint moved = _used - packed;
+	if (moved > 0)
+	{
+		raii::GLBuffer scratch;
+		buffers::set_category(scratch, MemoryCategory::STAGING_BUFFER);
+		buffers::init_immutable(scratch, (GLsizeiptr)moved * _unit_bytes, nullptr, 0);
+
+		GLuint cursor = 0;
+		for (size_t i = first_moved; i < live.size(); ++i)
+		{
+			Allocation& alloc = _allocations[live[i]];
+			buffers::copy_gl_buffer(_b, scratch, (GLintptr)alloc.offset * _unit_bytes, (GLintptr)cursor * _unit_bytes, (GLsizeiptr)alloc.count * _unit_bytes);
+			alloc.offset = packed + cursor;
+			cursor += alloc.count;
+		}
+		buffers::copy_gl_buffer(scratch, _b, 0, (GLintptr)packed * _unit_bytes, (GLsizeiptr)moved * _unit_bytes);
+	}
+
+	_free_blocks.clear();
+	if (_used < _capacity)
+		_free_blocks[_used] = _capacity - _used;
+}
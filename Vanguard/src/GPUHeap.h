@@ -0,0 +1,78 @@
+#pragma once
+
+#include <map>
+#include <vector>
+
+#include "Vanguard.h"
+#include "raii/GLBuffer.h"
+
+namespace vg
+{
+	// GPUHeap reserves one immutable GL buffer and sub-allocates it in whole units (a vertex stride for vertex data, an index size for index data), so every allocation is unit-aligned
+	// and its offset() can be passed directly as a base vertex or first index. Allocations are referred to by handle, because defragment() compacts the heap and moves their offsets.
+	class GPUHeap
+	{
+	public:
+		typedef GLuint Handle;
+
+		struct Allocation
+		{
+			GLuint offset = 0;
+			GLuint count = 0;
+		};
+
+		struct Stats
+		{
+			GLuint capacity = 0;
+			GLuint used = 0;
+			GLuint free = 0;
+			GLuint largest_free_block = 0;
+			GLuint free_block_count = 0;
+			GLuint allocation_count = 0;
+
+			// 0 when all free space is contiguous, approaching 1 as it is split into many small blocks.
+			float fragmentation() const { return free == 0 ? 0.0f : 1.0f - (float)largest_free_block / free; }
+			float occupancy() const { return capacity == 0 ? 0.0f : (float)used / capacity; }
+		};
+
+	private:
+		raii::GLBuffer _b;
+		BufferTarget _target;
+		GLuint _unit_bytes;
+		GLuint _capacity;
+		GLuint _used = 0;
+		std::map<GLuint, GLuint> _free_blocks;
+		std::vector<Allocation> _allocations;
+		std::vector<Handle> _free_handles;
+
+		const Allocation& allocation(Handle handle) const;
+		void release_block(GLuint offset, GLuint count);
+
+	public:
+		GPUHeap(BufferTarget target, GLuint unit_bytes, GLuint capacity);
+		GPUHeap(const GPUHeap&) = delete;
+		GPUHeap(GPUHeap&&) noexcept = default;
+		GPUHeap& operator=(GPUHeap&&) noexcept = default;
+
+		ids::GLBuffer buffer() const { return _b; }
+		BufferTarget target() const { return _target; }
+		void bind() const;
+
+		GLuint unit_bytes() const { return _unit_bytes; }
+		GLuint capacity() const { return _capacity; }
+		Stats stats() const;
+
+		Handle allocate(GLuint count);
+		void free(Handle handle);
+		bool is_valid(Handle handle) const { return handle < _allocations.size() && _allocations[handle].count > 0; }
+
+		GLuint offset(Handle handle) const { return allocation(handle).offset; }
+		GLuint count(Handle handle) const { return allocation(handle).count; }
+		GLintptr offset_bytes(Handle handle) const { return (GLintptr)allocation(handle).offset * _unit_bytes; }
+
+		void write(Handle handle, const void* data) const;
+		void write(Handle handle, GLuint first, GLuint count, const void* data) const;
+
+		void defragment();
+	};
+}
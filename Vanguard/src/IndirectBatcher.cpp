@@ -0,0 +1,114 @@
+#include "IndirectBatcher.h"
+
+#include <algorithm>
+#include <functional>
+
+vg::IndirectBatcher::IndirectBatcher(GLuint initial_capacity)
+{
+	if (initial_capacity > 0)
+		_block = std::make_unique<GPUIndirectElementsBlock>(initial_capacity);
+}
+
+vg::IndirectBatcher::Batch& vg::IndirectBatcher::batch(const Shader& shader, ids::VertexArray vao, const VertexBuffer* vertex_buffer, DrawMode mode, IndexDataType idt)
+{
+	auto matches = [&](const Batch& b) { return b.shader == &shader && b.vao == vao && b.vertex_buffer == vertex_buffer && b.mode == mode && b.idt == idt; };
+	// Consecutive draws usually go into the same batch, so check the last one first.
+	if (_last_batch < _batches.size() && matches(_batches[_last_batch]))
+		return _batches[_last_batch];
+	for (GLuint i = 0; i < _batches.size(); ++i)
+	{
+		if (matches(_batches[i]))
+		{
+			_last_batch = i;
+			return _batches[i];
+		}
+	}
+	_last_batch = (GLuint)_batches.size();
+	return _batches.emplace_back(Batch{ &shader, vao, vertex_buffer, mode, idt, {} });
+}
+
+void vg::IndirectBatcher::reserve_block(GLuint count)
+{
+	GLuint current = capacity();
+	if (count > current)
+		_block = std::make_unique<GPUIndirectElementsBlock>(std::max(count, 2 * current));
+}
+
+void vg::IndirectBatcher::add(const Shader& shader, ids::VertexArray vao, const VertexBuffer* vertex_buffer, DrawMode mode, IndexDataType idt, const IndirectElementsCmd& cmd)
+{
+	Batch& b = batch(shader, vao, vertex_buffer, mode, idt);
+	if (b.cmds.empty())
+		++_active_batches;
+	b.cmds.push_back(cmd);
+	++_draw_count;
+}
+
+void vg::IndirectBatcher::add(const Shader& shader, ids::VertexArray vao, DrawMode mode, IndexDataType idt, const IndirectElementsCmd& cmd)
+{
+	add(shader, vao, nullptr, mode, idt, cmd);
+}
+
+void vg::IndirectBatcher::add(const Shader& shader, const VertexBuffer& vb, const CPUIndexBuffer& ib, DrawMode mode, GLuint base_vertex, GLuint instance_count, GLuint first_instance)
+{
+	add(shader, vb.vao(), &vb, mode, ib.data_type(), IndirectElementsCmd{ (GLuint)ib.size(), instance_count, 0, base_vertex, first_instance });
+}
+
+void vg::IndirectBatcher::add(const Shader& shader, const MeshHeap& heap, MeshHeap::Mesh mesh, DrawMode mode, GLuint instance_count, GLuint first_instance)
+{
+	add(shader, heap.vao(), mode, heap.data_type(), IndirectElementsCmd{ heap.index_count(mesh), instance_count, heap.first_index(mesh), (GLuint)heap.base_vertex(mesh), first_instance });
+}
+
+void vg::IndirectBatcher::flush()
+{
+	if (_draw_count == 0)
+		return;
+
+	_order.clear();
+	for (GLuint i = 0; i < _batches.size(); ++i)
+		if (!_batches[i].cmds.empty())
+			_order.push_back(i);
+	std::sort(_order.begin(), _order.end(), [this](GLuint a, GLuint b) {
+		const Batch& ba = _batches[a];
+		const Batch& bb = _batches[b];
+		if (ba.shader != bb.shader)
+			return (GLuint)*ba.shader < (GLuint)*bb.shader;
+		if (ba.vao != bb.vao)
+			return (GLuint)ba.vao < (GLuint)bb.vao;
+		return std::less<const VertexBuffer*>{}(ba.vertex_buffer, bb.vertex_buffer);
+		});
+
+	_staging.clear();
+	_staging.reserve(_draw_count);
+	for (GLuint i : _order)
+		_staging.insert(_staging.end(), _batches[i].cmds.begin(), _batches[i].cmds.end());
+
+	reserve_block(_draw_count);
+	_block->bind();
+	_block->send_cmds(0, _draw_count, _staging.data());
+
+	GLuint first = 0;
+	for (GLuint i : _order)
+	{
+		const Batch& b = _batches[i];
+		GLuint count = (GLuint)b.cmds.size();
+		bind_shader(*b.shader);
+		if (b.vertex_buffer)
+			b.vertex_buffer->bind_vao();
+		else
+			bind_vertex_array(b.vao);
+		draw::multi_indirect(*_block, b.mode, first, count, b.idt);
+		first += count;
+	}
+	clear();
+}
+
+void vg::IndirectBatcher::clear()
+{
+	// Batches that received no draws since the last clear are dropped, the rest keep their command storage for the next frame.
+	std::erase_if(_batches, [](const Batch& b) { return b.cmds.empty(); });
+	for (Batch& b : _batches)
+		b.cmds.clear();
+	_active_batches = 0;
+	_last_batch = 0;
+	_draw_count = 0;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "Draw.h"
+
+namespace vg
+{
+	// IndirectBatcher collects indexed draws during a frame and groups those that share a shader, VAO, draw mode and index type. flush() uploads every group's IndirectElementsCmds
+	// into one GPUIndirectElementsBlock with a single glBufferSubData, then issues one glMultiDrawElementsIndirect per group. Groups are drawn sorted by shader and then VAO to keep state changes down.
+	// Draws of a VertexBuffer are also grouped by buffer, since buffers of one layout share a VAO. Consecutive groups on the same VAO then only swap buffer bindings.
+	class IndirectBatcher
+	{
+		struct Batch
+		{
+			const Shader* shader;
+			ids::VertexArray vao;
+			const VertexBuffer* vertex_buffer;
+			DrawMode mode;
+			IndexDataType idt;
+			std::vector<IndirectElementsCmd> cmds;
+		};
+
+		std::vector<Batch> _batches;
+		GLuint _active_batches = 0;
+		GLuint _last_batch = 0;
+		std::vector<GLuint> _order;
+		std::vector<IndirectElementsCmd> _staging;
+		std::unique_ptr<GPUIndirectElementsBlock> _block;
+		GLuint _draw_count = 0;
+
+		Batch& batch(const Shader& shader, ids::VertexArray vao, const VertexBuffer* vertex_buffer, DrawMode mode, IndexDataType idt);
+		void add(const Shader& shader, ids::VertexArray vao, const VertexBuffer* vertex_buffer, DrawMode mode, IndexDataType idt, const IndirectElementsCmd& cmd);
+		void reserve_block(GLuint count);
+
+	public:
+		IndirectBatcher(GLuint initial_capacity = 256);
+		IndirectBatcher(const IndirectBatcher&) = delete;
+		IndirectBatcher(IndirectBatcher&&) noexcept = default;
+		IndirectBatcher& operator=(IndirectBatcher&&) noexcept = default;
+
+		// vao must keep its own buffers attached, like a MeshHeap's. A VertexBuffer's VAO is shared by its layout, so add those by buffer.
+		void add(const Shader& shader, ids::VertexArray vao, DrawMode mode, IndexDataType idt, const IndirectElementsCmd& cmd);
+		void add(const Shader& shader, const VertexBuffer& vb, const CPUIndexBuffer& ib, DrawMode mode, GLuint base_vertex = 0, GLuint instance_count = 1, GLuint first_instance = 0);
+		void add(const Shader& shader, const MeshHeap& heap, MeshHeap::Mesh mesh, DrawMode mode, GLuint instance_count = 1, GLuint first_instance = 0);
+
+		GLuint draw_count() const { return _draw_count; }
+		GLuint batch_count() const { return _active_batches; }
+		GLuint capacity() const { return _block ? _block->get_count() : 0; }
+
+		void flush();
+		void clear();
+	};
+}
@@ -0,0 +1,247 @@
+#include "Memory.h"
+
+#include <algorithm>
+#include <mutex>
+
+size_t vg::MemorySnapshot::gpu_bytes() const
+{
+	size_t bytes = 0;
+	for (size_t i = 0; i < MEMORY_CATEGORY_COUNT; ++i)
+		if (MemoryCategory(i) != MemoryCategory::CPU)
+			bytes += categories[i].bytes;
+	return bytes;
+}
+
+struct MemoryBudget
+{
+	size_t budget = 0;
+	vg::memory::BudgetCallback callback;
+	bool exceeded = false;
+};
+
+struct MemoryTracker
+{
+	std::mutex mutex;
+	vg::MemorySnapshot usage;
+	size_t gpu_bytes = 0;
+	MemoryBudget budgets[vg::MEMORY_CATEGORY_COUNT];
+	MemoryBudget gpu_budget;
+};
+
+// Never destroyed, so that VoidArrays destroyed during static destruction can still release their bytes.
+static MemoryTracker& tracker()
+{
+	static MemoryTracker* instance = new MemoryTracker();
+	return *instance;
+}
+
+// Budget callbacks are collected under the lock and called after it is released, so that a callback may free or allocate memory itself.
+struct BudgetNotifications
+{
+	struct Notification
+	{
+		vg::memory::BudgetCallback callback;
+		size_t bytes = 0;
+		size_t budget = 0;
+	};
+
+	// recategorize() checks two categories and the GPU total.
+	Notification notifications[3];
+	int count = 0;
+
+	void check(MemoryBudget& budget, size_t bytes)
+	{
+		if (!budget.callback)
+			return;
+		if (bytes <= budget.budget)
+			budget.exceeded = false;
+		else if (!budget.exceeded)
+		{
+			budget.exceeded = true;
+			notifications[count++] = { budget.callback, bytes, budget.budget };
+		}
+	}
+
+	void send() const
+	{
+		for (int i = 0; i < count; ++i)
+			notifications[i].callback(notifications[i].bytes, notifications[i].budget);
+	}
+};
+
+static void add(MemoryTracker& t, vg::MemoryCategory category, size_t bytes, BudgetNotifications& notifications)
+{
+	vg::MemoryUsage& usage = t.usage.categories[size_t(category)];
+	usage.bytes += bytes;
+	usage.peak_bytes = std::max(usage.peak_bytes, usage.bytes);
+	++usage.allocations;
+	usage.frame_allocated += bytes;
+	notifications.check(t.budgets[size_t(category)], usage.bytes);
+	if (category != vg::MemoryCategory::CPU)
+	{
+		t.gpu_bytes += bytes;
+		notifications.check(t.gpu_budget, t.gpu_bytes);
+	}
+}
+
+static void remove(MemoryTracker& t, vg::MemoryCategory category, size_t bytes, BudgetNotifications& notifications)
+{
+	vg::MemoryUsage& usage = t.usage.categories[size_t(category)];
+	usage.bytes -= std::min(bytes, usage.bytes);
+	if (usage.allocations > 0)
+		--usage.allocations;
+	usage.frame_released += bytes;
+	notifications.check(t.budgets[size_t(category)], usage.bytes);
+	if (category != vg::MemoryCategory::CPU)
+	{
+		t.gpu_bytes -= std::min(bytes, t.gpu_bytes);
+		notifications.check(t.gpu_budget, t.gpu_bytes);
+	}
+}
+
+void vg::memory::allocate(MemoryCategory category, size_t bytes)
+{
+	MemoryTracker& t = tracker();
+	BudgetNotifications notifications;
+	{
+		std::lock_guard<std::mutex> lock(t.mutex);
+		add(t, category, bytes, notifications);
+	}
+	notifications.send();
+}
+
+void vg::memory::release(MemoryCategory category, size_t bytes)
+{
+	MemoryTracker& t = tracker();
+	BudgetNotifications notifications;
+	{
+		std::lock_guard<std::mutex> lock(t.mutex);
+		remove(t, category, bytes, notifications);
+	}
+	notifications.send();
+}
+
+void vg::memory::recategorize(MemoryCategory from, MemoryCategory to, size_t bytes)
+{
+	if (from == to)
+		return;
+	MemoryTracker& t = tracker();
+	BudgetNotifications notifications;
+	{
+		std::lock_guard<std::mutex> lock(t.mutex);
+		MemoryUsage& src = t.usage.categories[size_t(from)];
+		MemoryUsage& dst = t.usage.categories[size_t(to)];
+		src.bytes -= std::min(bytes, src.bytes);
+		if (src.allocations > 0)
+			--src.allocations;
+		dst.bytes += bytes;
+		dst.peak_bytes = std::max(dst.peak_bytes, dst.bytes);
+		++dst.allocations;
+		notifications.check(t.budgets[size_t(from)], src.bytes);
+		notifications.check(t.budgets[size_t(to)], dst.bytes);
+		if (from == MemoryCategory::CPU)
+			t.gpu_bytes += bytes;
+		else if (to == MemoryCategory::CPU)
+			t.gpu_bytes -= std::min(bytes, t.gpu_bytes);
+		if (from == MemoryCategory::CPU || to == MemoryCategory::CPU)
+			notifications.check(t.gpu_budget, t.gpu_bytes);
+	}
+	notifications.send();
+}
+
+static vg::TextureFormatUsage& format_usage(MemoryTracker& t, GLenum internal_format)
+{
+	for (vg::TextureFormatUsage& usage : t.usage.texture_formats)
+		if (usage.internal_format == internal_format)
+			return usage;
+	t.usage.texture_formats.push_back({ internal_format });
+	return t.usage.texture_formats.back();
+}
+
+void vg::memory::allocate_texture(GLenum internal_format, GLint level, size_t bytes)
+{
+	MemoryTracker& t = tracker();
+	BudgetNotifications notifications;
+	{
+		std::lock_guard<std::mutex> lock(t.mutex);
+		add(t, MemoryCategory::TEXTURE, bytes, notifications);
+		TextureFormatUsage& usage = format_usage(t, internal_format);
+		usage.bytes += bytes;
+		if (level > 0)
+			usage.mip_bytes += bytes;
+	}
+	notifications.send();
+}
+
+void vg::memory::release_texture(GLenum internal_format, GLint level, size_t bytes)
+{
+	MemoryTracker& t = tracker();
+	BudgetNotifications notifications;
+	{
+		std::lock_guard<std::mutex> lock(t.mutex);
+		remove(t, MemoryCategory::TEXTURE, bytes, notifications);
+		TextureFormatUsage& usage = format_usage(t, internal_format);
+		usage.bytes -= std::min(bytes, usage.bytes);
+		if (level > 0)
+			usage.mip_bytes -= std::min(bytes, usage.mip_bytes);
+	}
+	notifications.send();
+}
+
+vg::MemorySnapshot vg::memory::snapshot()
+{
+	MemoryTracker& t = tracker();
+	std::lock_guard<std::mutex> lock(t.mutex);
+	return t.usage;
+}
+
+vg::MemorySnapshot vg::memory::end_frame()
+{
+	MemoryTracker& t = tracker();
+	std::lock_guard<std::mutex> lock(t.mutex);
+	MemorySnapshot frame = t.usage;
+	for (MemoryUsage& usage : t.usage.categories)
+	{
+		usage.frame_allocated = 0;
+		usage.frame_released = 0;
+	}
+	return frame;
+}
+
+void vg::memory::set_budget(MemoryCategory category, size_t budget, BudgetCallback callback)
+{
+	MemoryTracker& t = tracker();
+	BudgetNotifications notifications;
+	{
+		std::lock_guard<std::mutex> lock(t.mutex);
+		t.budgets[size_t(category)] = { budget, std::move(callback) };
+		notifications.check(t.budgets[size_t(category)], t.usage.categories[size_t(category)].bytes);
+	}
+	notifications.send();
+}
+
+void vg::memory::clear_budget(MemoryCategory category)
+{
+	MemoryTracker& t = tracker();
+	std::lock_guard<std::mutex> lock(t.mutex);
+	t.budgets[size_t(category)] = {};
+}
+
+void vg::memory::set_gpu_budget(size_t budget, BudgetCallback callback)
+{
+	MemoryTracker& t = tracker();
+	BudgetNotifications notifications;
+	{
+		std::lock_guard<std::mutex> lock(t.mutex);
+		t.gpu_budget = { budget, std::move(callback) };
+		notifications.check(t.gpu_budget, t.gpu_bytes);
+	}
+	notifications.send();
+}
+
+void vg::memory::clear_gpu_budget()
+{
+	MemoryTracker& t = tracker();
+	std::lock_guard<std::mutex> lock(t.mutex);
+	t.gpu_budget = {};
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+#include "Vendor.h"
+
+namespace vg
+{
+	enum class MemoryCategory
+	{
+		VERTEX_BUFFER,
+		INDEX_BUFFER,
+		INDIRECT_BUFFER,
+		UNIFORM_BUFFER,
+		// Buffers that no wrapper tagged and whose storage was not specified through a typed target.
+		BUFFER,
+		// Scratch and readback buffers that only hold data in transit.
+		STAGING_BUFFER,
+		TEXTURE,
+		// Client memory held by VoidArray, which backs every CPU-side copy in Vanguard, Image2D included.
+		CPU
+	};
+
+	constexpr size_t MEMORY_CATEGORY_COUNT = size_t(MemoryCategory::CPU) + 1;
+
+	struct MemoryUsage
+	{
+		size_t bytes = 0;
+		size_t peak_bytes = 0;
+		size_t allocations = 0;
+		// Since the last memory::end_frame().
+		size_t frame_allocated = 0;
+		size_t frame_released = 0;
+
+		ptrdiff_t frame_delta() const { return ptrdiff_t(frame_allocated) - ptrdiff_t(frame_released); }
+	};
+
+	struct TextureFormatUsage
+	{
+		GLenum internal_format = 0;
+		size_t bytes = 0;
+		// The part of bytes held by mip levels above 0.
+		size_t mip_bytes = 0;
+	};
+
+	struct MemorySnapshot
+	{
+		MemoryUsage categories[MEMORY_CATEGORY_COUNT];
+		std::vector<TextureFormatUsage> texture_formats;
+
+		const MemoryUsage& operator[](MemoryCategory category) const { return categories[size_t(category)]; }
+		size_t gpu_bytes() const;
+		size_t cpu_bytes() const { return (*this)[MemoryCategory::CPU].bytes; }
+		size_t total_bytes() const { return gpu_bytes() + cpu_bytes(); }
+	};
+
+	// memory tallies the bytes Vanguard allocates, by category. GL buffers are counted through the buffers::init_* functions, texture images through the tex:: image functions
+	// on the texture bound to their target, and client memory through VoidArray. Storage specified with raw GL calls is not seen. GPU sizes are the sizes requested from GL,
+	// which the driver may pad. Counting is thread-safe, since VoidArray is used off the main thread.
+	namespace memory
+	{
+		// Called on the allocating thread, once when usage first exceeds the budget, and again only after it has dropped back to or below it.
+		using BudgetCallback = std::function<void(size_t bytes, size_t budget)>;
+
+		extern void allocate(MemoryCategory category, size_t bytes);
+		extern void release(MemoryCategory category, size_t bytes);
+		// Moves live bytes between categories without counting them as allocated or released this frame.
+		extern void recategorize(MemoryCategory from, MemoryCategory to, size_t bytes);
+		extern void allocate_texture(GLenum internal_format, GLint level, size_t bytes);
+		extern void release_texture(GLenum internal_format, GLint level, size_t bytes);
+
+		extern MemorySnapshot snapshot();
+		// Returns the snapshot of the frame that ends, then starts counting the next frame's allocations and releases from zero.
+		extern MemorySnapshot end_frame();
+
+		// Soft budgets only report: allocations over budget still succeed.
+		extern void set_budget(MemoryCategory category, size_t budget, BudgetCallback callback);
+		extern void clear_budget(MemoryCategory category);
+		// A budget on the sum of every GPU category.
+		extern void set_gpu_budget(size_t budget, BudgetCallback callback);
+		extern void clear_gpu_budget();
+	}
+}
@@ -0,0 +1,288 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <string_view>
+
+#include "Errors.h"
+
+static const GLuint NONE = GLuint(-1);
+
+static char* vertex_data(vg::VoidArray& vertices, GLuint vertex_count, size_t stride)
+{
+	if ((size_t)vertex_count * stride > vertices.size())
+		throw vg::offset_out_of_range(vertices.size(), 0, (size_t)vertex_count * stride);
+	return (char*)vertices.at(0);
+}
+
+std::vector<GLuint> vg::mesh::weld(const VertexBufferLayout& layout, VoidArray& vertices, GLuint& vertex_count)
+{
+	size_t stride = layout.stride();
+	char* data = vertex_data(vertices, vertex_count, stride);
+
+	// Open addressing at a load factor of at most 1/2. Each slot holds a welded vertex, whose hash is kept beside it so most probes skip the memcmp.
+	size_t slots = 1;
+	while (slots < 2 * (size_t)vertex_count)
+		slots <<= 1;
+	std::vector<GLuint> table(slots, NONE);
+	std::vector<size_t> hashes(vertex_count);
+
+	std::vector<GLuint> indices(vertex_count);
+	GLuint unique = 0;
+	for (GLuint v = 0; v < vertex_count; ++v)
+	{
+		const char* src = data + v * stride;
+		size_t h = std::hash<std::string_view>{}(std::string_view(src, stride));
+		for (size_t slot = h & (slots - 1);; slot = (slot + 1) & (slots - 1))
+		{
+			GLuint u = table[slot];
+			if (u == NONE)
+			{
+				// Unique vertices only ever move down, onto slots that earlier duplicates left free, so the source is never overwritten before it is read.
+				if (unique != v)
+					std::memcpy(data + unique * stride, src, stride);
+				table[slot] = unique;
+				hashes[unique] = h;
+				indices[v] = unique++;
+				break;
+			}
+			if (hashes[u] == h && std::memcmp(data + u * stride, src, stride) == 0)
+			{
+				indices[v] = u;
+				break;
+			}
+		}
+	}
+	vertex_count = unique;
+	vertices.resize((size_t)unique * stride);
+	return indices;
+}
+
+static void check_triangles(const std::vector<GLuint>& indices, GLuint vertex_count)
+{
+	if (indices.size() % 3 != 0)
+		throw vg::Error(vg::ErrorCode::INVALID_TRIANGLE_LIST, std::to_string(indices.size()) + " indices do not make whole triangles");
+	for (GLuint i : indices)
+		if (i >= vertex_count)
+			throw vg::Error(vg::ErrorCode::INVALID_TRIANGLE_LIST, "index " + std::to_string(i) + " out of range for " + std::to_string(vertex_count) + " vertices");
+}
+
+// Tom Forsyth's constants: the last triangle's vertices score flat, older cache entries decay with their position,
+// and vertices with few triangles left are boosted so that triangles aren't left stranded.
+static const float CACHE_DECAY_POWER = 1.5f;
+static const float LAST_TRIANGLE_SCORE = 0.75f;
+static const float VALENCE_BOOST_SCALE = 2.0f;
+static const float VALENCE_BOOST_POWER = 0.5f;
+
+static float vertex_score(int cache_position, GLuint remaining, GLuint cache_size)
+{
+	if (remaining == 0)
+		return -1.0f;
+	float score = 0.0f;
+	if (cache_position >= 0)
+	{
+		if (cache_position < 3)
+			score = LAST_TRIANGLE_SCORE;
+		else
+			score = std::pow(1.0f - float(cache_position - 3) / float(cache_size - 3), CACHE_DECAY_POWER);
+	}
+	return score + VALENCE_BOOST_SCALE * std::pow(float(remaining), -VALENCE_BOOST_POWER);
+}
+
+void vg::mesh::optimize_vertex_cache(std::vector<GLuint>& indices, GLuint vertex_count, GLuint cache_size)
+{
+	check_triangles(indices, vertex_count);
+	cache_size = std::max(cache_size, 4u);
+	GLuint triangle_count = GLuint(indices.size() / 3);
+	if (triangle_count == 0)
+		return;
+
+	// Each vertex's live triangles are the first remaining[v] entries of its adjacency list. Emitted triangles are swapped out past the end.
+	std::vector<GLuint> remaining(vertex_count, 0);
+	for (GLuint i : indices)
+		++remaining[i];
+	std::vector<GLuint> adjacency_offsets(vertex_count + 1, 0);
+	for (GLuint v = 0; v < vertex_count; ++v)
+		adjacency_offsets[v + 1] = adjacency_offsets[v] + remaining[v];
+	std::vector<GLuint> adjacency(indices.size());
+	{
+		std::vector<GLuint> filled(adjacency_offsets.begin(), adjacency_offsets.end() - 1);
+		for (GLuint t = 0; t < triangle_count; ++t)
+			for (GLuint k = 0; k < 3; ++k)
+				adjacency[filled[indices[3 * t + k]]++] = t;
+	}
+
+	std::vector<int> cache_positions(vertex_count, -1);
+	std::vector<float> vertex_scores(vertex_count);
+	for (GLuint v = 0; v < vertex_count; ++v)
+		vertex_scores[v] = vertex_score(-1, remaining[v], cache_size);
+	std::vector<float> triangle_scores(triangle_count);
+	GLuint best = 0;
+	for (GLuint t = 0; t < triangle_count; ++t)
+	{
+		triangle_scores[t] = vertex_scores[indices[3 * t]] + vertex_scores[indices[3 * t + 1]] + vertex_scores[indices[3 * t + 2]];
+		if (triangle_scores[t] > triangle_scores[best])
+			best = t;
+	}
+
+	std::vector<bool> emitted(triangle_count, false);
+	std::vector<GLuint> cache, next_cache;
+	cache.reserve(cache_size + 3);
+	next_cache.reserve(cache_size + 3);
+	std::vector<GLuint> reordered;
+	reordered.reserve(indices.size());
+	GLuint cursor = 0;
+
+	for (GLuint n = 0; n < triangle_count; ++n)
+	{
+		// No triangle in the cache is left, so restart from the first unemitted triangle in input order, rather than rescanning every triangle.
+		if (best == NONE)
+		{
+			while (emitted[cursor])
+				++cursor;
+			best = cursor;
+		}
+
+		const GLuint* tri = &indices[3 * best];
+		emitted[best] = true;
+		reordered.insert(reordered.end(), tri, tri + 3);
+
+		next_cache.assign(tri, tri + 3);
+		for (GLuint v : cache)
+			if (v != tri[0] && v != tri[1] && v != tri[2])
+				next_cache.push_back(v);
+		for (GLuint k = 0; k < 3; ++k)
+		{
+			GLuint v = tri[k];
+			GLuint* live = &adjacency[adjacency_offsets[v]];
+			GLuint* last = live + --remaining[v];
+			std::iter_swap(std::find(live, last + 1, best), last);
+		}
+
+		// Vertices pushed past the end of the cache still get rescored, as out of the cache.
+		for (GLuint i = 0; i < next_cache.size(); ++i)
+		{
+			GLuint v = next_cache[i];
+			cache_positions[v] = i < cache_size ? int(i) : -1;
+			vertex_scores[v] = vertex_score(cache_positions[v], remaining[v], cache_size);
+		}
+		best = NONE;
+		float best_score = -1.0f;
+		for (GLuint v : next_cache)
+		{
+			const GLuint* live = &adjacency[adjacency_offsets[v]];
+			for (GLuint j = 0; j < remaining[v]; ++j)
+			{
+				GLuint t = live[j];
+				triangle_scores[t] = vertex_scores[indices[3 * t]] + vertex_scores[indices[3 * t + 1]] + vertex_scores[indices[3 * t + 2]];
+				if (triangle_scores[t] > best_score)
+				{
+					best_score = triangle_scores[t];
+					best = t;
+				}
+			}
+		}
+		if (next_cache.size() > cache_size)
+			next_cache.resize(cache_size);
+		std::swap(cache, next_cache);
+	}
+	indices = std::move(reordered);
+}
+
+void vg::mesh::optimize_vertex_fetch(const VertexBufferLayout& layout, VoidArray& vertices, GLuint& vertex_count, std::vector<GLuint>& indices)
+{
+	check_triangles(indices, vertex_count);
+	size_t stride = layout.stride();
+	const char* data = vertex_data(vertices, vertex_count, stride);
+
+	std::vector<GLuint> remap(vertex_count, NONE);
+	GLuint used = 0;
+	for (GLuint& i : indices)
+	{
+		if (remap[i] == NONE)
+			remap[i] = used++;
+		i = remap[i];
+	}
+	if (used == 0)
+	{
+		vertex_count = 0;
+		vertices.resize(0);
+		return;
+	}
+
+	VoidArray reordered((size_t)used * stride);
+	char* dst = (char*)reordered.at(0);
+	for (GLuint v = 0; v < vertex_count; ++v)
+		if (remap[v] != NONE)
+			std::memcpy(dst + remap[v] * stride, data + v * stride, stride);
+	vertices = std::move(reordered);
+	vertex_count = used;
+}
+
+vg::IndexDataType vg::mesh::smallest_index_type(GLuint vertex_count)
+{
+	if (vertex_count <= 0x100)
+		return IndexDataType::UBYTE;
+	else if (vertex_count <= 0x10000)
+		return IndexDataType::USHORT;
+	else
+		return IndexDataType::UINT;
+}
+
+template<typename Index>
+static void narrow(const std::vector<GLuint>& indices, void* dst)
+{
+	Index* d = (Index*)dst;
+	for (size_t i = 0; i < indices.size(); ++i)
+		d[i] = Index(indices[i]);
+}
+
+void vg::mesh::write_indices(const std::vector<GLuint>& indices, CPUIndexBuffer& index_buffer)
+{
+	IndexDataType idt = index_buffer.data_type();
+	GLuint max_index = indices.empty() ? 0 : *std::max_element(indices.begin(), indices.end());
+	if (index_data_type_size(smallest_index_type(max_index + 1)) > index_data_type_size(idt))
+		throw Error(ErrorCode::INDEX_TYPE_OVERFLOW, "index " + std::to_string(max_index) + " does not fit index type " + std::to_string((int)idt));
+
+	VoidArray& cpubuf = index_buffer.buffer();
+	cpubuf.resize(indices.size() * index_data_type_size(idt));
+	if (indices.empty())
+		return;
+	if (idt == IndexDataType::UBYTE)
+		narrow<GLubyte>(indices, cpubuf);
+	else if (idt == IndexDataType::USHORT)
+		narrow<GLushort>(indices, cpubuf);
+	else if (idt == IndexDataType::UINT)
+		narrow<GLuint>(indices, cpubuf);
+}
+
+vg::CPUIndexBuffer vg::mesh::optimize(const VertexBufferLayout& layout, VoidArray& vertices, GLuint& vertex_count)
+{
+	std::vector<GLuint> indices = weld(layout, vertices, vertex_count);
+	optimize_vertex_cache(indices, vertex_count);
+	optimize_vertex_fetch(layout, vertices, vertex_count, indices);
+
+	CPUIndexBuffer index_buffer(smallest_index_type(vertex_count));
+	write_indices(indices, index_buffer);
+	// glBufferStorage rejects a size of 0.
+	if (!indices.empty())
+		index_buffer.init_immutable();
+	return index_buffer;
+}
+
+vg::CPUIndexBuffer vg::mesh::optimize(CPUVertexBuffer& vb)
+{
+	VoidArray vertices = vb.buffer().clone();
+	GLuint vertex_count = vb.vertex_count();
+	CPUIndexBuffer index_buffer = optimize(*vb.layout(), vertices, vertex_count);
+
+	vb.resize(vertex_count);
+	if (vertex_count > 0)
+	{
+		std::memcpy(vb.at(0), vertices, vertices.size());
+		vb.mark_dirty(0, vertices.size());
+		vb.flush();
+	}
+	return index_buffer;
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "Renderable.h"
+
+namespace vg
+{
+	// mesh turns unindexed triangle soups into compact indexed meshes for static geometry. The steps can be run alone, but run in the order of optimize():
+	// weld() merges byte-identical vertices, optimize_vertex_cache() reorders triangles so consecutive ones share recently transformed vertices (Forsyth's algorithm),
+	// and optimize_vertex_fetch() renumbers vertices in the order the triangles first use them, so vertex fetches walk the buffer forwards.
+	// Vertices are interleaved at the layout's stride, and indices are GLuints until they are written to a CPUIndexBuffer.
+	namespace mesh
+	{
+		// Merges vertices whose stride bytes are identical, compacting the unique ones to the front of vertices in first-seen order and shrinking vertex_count to match.
+		// Returns the triangle list: one index per input vertex, into the welded vertices.
+		extern std::vector<GLuint> weld(const VertexBufferLayout& layout, VoidArray& vertices, GLuint& vertex_count);
+		// Reorders the triangles of indices for a post-transform vertex cache of cache_size entries. Each triangle keeps its winding.
+		extern void optimize_vertex_cache(std::vector<GLuint>& indices, GLuint vertex_count, GLuint cache_size = 32);
+		// Renumbers vertices in order of first use in indices, moving them to match, and drops vertices that no triangle uses.
+		extern void optimize_vertex_fetch(const VertexBufferLayout& layout, VoidArray& vertices, GLuint& vertex_count, std::vector<GLuint>& indices);
+
+		// The narrowest index type that can address vertex_count vertices.
+		extern IndexDataType smallest_index_type(GLuint vertex_count);
+		// Narrows indices into the CPU copy of index_buffer, which is resized to fit. index_buffer's type must be able to address every index.
+		extern void write_indices(const std::vector<GLuint>& indices, CPUIndexBuffer& index_buffer);
+
+		// Runs every step on vertex_count soup vertices, and returns an index buffer of the smallest type, uploaded as immutable unless the mesh is empty.
+		extern CPUIndexBuffer optimize(const VertexBufferLayout& layout, VoidArray& vertices, GLuint& vertex_count);
+		// Optimizes the vertices of vb in place, shrinking it and flushing the changed vertices. Attach the returned buffer to vb to draw it.
+		extern CPUIndexBuffer optimize(CPUVertexBuffer& vb);
+	}
+}
@@ -0,0 +1,202 @@
+#include "ObjectPool.h"
+
+#include <algorithm>
+#include <bit>
+#include <limits>
+
+#include "Errors.h"
+
+// Buffer sizes are rounded up to a size class so that leases of slightly different sizes share buffers. Classes are a quarter of a power of two apart,
+// so a buffer holds at most 25% more than it was leased for, and below 2 KiB they are MIN_BUFFER_SIZE_CLASS apart.
+static const GLsizeiptr MIN_BUFFER_SIZE_CLASS = 256;
+
+static GLsizeiptr buffer_size_class(GLsizeiptr size)
+{
+	GLsizeiptr step = std::max(MIN_BUFFER_SIZE_CLASS, GLsizeiptr(std::bit_floor(size_t(std::max(size, GLsizeiptr(1))))) / 4);
+	return std::max(MIN_BUFFER_SIZE_CLASS, (size + step - 1) / step * step);
+}
+
+vg::GLObjectPool::GLObjectPool(double idle_seconds)
+	: _idle_seconds(idle_seconds)
+{
+}
+
+template<typename Object, typename Key>
+size_t vg::GLObjectPool::find_group(std::vector<Group<Object, Key>>& groups, const Key& key, size_t bytes)
+{
+	for (size_t i = 0; i < groups.size(); ++i)
+		if (groups[i].key == key)
+			return i;
+	groups.push_back({ key, bytes, {} });
+	return groups.size() - 1;
+}
+
+template<typename Object, typename Key>
+std::optional<Object> vg::GLObjectPool::take(std::vector<Group<Object, Key>>& groups, size_t group)
+{
+	auto& idle = groups[group].idle;
+	if (idle.empty())
+		return std::nullopt;
+	std::optional<Object> object(std::move(idle.back().object));
+	idle.pop_back();
+	++_stats.reused;
+	--_stats.idle;
+	_stats.idle_bytes -= groups[group].bytes;
+	return object;
+}
+
+template<typename Object, typename Key>
+void vg::GLObjectPool::collect(std::vector<Group<Object, Key>>& groups, double before)
+{
+	for (auto& group : groups)
+	{
+		auto expired = std::find_if(group.idle.begin(), group.idle.end(), [before](const Idle<Object>& idle) { return idle.released >= before; });
+		GLuint count = GLuint(expired - group.idle.begin());
+		group.idle.erase(group.idle.begin(), expired);
+		_stats.deleted += count;
+		_stats.idle -= count;
+		_stats.idle_bytes -= count * group.bytes;
+	}
+}
+
+vg::GLObjectPool::BufferLease vg::GLObjectPool::lease_buffer(const BufferKey& key)
+{
+	size_t group = find_group(_buffers, key, size_t(key.size_class));
+	if (auto buffer = take(_buffers, group))
+		return BufferLease(*this, std::move(*buffer), group, size_t(key.size_class));
+
+	raii::GLBuffer buffer;
+	buffers::set_category(buffer, buffers::target_category(key.target));
+	if (key.is_mutable)
+		buffers::init_mutable(buffer, key.size_class, nullptr, (BufferMutableUsage)key.usage);
+	else
+		buffers::init_immutable(buffer, key.size_class, nullptr, (int)key.usage);
+	++_stats.created;
+	return BufferLease(*this, std::move(buffer), group, size_t(key.size_class));
+}
+
+vg::GLObjectPool::BufferLease vg::GLObjectPool::buffer(BufferTarget target, GLsizeiptr size, int usage)
+{
+	return lease_buffer({ target, buffer_size_class(size), (GLenum)usage, false });
+}
+
+vg::GLObjectPool::BufferLease vg::GLObjectPool::mutable_buffer(BufferTarget target, GLsizeiptr size, BufferMutableUsage usage)
+{
+	return lease_buffer({ target, buffer_size_class(size), (GLenum)usage, true });
+}
+
+static size_t texture_bytes(vg::TextureTarget target, GLsizei width, GLsizei height, GLsizei depth, vg::CHPP chpp, GLint levels)
+{
+	size_t bytes = 0;
+	for (GLint level = 0; level < levels; ++level)
+	{
+		size_t w = std::max(1, width >> level);
+		size_t h = target == vg::TextureTarget::T1D ? 1 : std::max(1, height >> level);
+		size_t d = target == vg::TextureTarget::T3D ? std::max(1, depth >> level) : target == vg::TextureTarget::T2D_ARRAY ? depth : target == vg::TextureTarget::CUBE_MAP ? 6 : 1;
+		bytes += w * h * d * chpp;
+	}
+	return bytes;
+}
+
+// Specifies every level through tex::, which leaves the texture bound to its target on the active unit.
+static void init_texture_storage(vg::ids::Texture texture, vg::TextureTarget target, GLsizei width, GLsizei height, GLsizei depth, vg::CHPP chpp, GLint levels)
+{
+	vg::bind_texture(texture, target);
+	for (GLint level = 0; level < levels; ++level)
+	{
+		int w = std::max(1, width >> level);
+		int h = std::max(1, height >> level);
+		switch (target)
+		{
+		case vg::TextureTarget::T1D:
+			vg::tex::image_1d(w, chpp, nullptr, vg::tex::Target1D::T1D, vg::tex::DataType::UBYTE, 0, level);
+			break;
+		case vg::TextureTarget::T2D:
+			vg::tex::image_2d(w, h, chpp, nullptr, vg::tex::ImageTarget2D::T2D, vg::tex::DataType::UBYTE, 0, level);
+			break;
+		case vg::TextureTarget::CUBE_MAP:
+			for (GLenum face = GL_TEXTURE_CUBE_MAP_POSITIVE_X; face <= GL_TEXTURE_CUBE_MAP_NEGATIVE_Z; ++face)
+				vg::tex::image_2d(w, h, chpp, nullptr, (vg::tex::ImageTarget2D)face, vg::tex::DataType::UBYTE, 0, level);
+			break;
+		case vg::TextureTarget::T3D:
+			vg::tex::image_3d(w, h, std::max(1, depth >> level), chpp, nullptr, vg::tex::ImageTarget3D::T3D, vg::tex::DataType::UBYTE, 0, level);
+			break;
+		case vg::TextureTarget::T2D_ARRAY:
+			vg::tex::image_3d(w, h, depth, chpp, nullptr, vg::tex::ImageTarget3D::T2D_ARRAY, vg::tex::DataType::UBYTE, 0, level);
+			break;
+		default:
+			break;
+		}
+	}
+	// Without this the texture is incomplete, and samples as black, unless all 1000 default levels were allocated.
+	vg::texture_params::max_level((vg::texture_params::Target)target, levels - 1);
+}
+
+vg::GLObjectPool::TextureLease vg::GLObjectPool::texture(TextureTarget target, GLsizei width, GLsizei height, GLsizei depth, CHPP chpp, GLint levels)
+{
+	if (target != TextureTarget::T1D && target != TextureTarget::T2D && target != TextureTarget::T3D && target != TextureTarget::T2D_ARRAY && target != TextureTarget::CUBE_MAP)
+		throw Error(ErrorCode::UNSUPPORTED_TEXTURE_TARGET, "cannot pool textures of target " + std::to_string((GLenum)target));
+	TextureKey key{ target, width, height, depth, chpp, levels };
+	size_t bytes = texture_bytes(target, width, height, depth, chpp, levels);
+	size_t group = find_group(_textures, key, bytes);
+	if (auto texture = take(_textures, group))
+		return TextureLease(*this, std::move(*texture), group, bytes);
+
+	raii::Texture texture(target);
+	init_texture_storage(texture, target, width, height, depth, chpp, levels);
+	++_stats.created;
+	return TextureLease(*this, std::move(texture), group, bytes);
+}
+
+vg::GLObjectPool::FrameBufferLease vg::GLObjectPool::framebuffer()
+{
+	size_t group = find_group(_framebuffers, FrameBufferKey{}, 0);
+	if (auto framebuffer = take(_framebuffers, group))
+		return FrameBufferLease(*this, std::move(*framebuffer), group, 0);
+
+	raii::FrameBuffer framebuffer;
+	++_stats.created;
+	return FrameBufferLease(*this, std::move(framebuffer), group, 0);
+}
+
+void vg::GLObjectPool::give_back(raii::GLBuffer&& buffer, size_t group)
+{
+	_buffers[group].idle.push_back({ std::move(buffer), glfwGetTime() });
+	++_stats.idle;
+	_stats.idle_bytes += _buffers[group].bytes;
+}
+
+void vg::GLObjectPool::give_back(raii::Texture&& texture, size_t group)
+{
+	_textures[group].idle.push_back({ std::move(texture), glfwGetTime() });
+	++_stats.idle;
+	_stats.idle_bytes += _textures[group].bytes;
+}
+
+void vg::GLObjectPool::give_back(raii::FrameBuffer&& framebuffer, size_t group)
+{
+	_framebuffers[group].idle.push_back({ std::move(framebuffer), glfwGetTime() });
+	++_stats.idle;
+}
+
+void vg::GLObjectPool::collect()
+{
+	double before = glfwGetTime() - _idle_seconds;
+	collect(_buffers, before);
+	collect(_textures, before);
+	collect(_framebuffers, before);
+}
+
+void vg::GLObjectPool::clear()
+{
+	collect(_buffers, std::numeric_limits<double>::infinity());
+	collect(_textures, std::numeric_limits<double>::infinity());
+	collect(_framebuffers, std::numeric_limits<double>::infinity());
+}
+
+void vg::GLObjectPool::reset_stats()
+{
+	_stats.created = 0;
+	_stats.reused = 0;
+	_stats.deleted = 0;
+}
@@ -0,0 +1,175 @@
+#pragma once
+
+#include <optional>
+#include <vector>
+
+#include "Vanguard.h"
+#include "raii/GLBuffer.h"
+#include "raii/Texture.h"
+#include "raii/FrameBuffer.h"
+
+namespace vg
+{
+	// GLObjectPool recycles transient GL objects, such as per-frame scratch buffers and temporary render targets, instead of creating and deleting them every frame.
+	// Objects are leased: a Lease hands its object back to the pool when it is destroyed, and the pool keeps the object, grouped by target, size class and format,
+	// until collect() finds it idle for longer than the idle time. Recycled buffers and textures keep their storage, so leasing from a group that has idle objects costs
+	// no glGen*, glDelete* or storage allocation. A recycled object holds whatever its previous lease left: buffer and texture contents, texture parameters, and
+	// framebuffer attachments. Leases must not outlive their pool.
+	class GLObjectPool
+	{
+	public:
+		struct Stats
+		{
+			GLuint created = 0;
+			GLuint reused = 0;
+			GLuint deleted = 0;
+			GLuint idle = 0;
+			size_t idle_bytes = 0;
+
+			// The fraction of leases that did not create an object.
+			float reuse_rate() const { return created + reused == 0 ? 0.0f : (float)reused / (created + reused); }
+		};
+
+		template<typename Object, typename Id>
+		class Lease
+		{
+			friend class GLObjectPool;
+
+			GLObjectPool* _pool = nullptr;
+			std::optional<Object> _object;
+			size_t _group = 0;
+			size_t _bytes = 0;
+
+			Lease(GLObjectPool& pool, Object&& object, size_t group, size_t bytes)
+				: _pool(&pool), _object(std::move(object)), _group(group), _bytes(bytes)
+			{
+			}
+
+		public:
+			Lease() = default;
+			Lease(const Lease&) = delete;
+			Lease(Lease&& other) noexcept
+				: _pool(other._pool), _object(std::move(other._object)), _group(other._group), _bytes(other._bytes)
+			{
+				other._pool = nullptr;
+				other._object.reset();
+			}
+			Lease& operator=(Lease&& other) noexcept
+			{
+				if (this != &other)
+				{
+					release();
+					_pool = other._pool;
+					_object = std::move(other._object);
+					_group = other._group;
+					_bytes = other._bytes;
+					other._pool = nullptr;
+					other._object.reset();
+				}
+				return *this;
+			}
+			~Lease() { release(); }
+
+			bool valid() const { return _pool != nullptr; }
+			operator Id() const { return _object ? Id(*_object) : Id(0); }
+			// The bytes of storage the object holds, which for a buffer is its size class rather than the size it was leased for.
+			size_t bytes() const { return _bytes; }
+
+			void release()
+			{
+				if (_pool)
+				{
+					_pool->give_back(std::move(*_object), _group);
+					_pool = nullptr;
+					_object.reset();
+				}
+			}
+		};
+
+		using BufferLease = Lease<raii::GLBuffer, ids::GLBuffer>;
+		using TextureLease = Lease<raii::Texture, ids::Texture>;
+		using FrameBufferLease = Lease<raii::FrameBuffer, ids::FrameBuffer>;
+
+	private:
+		struct BufferKey
+		{
+			BufferTarget target;
+			GLsizeiptr size_class;
+			GLenum usage;
+			bool is_mutable;
+
+			bool operator==(const BufferKey&) const = default;
+		};
+
+		struct TextureKey
+		{
+			TextureTarget target;
+			GLsizei width;
+			GLsizei height;
+			GLsizei depth;
+			CHPP chpp;
+			GLint levels;
+
+			bool operator==(const TextureKey&) const = default;
+		};
+
+		template<typename Object>
+		struct Idle
+		{
+			Object object;
+			double released;
+		};
+
+		// Idle objects are kept in release order, so the most recently used is leased first and the longest idle are at the front for collect().
+		template<typename Object, typename Key>
+		struct Group
+		{
+			Key key;
+			size_t bytes;
+			std::vector<Idle<Object>> idle;
+		};
+
+		struct FrameBufferKey
+		{
+			bool operator==(const FrameBufferKey&) const = default;
+		};
+
+		std::vector<Group<raii::GLBuffer, BufferKey>> _buffers;
+		std::vector<Group<raii::Texture, TextureKey>> _textures;
+		std::vector<Group<raii::FrameBuffer, FrameBufferKey>> _framebuffers;
+		double _idle_seconds;
+		Stats _stats;
+
+		template<typename Object, typename Key>
+		static size_t find_group(std::vector<Group<Object, Key>>& groups, const Key& key, size_t bytes);
+		template<typename Object, typename Key>
+		std::optional<Object> take(std::vector<Group<Object, Key>>& groups, size_t group);
+		template<typename Object, typename Key>
+		void collect(std::vector<Group<Object, Key>>& groups, double before);
+
+		BufferLease lease_buffer(const BufferKey& key);
+		void give_back(raii::GLBuffer&& buffer, size_t group);
+		void give_back(raii::Texture&& texture, size_t group);
+		void give_back(raii::FrameBuffer&& framebuffer, size_t group);
+
+	public:
+		explicit GLObjectPool(double idle_seconds = 2.0);
+		GLObjectPool(const GLObjectPool&) = delete;
+
+		BufferLease buffer(BufferTarget target, GLsizeiptr size, int usage = BufferImmutableUsage::DYNAMIC_STORAGE);
+		BufferLease mutable_buffer(BufferTarget target, GLsizeiptr size, BufferMutableUsage usage = BufferMutableUsage::DYNAMIC_DRAW);
+		// Supports T1D, T2D, T3D, T2D_ARRAY and CUBE_MAP. depth is ignored by targets without one, and levels is the number of mip levels to allocate.
+		TextureLease texture(TextureTarget target, GLsizei width, GLsizei height, GLsizei depth, CHPP chpp, GLint levels = 1);
+		TextureLease texture_2d(GLsizei width, GLsizei height, CHPP chpp, GLint levels = 1) { return texture(TextureTarget::T2D, width, height, 1, chpp, levels); }
+		FrameBufferLease framebuffer();
+
+		double idle_time() const { return _idle_seconds; }
+		void set_idle_time(double seconds) { _idle_seconds = seconds; }
+		// Deletes the objects that have been idle for longer than the idle time. Call it once per frame.
+		void collect();
+		// Deletes every idle object.
+		void clear();
+		const Stats& stats() const { return _stats; }
+		void reset_stats();
+	};
+}
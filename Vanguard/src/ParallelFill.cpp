@@ -0,0 +1,113 @@
+#include "ParallelFill.h"
+
+#include <cstdint>
+#include <numeric>
+
+#include "Errors.h"
+
+static const size_t CACHE_LINE_BYTES = 64;
+// Below this, a chunk costs more to hand out than to fill.
+static const size_t MIN_CHUNK_BYTES = 16 * 1024;
+// Chunks per thread, so threads that finish early have chunks left to steal.
+static const GLuint CHUNKS_PER_THREAD = 4;
+
+void vg::parallel_fill(CPUVertexBuffer& vb, GLuint first, GLuint count, const VertexFillFunction& fn, FillUpload upload, ThreadPool& pool)
+{
+	if (first + count > vb.vertex_count())
+		throw offset_out_of_range(vb.vertex_count(), first, count);
+	if (count == 0)
+		return;
+
+	size_t stride = vb.layout()->stride();
+	// A multiple of align vertices is a whole number of cache lines.
+	GLuint align = GLuint(CACHE_LINE_BYTES / std::gcd(stride, CACHE_LINE_BYTES));
+	GLuint chunk = std::max(count / ((pool.thread_count() + 1) * CHUNKS_PER_THREAD), GLuint((MIN_CHUNK_BYTES + stride - 1) / stride));
+	chunk = (chunk + align - 1) / align * align;
+
+	char* vertices = (char*)vb.at(0);
+	// The CPU buffer is only as aligned as malloc makes it, so boundaries are counted from the first vertex that starts on a cache line rather than from vertex 0.
+	// Any later vertex a multiple of align past it starts on a line too. If no vertex does, boundaries stay at multiples of chunk, and each is shared by two chunks.
+	GLuint phase = 0;
+	for (GLuint v = 0; v < align; ++v)
+	{
+		if ((reinterpret_cast<uintptr_t>(vertices) + v * stride) % CACHE_LINE_BYTES == 0)
+		{
+			phase = v;
+			break;
+		}
+	}
+	// Boundaries are origin + k * chunk for k >= 0, so they stay on cache lines when first doesn't. origin is at or below 0, so that first is past it.
+	int64_t origin = int64_t(phase) - chunk;
+	int64_t first_chunk = (first - origin) / chunk;
+	unsigned chunk_count = unsigned((first + count - origin + chunk - 1) / chunk - first_chunk);
+
+	auto chunk_begin = [&](unsigned c) { return GLuint(std::max<int64_t>(first, origin + (first_chunk + c) * chunk)); };
+	auto chunk_end = [&](unsigned c) { return GLuint(std::min<int64_t>(first + count, origin + (first_chunk + c + 1) * chunk)); };
+	auto fill_chunk = [&](unsigned c) {
+		GLuint begin = chunk_begin(c);
+		fn(begin, chunk_end(c) - begin, vertices + begin * stride);
+		};
+
+	if (upload == FillUpload::SINGLE)
+	{
+		if (chunk_count == 1)
+			fill_chunk(0);
+		else
+			pool.parallel_for(chunk_count, fill_chunk);
+		vb.mark_dirty(first * stride, count * stride);
+		vb.flush();
+		return;
+	}
+
+	// Workers report each filled chunk here, and this thread uploads them in the order they finish.
+	std::mutex done_mutex;
+	std::condition_variable done_cv;
+	std::vector<unsigned> done;
+	std::exception_ptr error;
+	for (unsigned c = 0; c < chunk_count; ++c)
+	{
+		pool.submit([&, c]() {
+			std::exception_ptr e;
+			try
+			{
+				fill_chunk(c);
+			}
+			catch (...)
+			{
+				e = std::current_exception();
+			}
+			// Notified under the lock: once the last chunk is reported, this frame may return, and done_cv with it.
+			std::lock_guard<std::mutex> lock(done_mutex);
+			if (e && !error)
+				error = e;
+			done.push_back(c);
+			done_cv.notify_one();
+			});
+	}
+
+	std::vector<unsigned> ready;
+	for (unsigned uploaded = 0; uploaded < chunk_count;)
+	{
+		{
+			std::lock_guard<std::mutex> lock(done_mutex);
+			ready.swap(done);
+		}
+		if (ready.empty())
+		{
+			if (pool.run_one())
+				continue;
+			std::unique_lock<std::mutex> lock(done_mutex);
+			done_cv.wait(lock, [&]() { return !done.empty(); });
+			continue;
+		}
+		for (unsigned c : ready)
+		{
+			GLuint begin = chunk_begin(c);
+			vb.subsend(begin * stride, (chunk_end(c) - begin) * stride);
+		}
+		uploaded += (unsigned)ready.size();
+		ready.clear();
+	}
+	if (error)
+		std::rethrow_exception(error);
+}
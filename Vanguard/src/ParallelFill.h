@@ -0,0 +1,25 @@
+#pragma once
+
+#include "Renderable.h"
+#include "utils/ThreadPool.h"
+
+namespace vg
+{
+	enum class FillUpload
+	{
+		// The filled range is marked dirty and uploaded with one flush() once every chunk is done.
+		SINGLE,
+		// The calling thread uploads each chunk as soon as it is filled, overlapping the upload with the filling of later chunks.
+		PER_CHUNK
+	};
+
+	// A function that writes count whole vertices, starting at vertex first, to vertices at the layout's stride. It runs on worker threads, so it must not touch GL,
+	// and concurrent calls are given disjoint chunks.
+	using VertexFillFunction = std::function<void(GLuint first, GLuint count, void* vertices)>;
+
+	// Fills vertices [first, first + count) of vb in parallel. The range is split into chunks whose boundaries fall on cache lines of the CPU buffer's memory,
+	// so no two threads write to the same line. When the stride keeps every vertex off a line boundary, as a 32-byte stride does in memory that is 16 but not 32-byte
+	// aligned, no boundary can fall on a line, and neighbouring chunks share the one line their boundary splits. Call it from the GL thread: it helps fill chunks while it waits, and does the uploads itself.
+	extern void parallel_fill(CPUVertexBuffer& vb, GLuint first, GLuint count, const VertexFillFunction& fn, FillUpload upload = FillUpload::SINGLE,
+		ThreadPool& pool = ThreadPool::shared());
+}
@@ -0,0 +1,165 @@
+#include "QuadIndices.h"
+
+#include <algorithm>
+#include <memory>
+
+#include <glm/simd/platform.h>
+
+#if (GLM_ARCH & GLM_ARCH_SSE2_BIT) || defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define VANGUARD_QUADS_SSE2
+#include <emmintrin.h>
+#endif
+
+#include "Errors.h"
+
+template<typename Index>
+static void fill_scalar(Index* dst, GLuint first_quad, GLuint quad_count)
+{
+	for (GLuint q = first_quad; q < first_quad + quad_count; ++q, dst += 6)
+	{
+		Index base = Index(4 * q);
+		dst[0] = base;
+		dst[1] = Index(base + 1);
+		dst[2] = Index(base + 2);
+		dst[3] = Index(base + 2);
+		dst[4] = Index(base + 3);
+		dst[5] = base;
+	}
+}
+
+#ifdef VANGUARD_QUADS_SSE2
+template<typename Index>
+static __m128i broadcast(GLuint v)
+{
+	if constexpr (sizeof(Index) == 1)
+		return _mm_set1_epi8((char)v);
+	else if constexpr (sizeof(Index) == 2)
+		return _mm_set1_epi16((short)v);
+	else
+		return _mm_set1_epi32((int)v);
+}
+
+template<typename Index>
+static __m128i add(__m128i a, __m128i b)
+{
+	if constexpr (sizeof(Index) == 1)
+		return _mm_add_epi8(a, b);
+	else if constexpr (sizeof(Index) == 2)
+		return _mm_add_epi16(a, b);
+	else
+		return _mm_add_epi32(a, b);
+}
+
+// Three registers hold LANES / 2 whole quads. Their pattern is built once, and each later group of quads is the pattern plus 4 per preceding quad,
+// so three adds and three stores write 8 quads of bytes, 4 of shorts or 2 of ints.
+template<typename Index>
+static void fill_simd(Index* dst, GLuint first_quad, GLuint quad_count)
+{
+	constexpr GLuint LANES = 16 / sizeof(Index);
+	constexpr GLuint QUADS = LANES / 2;
+	alignas(16) Index pattern[3 * LANES];
+	fill_scalar(pattern, 0, QUADS);
+	__m128i p0 = _mm_load_si128((const __m128i*)pattern);
+	__m128i p1 = _mm_load_si128((const __m128i*)(pattern + LANES));
+	__m128i p2 = _mm_load_si128((const __m128i*)(pattern + 2 * LANES));
+
+	GLuint q = 0;
+	for (; q + QUADS <= quad_count; q += QUADS, dst += 3 * LANES)
+	{
+		__m128i base = broadcast<Index>(4 * (first_quad + q));
+		_mm_storeu_si128((__m128i*)dst, add<Index>(p0, base));
+		_mm_storeu_si128((__m128i*)(dst + LANES), add<Index>(p1, base));
+		_mm_storeu_si128((__m128i*)(dst + 2 * LANES), add<Index>(p2, base));
+	}
+	fill_scalar(dst, first_quad + q, quad_count - q);
+}
+#endif
+
+template<typename Index>
+static void fill_indices(void* dst, GLuint first_quad, GLuint quad_count)
+{
+#ifdef VANGUARD_QUADS_SSE2
+	fill_simd((Index*)dst, first_quad, quad_count);
+#else
+	fill_scalar((Index*)dst, first_quad, quad_count);
+#endif
+}
+
+void vg::quads::fill(IndexDataType idt, void* dst, GLuint first_quad, GLuint quad_count)
+{
+	if (first_quad + quad_count > max_quads(idt))
+		throw Error(ErrorCode::INDEX_TYPE_OVERFLOW, std::to_string(first_quad + quad_count) + " quads need more vertices than index type "
+			+ std::to_string((int)idt) + " can address");
+	if (idt == IndexDataType::UBYTE)
+		fill_indices<GLubyte>(dst, first_quad, quad_count);
+	else if (idt == IndexDataType::USHORT)
+		fill_indices<GLushort>(dst, first_quad, quad_count);
+	else if (idt == IndexDataType::UINT)
+		fill_indices<GLuint>(dst, first_quad, quad_count);
+}
+
+GLuint vg::quads::max_quads(IndexDataType idt)
+{
+	switch (idt)
+	{
+	case IndexDataType::UBYTE: return 0x100 / 4;
+	case IndexDataType::USHORT: return 0x10000 / 4;
+	default: return GLuint(-1) / 4 / 6;
+	}
+}
+
+static std::unique_ptr<vg::CPUIndexBuffer> shared[3];
+
+static std::unique_ptr<vg::CPUIndexBuffer>& shared_slot(vg::IndexDataType idt)
+{
+	switch (idt)
+	{
+	case vg::IndexDataType::UBYTE: return shared[0];
+	case vg::IndexDataType::USHORT: return shared[1];
+	default: return shared[2];
+	}
+}
+
+const vg::CPUIndexBuffer& vg::quads::indices(IndexDataType idt, GLuint quad_count)
+{
+	auto& slot = shared_slot(idt);
+	GLuint held = slot ? GLuint(slot->size() / 6) : 0;
+	if (slot && quad_count <= held)
+		return *slot;
+
+	GLuint grown = std::min(std::max(quad_count, 2 * held), max_quads(idt));
+	if (quad_count > grown)
+		throw Error(ErrorCode::INDEX_TYPE_OVERFLOW, std::to_string(quad_count) + " quads need more vertices than index type " + std::to_string((int)idt) + " can address");
+	if (!slot)
+	{
+		slot = std::make_unique<CPUIndexBuffer>(idt);
+		slot->buffer().resize(6 * grown * index_data_type_size(idt));
+		fill(idt, slot->buffer(), 0, grown);
+		slot->init_immutable();
+	}
+	else
+	{
+		// Only the new quads are generated and uploaded; reserve() carries the existing ones across on the GPU.
+		slot->reserve(GLsizei(6 * grown));
+		slot->resize(GLsizei(6 * grown));
+		fill(idt, slot->buffer().at(6 * held * index_data_type_size(idt)), held, grown - held);
+		slot->subsend(GLsizei(6 * held), GLsizei(6 * (grown - held)));
+	}
+	return *slot;
+}
+
+vg::QuadIndexView vg::quads::view(IndexDataType idt, GLuint quad_count)
+{
+	return { &indices(idt, quad_count), quad_count };
+}
+
+void vg::quads::bind_to_vertex_array(IndexDataType idt, GLuint quad_count, ids::VertexArray vao)
+{
+	indices(idt, quad_count).bind_to_vertex_array(vao);
+}
+
+void vg::quads::release()
+{
+	for (auto& slot : shared)
+		slot.reset();
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "Renderable.h"
+
+namespace vg
+{
+	// A read-only window onto a shared quad index buffer: the indices of its first quad_count quads.
+	struct QuadIndexView
+	{
+		const CPUIndexBuffer* buffer;
+		GLuint quad_count;
+
+		ids::GLBuffer ib() const { return buffer->ib(); }
+		IndexDataType data_type() const { return buffer->data_type(); }
+		GLsizei index_count() const { return GLsizei(6 * quad_count); }
+	};
+
+	// quads owns one immutable index buffer of the 0-1-2-2-3-0 quad pattern per IndexDataType, shared by every quad-drawing buffer in the process. A buffer grows geometrically
+	// when a larger quad count is requested, and growth only appends quads, so indices handed out earlier stay correct for any count up to the current one.
+	// Growing replaces the GL buffer name, so attach it with attach() (or attach_index_buffer(const CPUIndexBuffer&)), which rebinds the current name at each bind_vao().
+	namespace quads
+	{
+		// Writes the indices of quads [first_quad, first_quad + quad_count) to dst, several quads per SIMD store where available.
+		extern void fill(IndexDataType idt, void* dst, GLuint first_quad, GLuint quad_count);
+		// The most quads whose vertices idt can address.
+		extern GLuint max_quads(IndexDataType idt);
+
+		extern const CPUIndexBuffer& indices(IndexDataType idt, GLuint quad_count);
+		extern QuadIndexView view(IndexDataType idt, GLuint quad_count);
+		extern void bind_to_vertex_array(IndexDataType idt, GLuint quad_count, ids::VertexArray vao);
+
+		template<typename Buffer>
+		void attach(Buffer& vb, IndexDataType idt, GLuint quad_count)
+		{
+			vb.attach_index_buffer(indices(idt, quad_count));
+		}
+
+		// Deletes the shared buffers. Call before the GL context is destroyed; they are recreated on the next request.
+		extern void release();
+	}
+}
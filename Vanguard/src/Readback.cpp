@@ -0,0 +1,132 @@
+#include "Readback.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "Errors.h"
+
+#if VANGUARD_MIN_OPENGL_VERSION_IS_AT_LEAST(4, 4)
+
+// Coherent, so a signaled fence is all that is needed before reading. Client storage hints the driver to keep the staging memory on the CPU side.
+static const int STAGING_STORAGE_FLAGS = vg::BufferImmutableUsage::MAP_READ | vg::BufferImmutableUsage::MAP_PERSISTENT | vg::BufferImmutableUsage::MAP_COHERENT
+	| vg::BufferImmutableUsage::CLIENT_STORAGE;
+static const int STAGING_MAP_FLAGS = GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+// Staging sizes are rounded up to a power of two from here, so readbacks of slightly varying sizes share buffers.
+static const GLsizeiptr MIN_STAGING_SIZE = 4096;
+
+vg::ReadbackPool::Staging& vg::ReadbackPool::acquire(GLsizeiptr size)
+{
+	Staging* best = nullptr;
+	for (const auto& staging : _staging)
+		if (!staging->in_use && staging->capacity >= size && (!best || staging->capacity < best->capacity))
+			best = staging.get();
+	if (!best)
+	{
+		GLsizeiptr capacity = MIN_STAGING_SIZE;
+		while (capacity < size)
+			capacity *= 2;
+		auto staging = std::make_unique<Staging>();
+		staging->capacity = capacity;
+		buffers::set_category(staging->buffer, MemoryCategory::STAGING_BUFFER);
+		buffers::init_immutable(staging->buffer, capacity, nullptr, STAGING_STORAGE_FLAGS);
+#if VANGUARD_MIN_OPENGL_VERSION_IS_AT_LEAST(4, 5)
+		staging->mapped = (const char*)glMapNamedBufferRange(ids::GLBuffer(staging->buffer), 0, capacity, STAGING_MAP_FLAGS);
+#else
+		buffers::bind(staging->buffer, BufferTarget::COPY_WRITE);
+		staging->mapped = (const char*)glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, capacity, STAGING_MAP_FLAGS);
+#endif
+		if (!staging->mapped)
+			throw Error(ErrorCode::BUFFER_MAPPING);
+		best = staging.get();
+		_staging.push_back(std::move(staging));
+	}
+	best->in_use = true;
+	return *best;
+}
+
+vg::ReadbackPool::Readback vg::ReadbackPool::read(ids::GLBuffer b, GLintptr offset_bytes, GLsizeiptr size)
+{
+	Staging& staging = acquire(size);
+	buffers::copy_gl_buffer(b, staging.buffer, offset_bytes, 0, size);
+	return Readback(staging, size);
+}
+
+void vg::ReadbackPool::trim()
+{
+	// Deleting a buffer implicitly unmaps it.
+	_staging.erase(std::remove_if(_staging.begin(), _staging.end(), [](const std::unique_ptr<Staging>& staging) { return !staging->in_use; }), _staging.end());
+}
+
+vg::ReadbackPool::Readback::Readback(Staging& staging, GLsizeiptr size)
+	: _staging(&staging), _fence(fences::insert()), _size(size)
+{
+	// ready() polls without flushing, so the fence is flushed here to make sure it can signal.
+	glFlush();
+}
+
+vg::ReadbackPool::Readback::Readback(Readback&& other) noexcept
+	: _staging(other._staging), _fence(other._fence), _size(other._size)
+{
+	other._staging = nullptr;
+	other._fence = nullptr;
+	other._size = 0;
+}
+
+vg::ReadbackPool::Readback& vg::ReadbackPool::Readback::operator=(Readback&& other) noexcept
+{
+	if (this != &other)
+	{
+		release();
+		_staging = other._staging;
+		_fence = other._fence;
+		_size = other._size;
+		other._staging = nullptr;
+		other._fence = nullptr;
+		other._size = 0;
+	}
+	return *this;
+}
+
+vg::ReadbackPool::Readback::~Readback()
+{
+	release();
+}
+
+bool vg::ReadbackPool::Readback::ready() const
+{
+	return fences::is_signaled(_fence);
+}
+
+void vg::ReadbackPool::Readback::wait() const
+{
+	fences::wait(_fence);
+}
+
+const void* vg::ReadbackPool::Readback::data() const
+{
+	if (!_staging)
+		throw Error(ErrorCode::NULL_POINTER, "readback was released");
+	wait();
+	return _staging->mapped;
+}
+
+vg::VoidArray vg::ReadbackPool::Readback::take()
+{
+	VoidArray out(_size);
+	memcpy(out, data(), _size);
+	release();
+	return out;
+}
+
+void vg::ReadbackPool::Readback::release()
+{
+	fences::discard(_fence);
+	if (_staging)
+	{
+		_staging->in_use = false;
+		_staging = nullptr;
+	}
+	_size = 0;
+}
+
+#endif
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "Vanguard.h"
+#include "raii/GLBuffer.h"
+
+namespace vg
+{
+#if VANGUARD_MIN_OPENGL_VERSION_IS_AT_LEAST(4, 4)
+	// ReadbackPool reads GPU buffers back without stalling. read() copies the range into a persistently mapped staging buffer on the GPU and fences the copy,
+	// and the returned Readback is polled or waited on some frames later, once the copy has landed. Staging buffers are recycled: each one goes back to the pool
+	// when its Readback is destroyed, so steady per-frame readbacks stop allocating after the first few frames. Readbacks must not outlive their pool.
+	class ReadbackPool
+	{
+		struct Staging
+		{
+			raii::GLBuffer buffer;
+			GLsizeiptr capacity = 0;
+			const char* mapped = nullptr;
+			bool in_use = false;
+		};
+
+		std::vector<std::unique_ptr<Staging>> _staging;
+
+		Staging& acquire(GLsizeiptr size);
+
+	public:
+		class Readback
+		{
+			friend class ReadbackPool;
+
+			Staging* _staging = nullptr;
+			GLsync _fence = nullptr;
+			GLsizeiptr _size = 0;
+
+			Readback(Staging& staging, GLsizeiptr size);
+
+		public:
+			Readback() = default;
+			Readback(const Readback&) = delete;
+			Readback(Readback&&) noexcept;
+			Readback& operator=(Readback&&) noexcept;
+			~Readback();
+
+			bool valid() const { return _staging != nullptr; }
+			GLsizeiptr size() const { return _size; }
+			// Polls the fence without blocking.
+			bool ready() const;
+			void wait() const;
+			// Waits if the copy hasn't landed yet. The data stays readable until this Readback is destroyed or released.
+			const void* data() const;
+			// Copies the data out and returns the staging buffer to the pool.
+			VoidArray take();
+			void release();
+
+			template<typename Type>
+			const Type& ref(GLintptr offset_bytes) const
+			{
+				if (offset_bytes + (GLsizeiptr)sizeof(Type) > _size)
+					throw offset_out_of_range(_size, offset_bytes, sizeof(Type));
+				return *reinterpret_cast<const Type*>((const char*)data() + offset_bytes);
+			}
+		};
+
+		ReadbackPool() = default;
+		ReadbackPool(const ReadbackPool&) = delete;
+
+		Readback read(ids::GLBuffer b, GLintptr offset_bytes, GLsizeiptr size);
+
+		size_t staging_count() const { return _staging.size(); }
+		// Deletes the staging buffers that no Readback is using.
+		void trim();
+	};
+
+	using Readback = ReadbackPool::Readback;
+#endif
+}
@@ -1,5 +1,69 @@
 #include "Renderable.h"
 
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
+
+#include "Errors.h"
+#include "QuadIndices.h"
+#include "VertexTranscoder.h"
+
+static std::vector<GLuint> interleaved_block(const vg::VertexBufferLayout& layout)
+{
+	std::vector<GLuint> block(layout.attributes().size());
+	for (GLuint i = 0; i < block.size(); ++i)
+		block[i] = i;
+	return block;
+}
+
+// Transcoding between two layouts only reorders bytes, so they must describe the same attributes.
+static void check_transcodable(const vg::VertexBufferLayout& to, const vg::VertexBufferLayout& from)
+{
+	const auto& a = to.attributes();
+	const auto& b = from.attributes();
+	if (a.size() != b.size())
+		throw vg::Error(vg::ErrorCode::VERTEX_LAYOUT_MISMATCH, "cannot transcode between layouts with " + std::to_string(b.size()) + " and " + std::to_string(a.size()) + " attributes");
+	for (size_t i = 0; i < a.size(); ++i)
+	{
+		if (a[i].bytes() != b[i].bytes())
+			throw vg::Error(vg::ErrorCode::VERTEX_LAYOUT_MISMATCH, "cannot transcode attribute " + std::to_string(i) + " between " + std::to_string(b[i].bytes())
+				+ " and " + std::to_string(a[i].bytes()) + " bytes");
+	}
+}
+
+// Replaces b with a new buffer of size bytes holding its first kept bytes. The copy stays on the GPU.
+static void reallocate_gl_buffer(vg::raii::GLBuffer& b, GLsizeiptr size, GLsizeiptr kept, bool is_mutable)
+{
+	vg::raii::GLBuffer grown;
+	vg::buffers::set_category(grown, vg::buffers::category(b));
+	if (is_mutable)
+		vg::buffers::init_mutable(grown, size);
+	else
+		vg::buffers::init_immutable(grown, size);
+	if (kept > 0)
+		vg::buffers::copy_gl_buffer(b, grown, 0, 0, kept);
+	b = std::move(grown);
+}
+
+// Uploads [offset, offset + bytes) of cpubuf, the CPU copy of b. Orphaning discards the whole buffer, so under ORPHAN all of cpubuf goes up. When b has grown
+// past the CPU copy, its tail has no CPU copy to rewrite it from, so the range is invalidated instead.
+static void upload_mirror(vg::ids::GLBuffer b, const vg::VoidArray& cpubuf, size_t offset, size_t bytes, vg::UploadStrategy strategy)
+{
+	if (strategy == vg::UploadStrategy::ORPHAN && cpubuf.size() == vg::buffers::size(b))
+		vg::buffers::upload(b, 0, cpubuf.size(), cpubuf, strategy);
+	else if (strategy == vg::UploadStrategy::ORPHAN)
+		vg::buffers::upload(b, offset, bytes, cpubuf.at(offset), vg::UploadStrategy::INVALIDATE);
+	else
+		vg::buffers::upload(b, offset, bytes, cpubuf.at(offset), strategy);
+}
+
+// Doubling keeps the number of reallocations logarithmic in the final size.
+template<typename Count>
+static Count grown_capacity(Count capacity, Count needed)
+{
+	return std::max(needed, capacity * 2);
+}
+
 vg::VertexAttribute::VertexAttribute(ShaderAttribute attrib, GLuint location, GLuint offset)
 	: location(location), offset(offset)
 {
@@ -95,18 +159,16 @@ vg::VertexAttribute::VertexAttribute(ShaderAttribute attrib, GLuint location, GL
 	}
 }
 
-// LATER investigate using glVertexAttribFormat+glBindVertexBuffer+glVertexAttribBinding workflow over glVertexAttribPointer. Also investigate glBindVertexBuffer
-
 void vg::VertexAttribute::attrib_pointer(GLuint i, GLsizei stride) const
 {
 #pragma warning(push)
 #pragma warning(disable : 4312)
 	if (type == DataType::DOUBLE)
-		glVertexAttribLPointer(i, rows, type_as_gl_enum(), stride, (void*)offset);
-	else if (type != DataType::FLOAT && type != DataType::HALF && integer_case == IntegerCase::INTEGER)
-		glVertexAttribIPointer(i, rows, type_as_gl_enum(), stride, (void*)offset);
+		glVertexAttribLPointer(i, components(), type_as_gl_enum(), stride, (void*)offset);
+	else if (is_integer())
+		glVertexAttribIPointer(i, components(), type_as_gl_enum(), stride, (void*)offset);
 	else
-		glVertexAttribPointer(i, rows, type_as_gl_enum(), integer_case == IntegerCase::NORMALIZED_FLOAT, stride, (void*)offset);
+		glVertexAttribPointer(i, components(), type_as_gl_enum(), integer_case == IntegerCase::NORMALIZED_FLOAT, stride, (void*)offset);
 #pragma warning(pop)
 	glEnableVertexAttribArray(i);
 	glVertexAttribDivisor(i, instance_divisor);
@@ -117,16 +179,44 @@ void vg::VertexAttribute::attrib_pointer(GLuint i, GLsizei stride, GLuint offset
 #pragma warning(push)
 #pragma warning(disable : 4312)
 	if (type == DataType::DOUBLE)
-		glVertexAttribLPointer(i, rows, type_as_gl_enum(), stride, (void*)offset);
-	else if (type != DataType::FLOAT && type != DataType::HALF && integer_case == IntegerCase::INTEGER)
-		glVertexAttribIPointer(i, rows, type_as_gl_enum(), stride, (void*)offset);
+		glVertexAttribLPointer(i, components(), type_as_gl_enum(), stride, (void*)offset);
+	else if (is_integer())
+		glVertexAttribIPointer(i, components(), type_as_gl_enum(), stride, (void*)offset);
 	else
-		glVertexAttribPointer(i, rows, type_as_gl_enum(), integer_case == IntegerCase::NORMALIZED_FLOAT, stride, (void*)offset);
+		glVertexAttribPointer(i, components(), type_as_gl_enum(), integer_case == IntegerCase::NORMALIZED_FLOAT, stride, (void*)offset);
 #pragma warning(pop)
 	glEnableVertexAttribArray(i);
 	glVertexAttribDivisor(i, instance_divisor);
 }
 
+#if VANGUARD_MIN_OPENGL_VERSION_IS_AT_LEAST(4, 3)
+void vg::VertexAttribute::attrib_format(ids::VertexArray vao, GLuint i, GLuint binding, GLuint relative_offset) const
+{
+#if VANGUARD_MIN_OPENGL_VERSION_IS_AT_LEAST(4, 5)
+	if (type == DataType::DOUBLE)
+		glVertexArrayAttribLFormat(vao, i, components(), type_as_gl_enum(), relative_offset);
+	else if (is_integer())
+		glVertexArrayAttribIFormat(vao, i, components(), type_as_gl_enum(), relative_offset);
+	else
+		glVertexArrayAttribFormat(vao, i, components(), type_as_gl_enum(), integer_case == IntegerCase::NORMALIZED_FLOAT, relative_offset);
+	glVertexArrayAttribBinding(vao, i, binding);
+	glVertexArrayBindingDivisor(vao, binding, instance_divisor);
+	glEnableVertexArrayAttrib(vao, i);
+#else
+	// vao must already be bound.
+	if (type == DataType::DOUBLE)
+		glVertexAttribLFormat(i, components(), type_as_gl_enum(), relative_offset);
+	else if (is_integer())
+		glVertexAttribIFormat(i, components(), type_as_gl_enum(), relative_offset);
+	else
+		glVertexAttribFormat(i, components(), type_as_gl_enum(), integer_case == IntegerCase::NORMALIZED_FLOAT, relative_offset);
+	glVertexAttribBinding(i, binding);
+	glVertexBindingDivisor(binding, instance_divisor);
+	glEnableVertexAttribArray(i);
+#endif
+}
+#endif
+
 GLsizei vg::VertexAttribute::bytes() const
 {
 	GLuint type_offset = 0;
@@ -162,10 +252,37 @@ GLsizei vg::VertexAttribute::bytes() const
 	case DataType::FIXED:
 		type_offset = sizeof(GLfixed);
 		break;
+	case DataType::INT_2_10_10_10_REV:
+	case DataType::UINT_2_10_10_10_REV:
+		return sizeof(GLuint);
 	}
 	return type_offset * rows;
 }
 
+vg::packing::Encoding vg::VertexAttribute::encoding(GLuint components) const
+{
+	if (components > (GLuint)this->components())
+		throw Error(ErrorCode::VERTEX_LAYOUT_MISMATCH, "cannot encode " + std::to_string(components) + " components into an attribute with " + std::to_string(this->components()));
+	if (type == DataType::FLOAT)
+		return packing::Encoding::FLOAT;
+	if (type == DataType::HALF)
+		return packing::Encoding::HALF;
+	if (integer_case == IntegerCase::NORMALIZED_FLOAT)
+	{
+		switch (type)
+		{
+		case DataType::UCHAR: return packing::Encoding::UNORM8;
+		case DataType::CHAR: return packing::Encoding::SNORM8;
+		case DataType::USHORT: return packing::Encoding::UNORM16;
+		case DataType::SHORT: return packing::Encoding::SNORM16;
+		case DataType::UINT_2_10_10_10_REV: return packing::Encoding::UNORM_2_10_10_10;
+		case DataType::INT_2_10_10_10_REV: return packing::Encoding::SNORM_2_10_10_10;
+		default: break;
+		}
+	}
+	throw Error(ErrorCode::VERTEX_LAYOUT_MISMATCH, "attribute is not stored as float, half or a normalized integer type");
+}
+
 GLuint vg::VertexAttribute::location_coverage(ShaderAttribute attrib)
 {
 	GLuint columns = 1;
@@ -228,7 +345,7 @@ vg::VertexBufferLayout::VertexBufferLayout(const Shader& shader, const VertexAtt
 		for (GLuint i = 0; i < coverage; ++i)
 		{
 			VertexAttribute attrib(satt, location++, _stride);
-			if (spec_iter != specifications.ordered_override_data_types.end() && spec_iter->first == i)
+			if (spec_iter != specifications.ordered_override_data_types.end() && spec_iter->first == _attributes.size())
 			{
 				attrib.set_type(spec_iter->second);
 				++spec_iter;
@@ -253,18 +370,207 @@ void vg::VertexBufferLayout::unattrib_pointer(GLuint attrib) const
 	glDisableVertexAttribArray(attrib);
 }
 
+const vg::VertexFormat& vg::VertexBufferLayout::format() const
+{
+	return format({ interleaved_block(*this) });
+}
+
+const vg::VertexFormat& vg::VertexBufferLayout::format(const std::vector<std::vector<GLuint>>& blocks) const
+{
+	auto iter = _formats.find(blocks);
+	if (iter == _formats.end())
+		iter = _formats.try_emplace(blocks, _attributes, blocks).first;
+	return iter->second;
+}
+
 GLintptr vg::VertexBufferLayout::buffer_offset(GLuint vertex, GLuint attrib) const
 {
 	return vertex * _stride + _attributes[attrib].get_offset();
 }
 
-void vg::VertexBuffer::init() const
+static void hash_combine(size_t& seed, size_t value)
+{
+	seed ^= value + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2);
+}
+
+size_t vg::VertexBufferLayout::hash() const
+{
+	size_t seed = _stride;
+	for (const VertexAttribute& attrib : _attributes)
+	{
+		hash_combine(seed, (size_t)attrib.get_type());
+		hash_combine(seed, (size_t)attrib.get_integer_case());
+		hash_combine(seed, attrib.get_rows());
+		hash_combine(seed, attrib.get_instance_divisor());
+		hash_combine(seed, attrib.get_offset());
+		hash_combine(seed, attrib.get_location());
+	}
+	return seed;
+}
+
+// The shader inputs and specifications, flattened, identify a layout before it is built, so repeated requests skip building it.
+typedef std::vector<GLint> LayoutInputs;
+
+struct LayoutInputsHash
+{
+	size_t operator()(const LayoutInputs& inputs) const
+	{
+		size_t seed = inputs.size();
+		for (GLint i : inputs)
+			hash_combine(seed, (size_t)i);
+		return seed;
+	}
+};
+
+static struct
+{
+	std::unordered_map<LayoutInputs, std::weak_ptr<vg::VertexBufferLayout>, LayoutInputsHash> by_inputs;
+	std::unordered_map<size_t, std::vector<std::weak_ptr<vg::VertexBufferLayout>>> by_hash;
+	// by_inputs drops expired entries once it reaches this size, which then doubles the live entry count, so churning layouts cost amortized constant time per insert.
+	size_t by_inputs_sweep_at = 64;
+	GLuint next_id = 1;
+} registry;
+
+static LayoutInputs layout_inputs(const vg::Shader& shader, const vg::VertexAttributeSpecificationList& specifications)
+{
+	LayoutInputs inputs;
+	inputs.push_back((GLint)shader.layout().size());
+	for (const vg::ShaderAttribute& attrib : shader.layout())
+	{
+		inputs.push_back((GLint)attrib.type);
+		inputs.push_back(attrib.array_count);
+	}
+	inputs.push_back((GLint)specifications.integer_cases.size());
+	for (auto [i, integer_case] : specifications.integer_cases)
+	{
+		inputs.push_back(i);
+		inputs.push_back((GLint)integer_case);
+	}
+	inputs.push_back((GLint)specifications.ordered_override_data_types.size());
+	for (auto [i, type] : specifications.ordered_override_data_types)
+	{
+		inputs.push_back(i);
+		inputs.push_back((GLint)type);
+	}
+	inputs.push_back((GLint)specifications.instance_divisor.size());
+	for (auto [i, divisor] : specifications.instance_divisor)
+	{
+		inputs.push_back(i);
+		inputs.push_back(divisor);
+	}
+	return inputs;
+}
+
+std::shared_ptr<vg::VertexBufferLayout> vg::layouts::canonical(const Shader& shader, const VertexAttributeSpecificationList& specifications)
+{
+	LayoutInputs inputs = layout_inputs(shader, specifications);
+	auto iter = registry.by_inputs.find(inputs);
+	if (iter != registry.by_inputs.end())
+	{
+		if (auto layout = iter->second.lock())
+			return layout;
+		auto layout = canonical(VertexBufferLayout(shader, specifications));
+		iter->second = layout;
+		return layout;
+	}
+	if (registry.by_inputs.size() >= registry.by_inputs_sweep_at)
+	{
+		std::erase_if(registry.by_inputs, [](const auto& entry) { return entry.second.expired(); });
+		registry.by_inputs_sweep_at = std::max<size_t>(64, 2 * registry.by_inputs.size());
+	}
+	auto layout = canonical(VertexBufferLayout(shader, specifications));
+	registry.by_inputs.emplace(std::move(inputs), layout);
+	return layout;
+}
+
+std::shared_ptr<vg::VertexBufferLayout> vg::layouts::canonical(VertexBufferLayout&& layout)
+{
+	auto& bucket = registry.by_hash[layout.hash()];
+	std::erase_if(bucket, [](const std::weak_ptr<VertexBufferLayout>& weak) { return weak.expired(); });
+	for (const auto& weak : bucket)
+	{
+		auto existing = weak.lock();
+		if (*existing == layout)
+			return existing;
+	}
+	auto canon = std::make_shared<VertexBufferLayout>(std::move(layout));
+	canon->_id = registry.next_id++;
+	bucket.push_back(canon);
+	return canon;
+}
+
+size_t vg::layouts::live_count()
+{
+	size_t count = 0;
+	for (auto iter = registry.by_hash.begin(); iter != registry.by_hash.end(); )
+	{
+		std::erase_if(iter->second, [](const std::weak_ptr<VertexBufferLayout>& weak) { return weak.expired(); });
+		if (iter->second.empty())
+			iter = registry.by_hash.erase(iter);
+		else
+			count += (iter++)->second.size();
+	}
+	std::erase_if(registry.by_inputs, [](const auto& entry) { return entry.second.expired(); });
+	return count;
+}
+
+vg::VertexFormat::VertexFormat(const std::vector<VertexAttribute>& attributes, const std::vector<std::vector<GLuint>>& blocks)
+	: _offsets(attributes.size(), 0), _strides(blocks.size(), 0), _first_bindings(1, 0), _blocks(blocks)
+#if !VANGUARD_MIN_OPENGL_VERSION_IS_AT_LEAST(4, 3)
+	, _attributes(attributes)
+#endif
 {
+#if VANGUARD_MIN_OPENGL_VERSION_IS_AT_LEAST(4, 3) && !VANGUARD_MIN_OPENGL_VERSION_IS_AT_LEAST(4, 5)
 	bind_vao();
-	bind_vb();
-	for (GLuint i = 0; i < _layout->attributes().size(); ++i)
-		_layout->attrib_pointer(i);
+#endif
+	std::vector<GLuint> divisors;
+	for (GLuint b = 0; b < blocks.size(); ++b)
+	{
+		divisors.clear();
+		for (GLuint attrib : blocks[b])
+		{
+			_offsets[attrib] = _strides[b];
+			_strides[b] += attributes[attrib].bytes();
+
+			// The divisor belongs to the binding point, so attributes of one block with different divisors read the same buffer through separate binding points.
+			GLuint divisor = attributes[attrib].get_instance_divisor();
+			auto iter = std::find(divisors.begin(), divisors.end(), divisor);
+			if (iter == divisors.end())
+				iter = divisors.insert(iter, divisor);
+#if VANGUARD_MIN_OPENGL_VERSION_IS_AT_LEAST(4, 3)
+			attributes[attrib].attrib_format(_vao, attrib, _first_bindings[b] + GLuint(iter - divisors.begin()), _offsets[attrib]);
+#endif
+		}
+		_first_bindings.push_back(_first_bindings[b] + (GLuint)divisors.size());
+	}
+#if VANGUARD_MIN_OPENGL_VERSION_IS_AT_LEAST(4, 3) && !VANGUARD_MIN_OPENGL_VERSION_IS_AT_LEAST(4, 5)
 	unbind_vertex_array();
+#endif
+}
+
+void vg::VertexFormat::bind_vertex_buffer(GLuint block, ids::GLBuffer vb, GLintptr offset) const
+{
+	if (block >= block_count())
+		throw block_index_out_of_range(block_count(), block);
+#if VANGUARD_MIN_OPENGL_VERSION_IS_AT_LEAST(4, 5)
+	for (GLuint binding = _first_bindings[block]; binding < _first_bindings[block + 1]; ++binding)
+		glVertexArrayVertexBuffer(vao(), binding, vb, offset, _strides[block]);
+#elif VANGUARD_MIN_OPENGL_VERSION_IS_AT_LEAST(4, 3)
+	bind_vao();
+	for (GLuint binding = _first_bindings[block]; binding < _first_bindings[block + 1]; ++binding)
+		glBindVertexBuffer(binding, vb, offset, _strides[block]);
+#else
+	bind_vao();
+	buffers::bind(vb, BufferTarget::VERTEX);
+	for (GLuint attrib : _blocks[block])
+		_attributes[attrib].attrib_pointer(attrib, _strides[block], GLuint(offset + _offsets[attrib]));
+#endif
+}
+
+void vg::VertexBuffer::init()
+{
+	buffers::set_category(_vb, MemoryCategory::VERTEX_BUFFER);
+	_format = &_layout->format();
 }
 
 vg::VertexBuffer::VertexBuffer(const std::shared_ptr<VertexBufferLayout>& layout)
@@ -279,14 +585,50 @@ vg::VertexBuffer::VertexBuffer(std::shared_ptr<VertexBufferLayout>&& layout)
 	init();
 }
 
+vg::ids::GLBuffer vg::VertexBuffer::vb() const
+{
+#if VANGUARD_MIN_OPENGL_VERSION_IS_AT_LEAST(4, 4)
+	if (_stream)
+		return _stream->buffer();
+#endif
+	return _vb;
+}
+
 void vg::VertexBuffer::bind_vao() const
 {
-	_vao.bind();
+	_format->bind_vao();
+#if VANGUARD_MIN_OPENGL_VERSION_IS_AT_LEAST(4, 4)
+	if (_stream)
+	{
+		_format->bind_vertex_buffer(0, _stream->buffer(), _stream->region_offset());
+		_stream->mark_read();
+	}
+	else
+#endif
+		_format->bind_vertex_buffer(0, _vb);
+	ids::GLBuffer ib = _tracked_ib ? _tracked_ib->ib() : _ib;
+	// The VAO is bound, so binding the element buffer attaches it. bind_index_buffer_to_vertex_array() would unbind the VAO again below GL 4.5.
+	if (ib)
+		buffers::bind(ib, BufferTarget::INDEX);
+}
+
+void vg::VertexBuffer::reallocate(GLsizeiptr size, GLsizeiptr kept, bool is_mutable)
+{
+	reallocate_gl_buffer(_vb, size, kept, is_mutable);
+}
+
+#if VANGUARD_MIN_OPENGL_VERSION_IS_AT_LEAST(4, 4)
+void vg::VertexBuffer::stream_from(const StreamMirror& stream)
+{
+	_vb = raii::GLBuffer();
+	buffers::set_category(_vb, MemoryCategory::VERTEX_BUFFER);
+	_stream = &stream;
 }
+#endif
 
 void vg::VertexBuffer::bind_vb() const
 {
-	buffers::bind(_vb, BufferTarget::VERTEX);
+	buffers::bind(vb(), BufferTarget::VERTEX);
 }
 
 GLintptr vg::VertexBuffer::buffer_offset(GLuint vertex, GLuint attrib) const
@@ -297,59 +639,37 @@ GLintptr vg::VertexBuffer::buffer_offset(GLuint vertex, GLuint attrib) const
 vg::VoidArray vg::VertexBuffer::init_immutable_cpu_buffer(GLuint vertex_count) const
 {
 	VoidArray v(_layout->stride() * vertex_count);
-	bind_vb();
-	buffers::init_immutable(BufferTarget::VERTEX, v.size());
+	buffers::init_immutable(_vb, v.size());
 	return v;
 }
 
 void vg::VertexBuffer::init_immutable_cpu_buffer(VoidArray& cpubuf, GLuint vertex_count) const
 {
 	cpubuf.resize(_layout->stride() * vertex_count);
-	bind_vb();
-	buffers::init_immutable(BufferTarget::VERTEX, cpubuf.size());
+	buffers::init_immutable(_vb, cpubuf.size());
 }
 
 vg::VoidArray vg::VertexBuffer::init_mutable_cpu_buffer(GLuint vertex_count) const
 {
 	VoidArray v(_layout->stride() * vertex_count);
-	bind_vb();
-	buffers::init_mutable(BufferTarget::VERTEX, v.size());
+	buffers::init_mutable(_vb, v.size());
 	return v;
 }
 
 void vg::VertexBuffer::init_mutable_cpu_buffer(VoidArray& cpubuf, GLuint vertex_count) const
 {
 	cpubuf.resize(_layout->stride() * vertex_count);
-	bind_vb();
-	buffers::init_mutable(BufferTarget::VERTEX, cpubuf.size());
+	buffers::init_mutable(_vb, cpubuf.size());
 }
 
 void vg::VertexBufferBlock::init(const std::initializer_list<std::pair<GLuint, std::initializer_list<GLuint>>>& attributes)
 {
-	bind_vao();
-	_offsets.resize(_layout->attributes().size());
-	_strides.resize(_vbs.get_count());
+	buffers::set_category(_vbs, MemoryCategory::VERTEX_BUFFER);
+	std::vector<std::vector<GLuint>> blocks(_vbs.get_count());
 	for (const auto& subattribs : attributes)
-	{
 		if (subattribs.first < _vbs.get_count())
-		{
-			bind_vb(subattribs.first);
-			const auto& lattrs = _layout->attributes();
-			GLuint stride = 0;
-			for (GLuint attrib : subattribs.second)
-				stride += lattrs[attrib].bytes();
-			_strides[subattribs.first] = stride;
-
-			GLuint offset = 0;
-			for (GLuint attrib : subattribs.second)
-			{
-				lattrs[attrib].attrib_pointer(attrib, stride, offset);
-				_offsets[attrib] = offset;
-				offset += lattrs[attrib].bytes();
-			}
-		}
-	}
-	unbind_vertex_array();
+			blocks[subattribs.first] = subattribs.second;
+	_format = &_layout->format(blocks);
 }
 
 vg::VertexBufferBlock::VertexBufferBlock(GLuint block_count, const std::shared_ptr<VertexBufferLayout>& layout,
@@ -366,6 +686,13 @@ vg::VertexBufferBlock::VertexBufferBlock(GLuint block_count, std::shared_ptr<Ver
 	init(attributes);
 }
 
+vg::VertexBufferBlock::VertexBufferBlock(const std::shared_ptr<VertexBufferLayout>& layout, const std::vector<std::vector<GLuint>>& blocks)
+	: _layout(layout), _vbs((GLuint)blocks.size())
+{
+	buffers::set_category(_vbs, MemoryCategory::VERTEX_BUFFER);
+	_format = &_layout->format(blocks);
+}
+
 void vg::VertexBufferBlock::bind_vb(GLuint i) const
 {
 	buffers::bind(_vbs[i], BufferTarget::VERTEX);
@@ -373,78 +700,96 @@ void vg::VertexBufferBlock::bind_vb(GLuint i) const
 
 void vg::VertexBufferBlock::bind_vao() const
 {
-	_vao.bind();
+	_format->bind_vao();
+	for (GLuint i = 0; i < _vbs.get_count(); ++i)
+		_format->bind_vertex_buffer(i, _vbs[i]);
+	ids::GLBuffer ib = _tracked_ib ? _tracked_ib->ib() : _ib;
+	if (ib)
+		buffers::bind(ib, BufferTarget::INDEX);
+}
+
+#if VANGUARD_MIN_OPENGL_VERSION_IS_AT_LEAST(4, 4)
+void vg::VertexBufferBlock::bind_vao(const std::vector<StreamMirror>& streams) const
+{
+	_format->bind_vao();
+	for (GLuint i = 0; i < _vbs.get_count(); ++i)
+	{
+		_format->bind_vertex_buffer(i, streams[i].buffer(), streams[i].region_offset());
+		streams[i].mark_read();
+	}
+	ids::GLBuffer ib = _tracked_ib ? _tracked_ib->ib() : _ib;
+	if (ib)
+		buffers::bind(ib, BufferTarget::INDEX);
+}
+#endif
+
+void vg::VertexBufferBlock::release_storage()
+{
+	_vbs = raii::GLBufferBlock(_vbs.get_count());
+	buffers::set_category(_vbs, MemoryCategory::VERTEX_BUFFER);
 }
 
 GLintptr vg::VertexBufferBlock::buffer_offset(GLuint i, GLuint vertex, GLuint attrib) const
 {
-	return vertex * vb_stride(i) + _offsets[attrib];
+	return vertex * vb_stride(i) + _format->offset(attrib);
 }
 
 vg::VoidArray vg::VertexBufferBlock::init_immutable_cpu_buffer(GLuint i, GLuint vertex_count) const
 {
 	VoidArray v(vb_stride(i) * vertex_count);
-	bind_vb(i);
-	buffers::init_immutable(BufferTarget::VERTEX, v.size());
+	buffers::init_immutable(_vbs[i], v.size());
 	return v;
 }
 
 void vg::VertexBufferBlock::init_immutable_cpu_buffer(VoidArray& cpubuf, GLuint i, GLuint vertex_count) const
 {
 	cpubuf.resize(vb_stride(i) * vertex_count);
-	bind_vb(i);
-	buffers::init_immutable(BufferTarget::VERTEX, cpubuf.size());
+	buffers::init_immutable(_vbs[i], cpubuf.size());
 }
 
 vg::VoidArray vg::VertexBufferBlock::init_mutable_cpu_buffer(GLuint i, GLuint vertex_count) const
 {
 	VoidArray v(vb_stride(i) * vertex_count);
-	bind_vb(i);
-	buffers::init_mutable(BufferTarget::VERTEX, v.size());
+	buffers::init_mutable(_vbs[i], v.size());
 	return v;
 }
 
 void vg::VertexBufferBlock::init_mutable_cpu_buffer(VoidArray& cpubuf, GLuint i, GLuint vertex_count) const
 {
 	cpubuf.resize(vb_stride(i) * vertex_count);
-	bind_vb(i);
-	buffers::init_mutable(BufferTarget::VERTEX, cpubuf.size());
+	buffers::init_mutable(_vbs[i], cpubuf.size());
 }
 
-void vg::MultiVertexBuffer::init() const
+void vg::MultiVertexBuffer::init()
 {
-	for (GLuint i = 0; i < _layouts.size(); ++i)
-	{
-		bind_vao(i);
-		bind_vb(i);
-		GLuint end = (GLuint)_layouts[i]->attributes().size();
-		for (GLuint attrib = 0; attrib < end; ++attrib)
-			_layouts[i]->attrib_pointer(attrib);
-		unbind_vertex_array();
-	}
+	buffers::set_category(_vbs, MemoryCategory::VERTEX_BUFFER);
+	_formats.reserve(_layouts.size());
+	for (const auto& layout : _layouts)
+		_formats.push_back(&layout->format());
 }
 
 vg::MultiVertexBuffer::MultiVertexBuffer(const std::vector<std::shared_ptr<VertexBufferLayout>>& layouts)
-	: _layouts(layouts), _vaos((GLuint)layouts.size()), _vbs((GLuint)layouts.size())
+	: _layouts(layouts), _vbs((GLuint)layouts.size())
 {
 	init();
 }
 
 vg::MultiVertexBuffer::MultiVertexBuffer(std::vector<std::shared_ptr<VertexBufferLayout>>&& layouts)
-	: _layouts(std::move(layouts)), _vaos((GLuint)_layouts.size()), _vbs((GLuint)_layouts.size())
+	: _layouts(std::move(layouts)), _vbs((GLuint)_layouts.size())
 {
 	init();
 }
 
 vg::MultiVertexBuffer::MultiVertexBuffer(const std::shared_ptr<VertexBufferLayout>& layout, GLuint block_count)
-	: _layouts(block_count, layout), _vaos(block_count), _vbs(block_count)
+	: _layouts(block_count, layout), _vbs(block_count)
 {
 	init();
 }
 
 void vg::MultiVertexBuffer::bind_vao(GLuint i) const
 {
-	_vaos.bind(i);
+	_formats[i]->bind_vao();
+	_formats[i]->bind_vertex_buffer(0, _vbs[i]);
 }
 
 void vg::MultiVertexBuffer::bind_vb(GLuint i) const
@@ -460,57 +805,94 @@ GLintptr vg::MultiVertexBuffer::buffer_offset(GLuint i, GLuint vertex, GLuint at
 vg::VoidArray vg::MultiVertexBuffer::init_immutable_cpu_buffer(GLuint i, GLuint vertex_count) const
 {
 	VoidArray v(_layouts[i]->stride() * vertex_count);
-	bind_vb(i);
-	buffers::init_immutable(BufferTarget::VERTEX, v.size());
+	buffers::init_immutable(_vbs[i], v.size());
 	return v;
 }
 
 void vg::MultiVertexBuffer::init_immutable_cpu_buffer(VoidArray& cpubuf, GLuint i, GLuint vertex_count) const
 {
 	cpubuf.resize(_layouts[i]->stride() * vertex_count);
-	bind_vb(i);
-	buffers::init_immutable(BufferTarget::VERTEX, cpubuf.size());
+	buffers::init_immutable(_vbs[i], cpubuf.size());
 }
 
 vg::VoidArray vg::MultiVertexBuffer::init_mutable_cpu_buffer(GLuint i, GLuint vertex_count) const
 {
 	VoidArray v(_layouts[i]->stride() * vertex_count);
-	bind_vb(i);
-	buffers::init_mutable(BufferTarget::VERTEX, v.size());
+	buffers::init_mutable(_vbs[i], v.size());
 	return v;
 }
 
 void vg::MultiVertexBuffer::init_mutable_cpu_buffer(VoidArray& cpubuf, GLuint i, GLuint vertex_count) const
 {
 	cpubuf.resize(_layouts[i]->stride() * vertex_count);
-	bind_vb(i);
-	buffers::init_mutable(BufferTarget::VERTEX, cpubuf.size());
+	buffers::init_mutable(_vbs[i], cpubuf.size());
 }
 
-template<typename DataType>
-static void fill_quad_indexes(vg::VoidArray& cpubuf, GLuint num_quads)
+void vg::CPUIndexBuffer::allocate(GLsizei capacity, GLsizei kept, bool is_mutable)
 {
-	for (GLuint i = 0; i < num_quads; ++i)
+	GLsizei bytes = capacity * index_data_type_size(idt);
+	if (kept == 0 && _is_mutable && is_mutable)
+	{
+		// Mutable storage is respecified in place, which keeps the buffer name and so any attachment by id.
+		buffers::init_mutable(_ib, bytes);
+	}
+	else
 	{
-		cpubuf.ref<DataType>((0 + 6 * i) * sizeof(DataType)) = 0 + 4 * i;
-		cpubuf.ref<DataType>((1 + 6 * i) * sizeof(DataType)) = 1 + 4 * i;
-		cpubuf.ref<DataType>((2 + 6 * i) * sizeof(DataType)) = 2 + 4 * i;
-		cpubuf.ref<DataType>((3 + 6 * i) * sizeof(DataType)) = 2 + 4 * i;
-		cpubuf.ref<DataType>((4 + 6 * i) * sizeof(DataType)) = 3 + 4 * i;
-		cpubuf.ref<DataType>((5 + 6 * i) * sizeof(DataType)) = 0 + 4 * i;
+		// Immutable storage can't be respecified, and growing keeps the old contents, so these get a fresh buffer.
+		reallocate_gl_buffer(_ib, bytes, kept * index_data_type_size(idt), is_mutable);
 	}
+	_capacity = capacity;
+	_is_mutable = is_mutable;
+}
+
+void vg::CPUIndexBuffer::init_immutable()
+{
+	allocate(size(), 0, false);
+	subsend(0, size());
+}
+
+void vg::CPUIndexBuffer::init_mutable()
+{
+	allocate(size(), 0, true);
+	subsend(0, size());
+}
+
+void vg::CPUIndexBuffer::reserve(GLsizei capacity)
+{
+	if (capacity <= _capacity)
+		return;
+	allocate(capacity, std::min(size(), _capacity), _is_mutable);
+	cpubuf.reserve(capacity * index_data_type_size(idt));
+}
+
+void vg::CPUIndexBuffer::resize(GLsizei count)
+{
+	if (count > _capacity)
+		reserve(grown_capacity(_capacity, count));
+	cpubuf.resize(count * index_data_type_size(idt));
+}
+
+void vg::CPUIndexBuffer::push_back(const void* indices, GLsizei count)
+{
+	GLsizei first = size();
+	resize(first + count);
+	std::memcpy(cpubuf.at(first * index_data_type_size(idt)), indices, count * index_data_type_size(idt));
+	subsend(first, count);
+}
+
+void vg::CPUIndexBuffer::subsend(GLsizei first, GLsizei count) const
+{
+	if (first + count > size())
+		throw offset_out_of_range(size(), first, count);
+	if (count > 0)
+		upload_mirror(_ib, cpubuf, first * index_data_type_size(idt), count * index_data_type_size(idt), _is_mutable ? _upload_strategy : UploadStrategy::SUBDATA);
 }
 
 void vg::CPUIndexBuffer::init_immutable_quads(GLuint num_quads)
 {
 	cpubuf.resize(num_quads * 6 * index_data_type_size(idt));
 
-	if (idt == IndexDataType::UBYTE)
-		fill_quad_indexes<GLubyte>(cpubuf, num_quads);
-	else if (idt == IndexDataType::USHORT)
-		fill_quad_indexes<GLushort>(cpubuf, num_quads);
-	else if (idt == IndexDataType::UINT)
-		fill_quad_indexes<GLuint>(cpubuf, num_quads);
+	quads::fill(idt, cpubuf, 0, num_quads);
 
 	init_immutable();
 }
@@ -519,12 +901,7 @@ void vg::CPUIndexBuffer::init_mutable_quads(GLuint num_quads)
 {
 	cpubuf.resize(num_quads * 6 * index_data_type_size(idt));
 
-	if (idt == IndexDataType::UBYTE)
-		fill_quad_indexes<GLubyte>(cpubuf, num_quads);
-	else if (idt == IndexDataType::USHORT)
-		fill_quad_indexes<GLushort>(cpubuf, num_quads);
-	else if (idt == IndexDataType::UINT)
-		fill_quad_indexes<GLuint>(cpubuf, num_quads);
+	quads::fill(idt, cpubuf, 0, num_quads);
 
 	init_mutable();
 }
@@ -532,6 +909,7 @@ void vg::CPUIndexBuffer::init_mutable_quads(GLuint num_quads)
 vg::CPUIndexBufferBlock::CPUIndexBufferBlock(const std::vector<IndexDataType>& idts)
 	: _ibs((GLuint)idts.size())
 {
+	buffers::set_category(_ibs, MemoryCategory::INDEX_BUFFER);
 	idt_cpubufs.reserve(_ibs.get_count());
 	for (IndexDataType idt : idts)
 		idt_cpubufs.push_back({ idt, VoidArray() });
@@ -541,30 +919,26 @@ void vg::CPUIndexBufferBlock::init_immutable(GLuint i, GLsizei count)
 {
 	auto& idt_cpubuf = idt_cpubufs[i];
 	idt_cpubuf.second.resize(count * index_data_type_size(idt_cpubuf.first));
-	bind(i);
-	buffers::init_immutable(BufferTarget::INDEX, idt_cpubuf.second.size(), idt_cpubuf.second);
+	buffers::init_immutable(_ibs[i], idt_cpubuf.second.size(), idt_cpubuf.second);
 }
 
 void vg::CPUIndexBufferBlock::init_immutable(GLuint i)
 {
-	bind(i);
 	const auto& cpubuf = idt_cpubufs[i].second;
-	buffers::init_immutable(BufferTarget::INDEX, cpubuf.size(), cpubuf);
+	buffers::init_immutable(_ibs[i], cpubuf.size(), cpubuf);
 }
 
 void vg::CPUIndexBufferBlock::init_mutable(GLuint i, GLsizei count)
 {
 	auto& idt_cpubuf = idt_cpubufs[i];
 	idt_cpubuf.second.resize(count * index_data_type_size(idt_cpubuf.first));
-	bind(i);
-	buffers::init_mutable(BufferTarget::INDEX, idt_cpubuf.second.size(), idt_cpubuf.second);
+	buffers::init_mutable(_ibs[i], idt_cpubuf.second.size(), idt_cpubuf.second);
 }
 
 void vg::CPUIndexBufferBlock::init_mutable(GLuint i)
 {
-	bind(i);
 	const auto& cpubuf = idt_cpubufs[i].second;
-	buffers::init_mutable(BufferTarget::INDEX, cpubuf.size(), cpubuf);
+	buffers::init_mutable(_ibs[i], cpubuf.size(), cpubuf);
 }
 
 void vg::CPUIndexBufferBlock::init_immutable_quads(GLuint i, GLuint num_quads)
@@ -572,12 +946,7 @@ void vg::CPUIndexBufferBlock::init_immutable_quads(GLuint i, GLuint num_quads)
 	auto& idt_cpubuf = idt_cpubufs[i];
 	idt_cpubuf.second.resize(num_quads * 6 * index_data_type_size(idt_cpubuf.first));
 
-	if (idt_cpubuf.first == IndexDataType::UBYTE)
-		fill_quad_indexes<GLubyte>(idt_cpubuf.second, num_quads);
-	else if (idt_cpubuf.first == IndexDataType::USHORT)
-		fill_quad_indexes<GLushort>(idt_cpubuf.second, num_quads);
-	else if (idt_cpubuf.first == IndexDataType::UINT)
-		fill_quad_indexes<GLuint>(idt_cpubuf.second, num_quads);
+	quads::fill(idt_cpubuf.first, idt_cpubuf.second, 0, num_quads);
 
 	init_immutable(i);
 }
@@ -587,18 +956,13 @@ void vg::CPUIndexBufferBlock::init_mutable_quads(GLuint i, GLuint num_quads)
 	auto& idt_cpubuf = idt_cpubufs[i];
 	idt_cpubuf.second.resize(num_quads * 6 * index_data_type_size(idt_cpubuf.first));
 
-	if (idt_cpubuf.first == IndexDataType::UBYTE)
-		fill_quad_indexes<GLubyte>(idt_cpubuf.second, num_quads);
-	else if (idt_cpubuf.first == IndexDataType::USHORT)
-		fill_quad_indexes<GLushort>(idt_cpubuf.second, num_quads);
-	else if (idt_cpubuf.first == IndexDataType::UINT)
-		fill_quad_indexes<GLuint>(idt_cpubuf.second, num_quads);
+	quads::fill(idt_cpubuf.first, idt_cpubuf.second, 0, num_quads);
 
 	init_mutable(i);
 }
 
 vg::CPUVertexBuffer::CPUVertexBuffer(VertexBuffer&& vb, GLuint vertex_count, bool is_mutable)
-	: _vb(std::move(vb)), _vertex_count(vertex_count)
+	: _vb(std::move(vb)), _vertex_count(vertex_count), _vertex_capacity(vertex_count), _is_mutable(is_mutable)
 {
 	if (is_mutable)
 		_vb.init_mutable_cpu_buffer(_cpubuf, _vertex_count);
@@ -606,32 +970,230 @@ vg::CPUVertexBuffer::CPUVertexBuffer(VertexBuffer&& vb, GLuint vertex_count, boo
 		_vb.init_immutable_cpu_buffer(_cpubuf, _vertex_count);
 }
 
+vg::CPUVertexBuffer::CPUVertexBuffer(VertexBuffer&& vb, const CPUVertexBufferBlock& source, bool is_mutable)
+	: _vb(std::move(vb)), _vertex_count(source.block_count() == 0 ? 0 : source.vertex_count(0)), _vertex_capacity(_vertex_count), _is_mutable(is_mutable)
+{
+	check_transcodable(*_vb.layout(), *source.layout());
+	for (GLuint i = 1; i < source.block_count(); ++i)
+	{
+		if (source.vertex_count(i) != _vertex_count)
+			throw Error(ErrorCode::VERTEX_LAYOUT_MISMATCH, "cannot interleave blocks with different vertex counts (block 0 has " + std::to_string(_vertex_count)
+				+ ", block " + std::to_string(i) + " has " + std::to_string(source.vertex_count(i)) + ")");
+	}
+	std::vector<const VoidArray*> blocks;
+	for (GLuint i = 0; i < source.block_count(); ++i)
+		blocks.push_back(&source.buffer(i));
+	transcode::to_interleaved(source.vertex_buffer_block().format(), blocks, _vertex_count, *_vb.layout(), _cpubuf);
+	if (is_mutable)
+		buffers::init_mutable(_vb.vb(), _cpubuf.size(), _cpubuf);
+	else
+		buffers::init_immutable(_vb.vb(), _cpubuf.size(), _cpubuf);
+}
+
+void vg::CPUVertexBuffer::upload(size_t offset, size_t bytes) const
+{
+#if VANGUARD_MIN_OPENGL_VERSION_IS_AT_LEAST(4, 4)
+	if (_stream)
+	{
+		// Writing a region brings all of it up to date, so the pending writes go up with this range.
+		_dirty.mark(offset, bytes);
+		_stream->write(_cpubuf, _dirty);
+		_dirty.clear();
+		return;
+	}
+#endif
+	upload_mirror(_vb.vb(), _cpubuf, offset, bytes, _is_mutable ? _upload_strategy : UploadStrategy::SUBDATA);
+}
+
+#if VANGUARD_MIN_OPENGL_VERSION_IS_AT_LEAST(4, 4)
+void vg::CPUVertexBuffer::stream(GLuint frames_in_flight)
+{
+	GLsizeiptr stride = _vb.layout()->stride();
+	_stream = std::make_unique<StreamMirror>(BufferTarget::VERTEX, _vertex_capacity * stride, frames_in_flight);
+	_vb.stream_from(*_stream);
+	// Fills the first region, so the next bind_vao() reads the current vertices.
+	_stream->write(_cpubuf, _dirty);
+	_dirty.clear();
+}
+#endif
+
+bool vg::CPUVertexBuffer::is_streaming() const
+{
+#if VANGUARD_MIN_OPENGL_VERSION_IS_AT_LEAST(4, 4)
+	return _stream != nullptr;
+#else
+	return false;
+#endif
+}
+
 void vg::CPUVertexBuffer::subsend_full() const
 {
-	buffers::subsend(BufferTarget::VERTEX, 0, _cpubuf.size(), _cpubuf);
+	upload(0, _cpubuf.size());
+	_dirty.clear();
 }
 
 void vg::CPUVertexBuffer::subsend(size_t offset, size_t bytes) const
 {
-	buffers::subsend(BufferTarget::VERTEX, offset, bytes, _cpubuf.at(offset));
+	upload(offset, bytes);
 }
 
 void vg::CPUVertexBuffer::subsend_single(GLuint vertex) const
 {
 	GLintptr offset = buffer_offset(vertex, 0);
 	GLuint stride = _vb.layout()->stride();
-	buffers::subsend(BufferTarget::VERTEX, offset, stride, _cpubuf.at(offset));
+	upload(offset, stride);
 }
 
 void vg::CPUVertexBuffer::subsend_single(GLuint vertex, GLuint attrib) const
 {
 	GLintptr offset = buffer_offset(vertex, attrib);
 	GLuint size = _vb.layout()->attributes()[attrib].bytes();
-	buffers::subsend(BufferTarget::VERTEX, offset, size, _cpubuf.at(offset));
+	upload(offset, size);
+}
+
+void vg::CPUVertexBuffer::flush()
+{
+	if (_dirty.empty())
+		return;
+#if VANGUARD_MIN_OPENGL_VERSION_IS_AT_LEAST(4, 4)
+	if (_stream)
+	{
+		_stream->write(_cpubuf, _dirty);
+		_dirty.clear();
+		return;
+	}
+#endif
+	UploadStrategy strategy = _is_mutable ? _upload_strategy : UploadStrategy::SUBDATA;
+	if (strategy == UploadStrategy::ORPHAN)
+		upload(0, _cpubuf.size());
+	else
+		buffers::upload_ranges(_vb.vb(), _dirty, _cpubuf, strategy);
+	_dirty.clear();
+}
+
+// Overlapping moves are split into more copies than this only when the gap is small against the tail, and are then cheaper to upload again from the CPU copy.
+static const GLsizeiptr MAX_MOVE_CHUNKS = 16;
+
+// Moves bytes within one GPU buffer, returning false if the move was left to the caller. glCopyBufferSubData rejects overlapping ranges within a buffer, so an overlapping
+// move is copied in chunks of |dst - src| bytes, which never overlap: front to back when moving down, and back to front when moving up.
+static bool move_gl_range(vg::ids::GLBuffer b, GLintptr src, GLintptr dst, GLsizeiptr size)
+{
+	if (size == 0 || src == dst)
+		return true;
+	GLsizeiptr chunk = src < dst ? dst - src : src - dst;
+	if (chunk >= size)
+	{
+		vg::buffers::copy_gl_buffer(b, b, src, dst, size);
+		return true;
+	}
+	if ((size + chunk - 1) / chunk > MAX_MOVE_CHUNKS)
+		return false;
+	if (dst < src)
+	{
+		for (GLsizeiptr moved = 0; moved < size; moved += chunk)
+			vg::buffers::copy_gl_buffer(b, b, src + moved, dst + moved, std::min(chunk, size - moved));
+	}
+	else
+	{
+		for (GLsizeiptr left = size; left > 0; left -= chunk)
+		{
+			GLsizeiptr bytes = std::min(chunk, left);
+			vg::buffers::copy_gl_buffer(b, b, src + left - bytes, dst + left - bytes, bytes);
+		}
+	}
+	return true;
+}
+
+void vg::CPUVertexBuffer::erase_vertices(GLuint first, GLuint count)
+{
+	if (first + count > _vertex_count)
+		throw offset_out_of_range(_vertex_count, first, count);
+	if (count == 0)
+		return;
+	// Pending writes are uploaded first, so the GPU copy can be moved in step with the CPU copy.
+	flush();
+	size_t stride = _vb.layout()->stride();
+	size_t dst = first * stride;
+	size_t src = (size_t)(first + count) * stride;
+	size_t tail = _cpubuf.size() - src;
+	std::memmove(_cpubuf.at(dst), _cpubuf.at(src), tail);
+	if (is_streaming() || !move_gl_range(_vb.vb(), src, dst, tail))
+		_dirty.mark(dst, tail);
+	_vertex_count -= count;
+	_cpubuf.resize((size_t)_vertex_count * stride);
+}
+
+void vg::CPUVertexBuffer::insert_vertices(GLuint first, GLuint count)
+{
+	if (first > _vertex_count)
+		throw offset_out_of_range(_vertex_count, first, count);
+	if (count == 0)
+		return;
+	flush();
+	if (_vertex_count + count > _vertex_capacity)
+		reserve(grown_capacity(_vertex_capacity, _vertex_count + count));
+	size_t stride = _vb.layout()->stride();
+	size_t src = first * stride;
+	size_t dst = (size_t)(first + count) * stride;
+	size_t tail = _cpubuf.size() - src;
+	_vertex_count += count;
+	_cpubuf.resize((size_t)_vertex_count * stride);
+	std::memmove(_cpubuf.at(dst), _cpubuf.at(src), tail);
+	std::memset(_cpubuf.at(src), 0, count * stride);
+	if (is_streaming() || !move_gl_range(_vb.vb(), src, dst, tail))
+		_dirty.mark(dst, tail);
+	_dirty.mark(src, count * stride);
+}
+
+void vg::CPUVertexBuffer::reserve(GLuint vertex_capacity)
+{
+	if (vertex_capacity <= _vertex_capacity)
+		return;
+	GLsizeiptr stride = _vb.layout()->stride();
+#if VANGUARD_MIN_OPENGL_VERSION_IS_AT_LEAST(4, 4)
+	if (_stream)
+	{
+		_vertex_capacity = vertex_capacity;
+		_cpubuf.reserve(vertex_capacity * stride);
+		// The new stream starts empty, and its first region is filled now so the next bind_vao() has the vertices to read.
+		_stream = std::make_unique<StreamMirror>(BufferTarget::VERTEX, vertex_capacity * stride, _stream->region_count());
+		_vb.stream_from(*_stream);
+		_stream->write(_cpubuf, _dirty);
+		_dirty.clear();
+		return;
+	}
+#endif
+	_vb.reallocate(vertex_capacity * stride, std::min(_vertex_count, _vertex_capacity) * stride, _is_mutable);
+	_vertex_capacity = vertex_capacity;
+	_cpubuf.reserve(vertex_capacity * stride);
+}
+
+void vg::CPUVertexBuffer::resize(GLuint vertex_count)
+{
+	if (vertex_count < _vertex_count)
+		erase_vertices(vertex_count, _vertex_count - vertex_count);
+	else
+		insert_vertices(_vertex_count, vertex_count - _vertex_count);
+}
+
+GLuint vg::CPUVertexBuffer::push_back_vertices(GLuint count)
+{
+	GLuint first = _vertex_count;
+	insert_vertices(first, count);
+	return first;
+}
+
+GLuint vg::CPUVertexBuffer::push_back_vertices(const void* vertices, GLuint count)
+{
+	GLuint first = push_back_vertices(count);
+	size_t stride = _vb.layout()->stride();
+	if (count > 0)
+		std::memcpy(_cpubuf.at(first * stride), vertices, count * stride);
+	return first;
 }
 
 vg::CPUVertexBufferBlock::CPUVertexBufferBlock(VertexBufferBlock&& vbb, const std::vector<GLuint>& vertex_counts, const std::vector<bool>& is_mutables)
-	: _vbb(std::move(vbb))
+	: _vbb(std::move(vbb)), _dirty(_vbb.block_count())
 {
 	for (GLuint i = 0; i < _vbb.block_count(); ++i)
 	{
@@ -643,7 +1205,7 @@ vg::CPUVertexBufferBlock::CPUVertexBufferBlock(VertexBufferBlock&& vbb, const st
 }
 
 vg::CPUVertexBufferBlock::CPUVertexBufferBlock(VertexBufferBlock&& vbb, GLuint vertex_count, const std::vector<bool>& is_mutables)
-	: _vbb(std::move(vbb))
+	: _vbb(std::move(vbb)), _dirty(_vbb.block_count())
 {
 	for (GLuint i = 0; i < _vbb.block_count(); ++i)
 	{
@@ -655,7 +1217,7 @@ vg::CPUVertexBufferBlock::CPUVertexBufferBlock(VertexBufferBlock&& vbb, GLuint v
 }
 
 vg::CPUVertexBufferBlock::CPUVertexBufferBlock(VertexBufferBlock&& vbb, const std::vector<GLuint>& vertex_counts, bool is_mutable)
-	: _vbb(std::move(vbb))
+	: _vbb(std::move(vbb)), _dirty(_vbb.block_count())
 {
 	if (is_mutable)
 	{
@@ -670,7 +1232,7 @@ vg::CPUVertexBufferBlock::CPUVertexBufferBlock(VertexBufferBlock&& vbb, const st
 }
 
 vg::CPUVertexBufferBlock::CPUVertexBufferBlock(VertexBufferBlock&& vbb, GLuint vertex_count, bool is_mutable)
-	: _vbb(std::move(vbb))
+	: _vbb(std::move(vbb)), _dirty(_vbb.block_count())
 {
 	if (is_mutable)
 	{
@@ -684,34 +1246,137 @@ vg::CPUVertexBufferBlock::CPUVertexBufferBlock(VertexBufferBlock&& vbb, GLuint v
 	}
 }
 
+vg::CPUVertexBufferBlock::CPUVertexBufferBlock(VertexBufferBlock&& vbb, const CPUVertexBuffer& source, bool is_mutable)
+	: _vbb(std::move(vbb)), _dirty(_vbb.block_count())
+{
+	check_transcodable(*_vbb.layout(), *source.layout());
+	std::vector<VoidArray> blocks;
+	transcode::to_blocks(*_vbb.layout(), source.buffer(), _vbb.format(), blocks);
+	for (GLuint i = 0; i < _vbb.block_count(); ++i)
+	{
+		if (is_mutable)
+			buffers::init_mutable(_vbb.vb(i), blocks[i].size(), blocks[i]);
+		else
+			buffers::init_immutable(_vbb.vb(i), blocks[i].size(), blocks[i]);
+		_cpubuf_and_vcs.push_back({ std::move(blocks[i]), source.vertex_count() });
+	}
+}
+
+void vg::CPUVertexBufferBlock::upload(GLuint i, size_t offset, size_t bytes) const
+{
+#if VANGUARD_MIN_OPENGL_VERSION_IS_AT_LEAST(4, 4)
+	if (!_streams.empty())
+	{
+		_dirty[i].mark(offset, bytes);
+		_streams[i].write(_cpubuf_and_vcs[i].first, _dirty[i]);
+		_dirty[i].clear();
+		return;
+	}
+#endif
+	buffers::subsend(_vbb.vb(i), offset, bytes, _cpubuf_and_vcs[i].first.at(offset));
+}
+
+vg::ids::GLBuffer vg::CPUVertexBufferBlock::vb(GLuint i) const
+{
+#if VANGUARD_MIN_OPENGL_VERSION_IS_AT_LEAST(4, 4)
+	if (!_streams.empty())
+		return _streams[i].buffer();
+#endif
+	return _vbb.vb(i);
+}
+
+void vg::CPUVertexBufferBlock::bind_vao() const
+{
+#if VANGUARD_MIN_OPENGL_VERSION_IS_AT_LEAST(4, 4)
+	if (!_streams.empty())
+	{
+		_vbb.bind_vao(_streams);
+		return;
+	}
+#endif
+	_vbb.bind_vao();
+}
+
+void vg::CPUVertexBufferBlock::bind_vb(GLuint i) const
+{
+	buffers::bind(vb(i), BufferTarget::VERTEX);
+}
+
+#if VANGUARD_MIN_OPENGL_VERSION_IS_AT_LEAST(4, 4)
+void vg::CPUVertexBufferBlock::stream(GLuint frames_in_flight)
+{
+	_streams.clear();
+	_streams.reserve(block_count());
+	for (GLuint i = 0; i < block_count(); ++i)
+	{
+		_streams.emplace_back(BufferTarget::VERTEX, _cpubuf_and_vcs[i].first.size(), frames_in_flight);
+		_streams[i].write(_cpubuf_and_vcs[i].first, _dirty[i]);
+		_dirty[i].clear();
+	}
+	_vbb.release_storage();
+}
+#endif
+
+bool vg::CPUVertexBufferBlock::is_streaming() const
+{
+#if VANGUARD_MIN_OPENGL_VERSION_IS_AT_LEAST(4, 4)
+	return !_streams.empty();
+#else
+	return false;
+#endif
+}
+
 void vg::CPUVertexBufferBlock::subsend_full(GLuint i) const
 {
-	buffers::subsend(BufferTarget::VERTEX, 0, _cpubuf_and_vcs[i].first.size(), _cpubuf_and_vcs[i].first);
+	upload(i, 0, _cpubuf_and_vcs[i].first.size());
+	_dirty[i].clear();
 }
 
 void vg::CPUVertexBufferBlock::subsend_all_blocks() const
 {
 	for (GLuint i = 0; i < block_count(); ++i)
-	{
-		bind_vb(i);
 		subsend_full(i);
-	}
 }
 
 void vg::CPUVertexBufferBlock::subsend(GLuint i, size_t offset, size_t bytes) const
 {
-	buffers::subsend(BufferTarget::VERTEX, offset, bytes, _cpubuf_and_vcs[i].first.at(offset));
+	upload(i, offset, bytes);
 }
 
 void vg::CPUVertexBufferBlock::subsend_single(GLuint i, GLuint vertex, GLuint attrib) const
 {
 	GLintptr offset = buffer_offset(i, vertex, attrib);
 	GLuint size = _vbb.layout()->attributes()[attrib].bytes();
-	buffers::subsend(BufferTarget::VERTEX, offset, size, _cpubuf_and_vcs[i].first.at(offset));
+	upload(i, offset, size);
+}
+
+void vg::CPUVertexBufferBlock::flush(GLuint i)
+{
+	DirtyRanges& dirty = _dirty[i];
+	if (dirty.empty())
+		return;
+#if VANGUARD_MIN_OPENGL_VERSION_IS_AT_LEAST(4, 4)
+	if (!_streams.empty())
+	{
+		_streams[i].write(_cpubuf_and_vcs[i].first, dirty);
+		dirty.clear();
+		return;
+	}
+#endif
+	const VoidArray& cpubuf = _cpubuf_and_vcs[i].first;
+	for (const DirtyRanges::Range& range : dirty.ranges())
+		buffers::subsend(_vbb.vb(i), range.begin, range.bytes(), cpubuf.at(range.begin));
+	dirty.clear();
+}
+
+void vg::CPUVertexBufferBlock::flush()
+{
+	for (GLuint i = 0; i < block_count(); ++i)
+		flush(i);
 }
 
 vg::MultiCPUVertexBuffer::MultiCPUVertexBuffer(MultiVertexBuffer&& vbs, const std::vector<GLuint>& vertex_counts, const std::vector<bool>& is_mutables)
-	: _vbs(std::move(vbs))
+	: _vbs(std::move(vbs)), _dirty(_vbs.block_count())
 {
 	for (GLuint i = 0; i < _vbs.block_count(); ++i)
 	{
@@ -723,7 +1388,7 @@ vg::MultiCPUVertexBuffer::MultiCPUVertexBuffer(MultiVertexBuffer&& vbs, const st
 }
 
 vg::MultiCPUVertexBuffer::MultiCPUVertexBuffer(MultiVertexBuffer&& vbs, GLuint vertex_count, const std::vector<bool>& is_mutables)
-	: _vbs(std::move(vbs))
+	: _vbs(std::move(vbs)), _dirty(_vbs.block_count())
 {
 	for (GLuint i = 0; i < _vbs.block_count(); ++i)
 	{
@@ -735,7 +1400,7 @@ vg::MultiCPUVertexBuffer::MultiCPUVertexBuffer(MultiVertexBuffer&& vbs, GLuint v
 }
 
 vg::MultiCPUVertexBuffer::MultiCPUVertexBuffer(MultiVertexBuffer&& vbs, const std::vector<GLuint>& vertex_counts, bool is_mutable)
-	: _vbs(std::move(vbs))
+	: _vbs(std::move(vbs)), _dirty(_vbs.block_count())
 {
 	if (is_mutable)
 	{
@@ -750,7 +1415,7 @@ vg::MultiCPUVertexBuffer::MultiCPUVertexBuffer(MultiVertexBuffer&& vbs, const st
 }
 
 vg::MultiCPUVertexBuffer::MultiCPUVertexBuffer(MultiVertexBuffer&& vbs, GLuint vertex_count, bool is_mutable)
-	: _vbs(std::move(vbs))
+	: _vbs(std::move(vbs)), _dirty(_vbs.block_count())
 {
 	if (is_mutable)
 	{
@@ -766,86 +1431,345 @@ vg::MultiCPUVertexBuffer::MultiCPUVertexBuffer(MultiVertexBuffer&& vbs, GLuint v
 
 void vg::MultiCPUVertexBuffer::subsend_full(GLuint i) const
 {
-	buffers::subsend(BufferTarget::VERTEX, 0, _cpubuf_and_vcs[i].first.size(), _cpubuf_and_vcs[i].first);
+	buffers::subsend(_vbs.vb(i), 0, _cpubuf_and_vcs[i].first.size(), _cpubuf_and_vcs[i].first);
+	_dirty[i].clear();
 }
 
 void vg::MultiCPUVertexBuffer::subsend_all_blocks() const
 {
 	for (GLuint i = 0; i < block_count(); ++i)
-	{
-		bind_vb(i);
 		subsend_full(i);
-	}
 }
 
 void vg::MultiCPUVertexBuffer::subsend(GLuint i, size_t offset, size_t bytes) const
 {
-	buffers::subsend(BufferTarget::VERTEX, offset, bytes, _cpubuf_and_vcs[i].first.at(offset));
+	buffers::subsend(_vbs.vb(i), offset, bytes, _cpubuf_and_vcs[i].first.at(offset));
 }
 
 void vg::MultiCPUVertexBuffer::subsend_single(GLuint i, GLuint vertex) const
 {
 	GLintptr offset = buffer_offset(i, vertex, 0);
 	GLuint stride = _vbs.layout(i)->stride();
-	buffers::subsend(BufferTarget::VERTEX, offset, stride, _cpubuf_and_vcs[i].first.at(offset));
+	buffers::subsend(_vbs.vb(i), offset, stride, _cpubuf_and_vcs[i].first.at(offset));
 }
 
 void vg::MultiCPUVertexBuffer::subsend_single(GLuint i, GLuint vertex, GLuint attrib) const
 {
 	GLintptr offset = buffer_offset(i, vertex, attrib);
 	GLuint size = _vbs.layout(i)->attributes()[attrib].bytes();
-	buffers::subsend(BufferTarget::VERTEX, offset, size, _cpubuf_and_vcs[i].first.at(offset));
+	buffers::subsend(_vbs.vb(i), offset, size, _cpubuf_and_vcs[i].first.at(offset));
+}
+
+void vg::MultiCPUVertexBuffer::flush(GLuint i)
+{
+	DirtyRanges& dirty = _dirty[i];
+	if (dirty.empty())
+		return;
+	const VoidArray& cpubuf = _cpubuf_and_vcs[i].first;
+	for (const DirtyRanges::Range& range : dirty.ranges())
+		buffers::subsend(_vbs.vb(i), range.begin, range.bytes(), cpubuf.at(range.begin));
+	dirty.clear();
+}
+
+void vg::MultiCPUVertexBuffer::flush()
+{
+	for (GLuint i = 0; i < block_count(); ++i)
+		flush(i);
+}
+
+#if VANGUARD_MIN_OPENGL_VERSION_IS_AT_LEAST(4, 4)
+
+void vg::StreamVertexBuffer::init() const
+{
+	_format.bind_vertex_buffer(0, _sb.buffer());
+}
+
+vg::StreamVertexBuffer::StreamVertexBuffer(const std::shared_ptr<VertexBufferLayout>& layout, GLuint vertex_count, GLuint frames_in_flight)
+	: _layout(layout), _format(layout->attributes(), { interleaved_block(*layout) }), _sb(BufferTarget::VERTEX, layout->stride() * vertex_count, frames_in_flight),
+	_vertex_count(vertex_count)
+{
+	init();
+}
+
+vg::StreamVertexBuffer::StreamVertexBuffer(std::shared_ptr<VertexBufferLayout>&& layout, GLuint vertex_count, GLuint frames_in_flight)
+	: _layout(std::move(layout)), _format(_layout->attributes(), { interleaved_block(*_layout) }), _sb(BufferTarget::VERTEX, _layout->stride() * vertex_count, frames_in_flight),
+	_vertex_count(vertex_count)
+{
+	init();
+}
+
+void vg::StreamVertexBuffer::bind_vao() const
+{
+	_format.bind_vao();
+}
+
+void vg::StreamVertexBuffer::bind_vb() const
+{
+	_sb.bind();
+}
+
+void vg::StreamVertexBuffer::write(GLuint first_vertex, GLuint count, const void* vertices)
+{
+	_sb.write(buffer_offset(first_vertex, 0), count * _layout->stride(), vertices);
+}
+
+#endif
+
+void vg::MeshHeap::init() const
+{
+	_format.bind_vertex_buffer(0, _vertex_heap.buffer());
+	bind_index_buffer_to_vertex_array(_index_heap.buffer(), _format.vao());
+}
+
+vg::MeshHeap::MeshHeap(const std::shared_ptr<VertexBufferLayout>& layout, GLuint vertex_capacity, GLuint index_capacity, IndexDataType idt)
+	: _layout(layout), _format(layout->attributes(), { interleaved_block(*layout) }), _vertex_heap(BufferTarget::VERTEX, layout->stride(), vertex_capacity),
+	_index_heap(BufferTarget::INDEX, (GLuint)index_data_type_size(idt), index_capacity), _idt(idt)
+{
+	init();
+}
+
+vg::MeshHeap::MeshHeap(std::shared_ptr<VertexBufferLayout>&& layout, GLuint vertex_capacity, GLuint index_capacity, IndexDataType idt)
+	: _layout(std::move(layout)), _format(_layout->attributes(), { interleaved_block(*_layout) }), _vertex_heap(BufferTarget::VERTEX, _layout->stride(), vertex_capacity),
+	_index_heap(BufferTarget::INDEX, (GLuint)index_data_type_size(idt), index_capacity), _idt(idt)
+{
+	init();
+}
+
+void vg::MeshHeap::bind_vao() const
+{
+	_format.bind_vao();
+}
+
+vg::MeshHeap::Mesh vg::MeshHeap::allocate(GLuint vertex_count, GLuint index_count)
+{
+	Mesh mesh;
+	mesh.vertices = _vertex_heap.allocate(vertex_count);
+	try
+	{
+		mesh.indices = _index_heap.allocate(index_count);
+	}
+	catch (...)
+	{
+		_vertex_heap.free(mesh.vertices);
+		throw;
+	}
+	return mesh;
+}
+
+void vg::MeshHeap::free(Mesh mesh)
+{
+	_vertex_heap.free(mesh.vertices);
+	_index_heap.free(mesh.indices);
+}
+
+void vg::MeshHeap::defragment()
+{
+	// The heaps compact in place, so the VAO's attribute and index bindings stay valid.
+	_vertex_heap.defragment();
+	_index_heap.defragment();
 }
 
 vg::CompactVBIndexer::CompactVBIndexer(const std::vector<GLuint>& vertex_counts)
 {
-	GLuint offset = 0;
+	_nodes.reserve(vertex_counts.size());
 	for (GLuint vc : vertex_counts)
+		push_back(vc);
+}
+
+void vg::CompactVBIndexer::update(GLuint t)
+{
+	Node& node = _nodes[t];
+	node.subtree_size = 1 + subtree_size(node.left) + subtree_size(node.right);
+	node.subtree_vertices = node.vertex_count + subtree_vertices(node.left) + subtree_vertices(node.right);
+}
+
+GLuint vg::CompactVBIndexer::new_node(GLuint vertex_count)
+{
+	// xorshift32: priorities only need to be independent of insertion order.
+	_seed ^= _seed << 13;
+	_seed ^= _seed >> 17;
+	_seed ^= _seed << 5;
+	Node node;
+	node.vertex_count = vertex_count;
+	node.subtree_vertices = vertex_count;
+	node.priority = _seed;
+	if (_free_nodes.empty())
 	{
-		indexes.push_back({ vc, offset });
-		offset += vc;
+		_nodes.push_back(node);
+		return GLuint(_nodes.size() - 1);
 	}
+	GLuint t = _free_nodes.back();
+	_free_nodes.pop_back();
+	_nodes[t] = node;
+	return t;
 }
 
-void vg::CompactVBIndexer::push_back(GLuint vc)
+// Splits t into its first pos entries and the rest.
+void vg::CompactVBIndexer::split(GLuint t, GLuint pos, GLuint& left, GLuint& right)
 {
-	GLuint offset = vertex_count();
-	indexes.push_back({ vc, offset });
+	if (t == NIL)
+	{
+		left = right = NIL;
+		return;
+	}
+	GLuint left_size = subtree_size(_nodes[t].left);
+	if (pos <= left_size)
+	{
+		split(_nodes[t].left, pos, left, _nodes[t].left);
+		right = t;
+	}
+	else
+	{
+		split(_nodes[t].right, pos - left_size - 1, _nodes[t].right, right);
+		left = t;
+	}
+	update(t);
 }
 
-void vg::CompactVBIndexer::insert(GLuint pos, GLuint vc)
+GLuint vg::CompactVBIndexer::merge(GLuint left, GLuint right)
 {
-	if (pos == indexes.size() - 1)
+	if (left == NIL)
+		return right;
+	if (right == NIL)
+		return left;
+	if (_nodes[left].priority > _nodes[right].priority)
+	{
+		_nodes[left].right = merge(_nodes[left].right, right);
+		update(left);
+		return left;
+	}
+	else
 	{
-		GLuint offset = vertex_count();
-		indexes.push_back({ vc, offset });
+		_nodes[right].left = merge(left, _nodes[right].left);
+		update(right);
+		return right;
 	}
-	else if (pos < indexes.size() - 1)
+}
+
+GLuint vg::CompactVBIndexer::node_at(GLuint pos) const
+{
+	if (pos >= size())
+		throw block_index_out_of_range(size(), pos);
+	GLuint t = _root;
+	while (true)
 	{
-		GLuint offset = indexes[pos].vertex_offset;
-		indexes.insert(indexes.begin() + pos, { vc, offset });
-		for (auto iter = indexes.begin() + pos + 1; iter != indexes.end(); ++iter)
-			iter->vertex_offset += vc;
+		GLuint left_size = subtree_size(_nodes[t].left);
+		if (pos < left_size)
+			t = _nodes[t].left;
+		else if (pos == left_size)
+			return t;
+		else
+		{
+			pos -= left_size + 1;
+			t = _nodes[t].right;
+		}
 	}
 }
 
+void vg::CompactVBIndexer::set_vertex_count(GLuint t, GLuint pos, GLuint vertex_count)
+{
+	GLuint left_size = subtree_size(_nodes[t].left);
+	if (pos < left_size)
+		set_vertex_count(_nodes[t].left, pos, vertex_count);
+	else if (pos == left_size)
+		_nodes[t].vertex_count = vertex_count;
+	else
+		set_vertex_count(_nodes[t].right, pos - left_size - 1, vertex_count);
+	update(t);
+}
+
+GLuint vg::CompactVBIndexer::vertex_offset(GLuint index) const
+{
+	if (index >= size())
+		throw block_index_out_of_range(size(), index);
+	GLuint offset = 0;
+	GLuint t = _root;
+	while (true)
+	{
+		const Node& node = _nodes[t];
+		GLuint left_size = subtree_size(node.left);
+		if (index < left_size)
+			t = node.left;
+		else if (index == left_size)
+			return offset + subtree_vertices(node.left);
+		else
+		{
+			offset += subtree_vertices(node.left) + node.vertex_count;
+			index -= left_size + 1;
+			t = node.right;
+		}
+	}
+}
+
+void vg::CompactVBIndexer::push_back(GLuint vc)
+{
+	_root = merge(_root, new_node(vc));
+}
+
+void vg::CompactVBIndexer::insert(GLuint pos, GLuint vc)
+{
+	if (pos > size())
+		throw block_index_out_of_range(size() + 1, pos);
+	GLuint left, right;
+	split(_root, pos, left, right);
+	_root = merge(merge(left, new_node(vc)), right);
+}
+
 void vg::CompactVBIndexer::erase(GLuint pos)
 {
-	GLuint vc = indexes[pos].vertex_count;
-	indexes.erase(indexes.begin() + pos);
-	for (auto iter = indexes.begin() + pos; iter != indexes.end(); ++iter)
-		iter->vertex_offset -= vc;
+	if (pos >= size())
+		throw block_index_out_of_range(size(), pos);
+	GLuint left, middle, right;
+	split(_root, pos, left, right);
+	split(right, 1, middle, right);
+	_free_nodes.push_back(middle);
+	_root = merge(left, right);
+}
+
+void vg::CompactVBIndexer::resize(GLuint pos, GLuint vc)
+{
+	if (pos >= size())
+		throw block_index_out_of_range(size(), pos);
+	set_vertex_count(_root, pos, vc);
 }
 
 void vg::CompactVBIndexer::swap(GLuint pos1, GLuint pos2)
 {
-	if (pos2 < pos1)
-		std::swap(pos1, pos2);
-	else if (pos1 == pos2)
+	if (pos1 == pos2)
 		return;
+	GLuint vc1 = vertex_count(pos1);
+	GLuint vc2 = vertex_count(pos2);
+	set_vertex_count(_root, pos1, vc2);
+	set_vertex_count(_root, pos2, vc1);
+}
+
+void vg::CompactVBIndexer::clear()
+{
+	_nodes.clear();
+	_free_nodes.clear();
+	_root = NIL;
+}
 
-	GLint vc_diff = (GLint)indexes[pos2].vertex_count - (GLint)indexes[pos1].vertex_count;
-	std::swap(indexes[pos1].vertex_count, indexes[pos2].vertex_count);
-	for (GLuint i = pos1 + 1; i <= pos2; ++i)
-		indexes[i].vertex_offset += vc_diff;
+void vg::CompactVBIndexer::insert(GLuint pos, GLuint vc, CPUVertexBuffer& vb)
+{
+	GLuint first = pos == size() ? vertex_count() : vertex_offset(pos);
+	vb.insert_vertices(first, vc);
+	insert(pos, vc);
+}
+
+void vg::CompactVBIndexer::erase(GLuint pos, CPUVertexBuffer& vb)
+{
+	vb.erase_vertices(vertex_offset(pos), vertex_count(pos));
+	erase(pos);
+}
+
+void vg::CompactVBIndexer::resize(GLuint pos, GLuint vc, CPUVertexBuffer& vb)
+{
+	GLuint first = vertex_offset(pos);
+	GLuint old_vc = vertex_count(pos);
+	if (vc < old_vc)
+		vb.erase_vertices(first + vc, old_vc - vc);
+	else if (vc > old_vc)
+		vb.insert_vertices(first + old_vc, vc - old_vc);
+	resize(pos, vc);
 }
@@ -1,16 +1,23 @@
 #pragma once
 
 #include <array>
+#include <map>
+#include <memory>
 
 #include "raii/GLBuffer.h"
 #include "raii/Shader.h"
+#include "StreamBuffer.h"
+#include "GPUHeap.h"
+#include "utils/DirtyRanges.h"
+#include "utils/Strided.h"
+#include "utils/Packing.h"
 
 namespace vg
 {
 	class VertexAttribute
 	{
 	public:
-		enum DataType : char
+		enum DataType : short
 		{
 			CHAR = GL_BYTE - GL_BYTE,
 			UCHAR = GL_UNSIGNED_BYTE - GL_BYTE,
@@ -21,7 +28,10 @@ namespace vg
 			HALF = GL_HALF_FLOAT - GL_BYTE,
 			FLOAT = GL_FLOAT - GL_BYTE,
 			DOUBLE = GL_DOUBLE - GL_BYTE,
-			FIXED = GL_FIXED - GL_BYTE
+			FIXED = GL_FIXED - GL_BYTE,
+			// Packed: one 32-bit word holds x, y, z in 10 bits each and w in 2. Always fetched as 4 components.
+			INT_2_10_10_10_REV = GL_INT_2_10_10_10_REV - GL_BYTE,
+			UINT_2_10_10_10_REV = GL_UNSIGNED_INT_2_10_10_10_REV - GL_BYTE
 		};
 
 		enum class IntegerCase : char
@@ -44,14 +54,30 @@ namespace vg
 		
 		void attrib_pointer(GLuint i, GLsizei stride) const;
 		void attrib_pointer(GLuint i, GLsizei stride, GLuint offset) const;
+#if VANGUARD_MIN_OPENGL_VERSION_IS_AT_LEAST(4, 3)
+		void attrib_format(ids::VertexArray vao, GLuint i, GLuint binding, GLuint relative_offset) const;
+#endif
 		GLsizei bytes() const;
+		bool is_packed() const { return type == DataType::INT_2_10_10_10_REV || type == DataType::UINT_2_10_10_10_REV; }
+		bool is_integer() const { return type != DataType::FLOAT && type != DataType::HALF && !is_packed() && integer_case == IntegerCase::INTEGER; }
+		GLint components() const { return is_packed() ? 4 : rows; }
+		DataType get_type() const { return type; }
+		IntegerCase get_integer_case() const { return integer_case; }
+		GLubyte get_rows() const { return rows; }
+		GLushort get_location() const { return location; }
+		// The encoding that writes float vectors of the given component count into this attribute's storage. Throws unless the attribute is fetched as float from float, half or
+		// normalized integer storage with at least that many components.
+		packing::Encoding encoding(GLuint components) const;
 		void set_type(DataType type) { this->type = type; }
 		void set_integer_case(IntegerCase integer_case) { this->integer_case = integer_case; }
 		void set_instance_divisor(GLuint instance_divisor) { this->instance_divisor = instance_divisor; }
 		GLuint get_offset() const { return offset; }
+		GLuint get_instance_divisor() const { return instance_divisor; }
 		GLenum type_as_gl_enum() const { return (GLenum)type + GL_BYTE; }
 
 		static GLuint location_coverage(ShaderAttribute attrib);
+
+		bool operator==(const VertexAttribute&) const = default;
 	};
 
 	struct VertexAttributeSpecificationList
@@ -61,10 +87,57 @@ namespace vg
 		std::vector<std::pair<GLuint, GLuint>> instance_divisor = {};
 	};
 
+	// VertexFormat is a VAO that only describes attribute formats, for one arrangement of a layout's attributes into buffer blocks. Buffers are swapped in with bind_vertex_buffer(),
+	// so every vertex buffer with the same layout and arrangement can share one VAO, and switching between them costs a buffer binding instead of a VAO switch.
+	// Each block gets one binding point per distinct instance divisor among its attributes.
+	class VertexFormat
+	{
+		raii::VertexArray _vao;
+		std::vector<GLuint> _offsets;
+		std::vector<GLsizei> _strides;
+		std::vector<GLuint> _first_bindings;
+		std::vector<std::vector<GLuint>> _blocks;
+#if !VANGUARD_MIN_OPENGL_VERSION_IS_AT_LEAST(4, 3)
+		// Without separate attribute formats, swapping a buffer in respecifies the pointers of its block's attributes.
+		std::vector<VertexAttribute> _attributes;
+#endif
+
+	public:
+		VertexFormat(const std::vector<VertexAttribute>& attributes, const std::vector<std::vector<GLuint>>& blocks);
+		VertexFormat(const VertexFormat&) = delete;
+		VertexFormat(VertexFormat&&) noexcept = default;
+		VertexFormat& operator=(VertexFormat&&) noexcept = default;
+
+		ids::VertexArray vao() const { return _vao; }
+		void bind_vao() const { _vao.bind(); }
+		GLuint block_count() const { return (GLuint)_strides.size(); }
+		GLsizei stride(GLuint block) const { return _strides[block]; }
+		GLuint offset(GLuint attrib) const { return _offsets[attrib]; }
+		GLuint attribute_count() const { return (GLuint)_offsets.size(); }
+		const std::vector<GLuint>& block_attributes(GLuint block) const { return _blocks[block]; }
+		void bind_vertex_buffer(GLuint block, ids::GLBuffer vb, GLintptr offset = 0) const;
+	};
+
+	class VertexBufferLayout;
+
+	// layouts hash-conses VertexBufferLayouts: every request with the same shader inputs and specifications, and every layout that ends up with the same attributes and stride,
+	// returns the same shared layout, and so the same VertexFormats. Each canonical layout gets a small id, unique for the life of the process, to use as a sort or batch key.
+	// The registry only holds weak references, so a layout and its VAOs are still destroyed with the last buffer that uses it.
+	namespace layouts
+	{
+		extern std::shared_ptr<VertexBufferLayout> canonical(const Shader& shader, const VertexAttributeSpecificationList& specifications = {});
+		extern std::shared_ptr<VertexBufferLayout> canonical(VertexBufferLayout&& layout);
+		extern size_t live_count();
+	}
+
 	class VertexBufferLayout
 	{
 		std::vector<VertexAttribute> _attributes;
 		GLuint _stride = 0;
+		GLuint _id = 0;
+		mutable std::map<std::vector<std::vector<GLuint>>, VertexFormat> _formats;
+
+		friend std::shared_ptr<VertexBufferLayout> layouts::canonical(VertexBufferLayout&& layout);
 
 	public:
 		VertexBufferLayout(const Shader& shader);
@@ -74,18 +147,34 @@ namespace vg
 		const std::vector<VertexAttribute>& attributes() const { return _attributes; }
 		void attrib_pointer(GLuint attrib) const;
 		void unattrib_pointer(GLuint attrib) const;
+		const VertexFormat& format() const;
+		const VertexFormat& format(const std::vector<std::vector<GLuint>>& blocks) const;
 
 		GLintptr buffer_offset(GLuint vertex, GLuint attrib) const;
+
+		// 0 unless the layout came from layouts::canonical(). Canonical layouts with equal ids are the same object.
+		GLuint id() const { return _id; }
+		size_t hash() const;
+		// Same attributes and stride; ids and cached formats are not compared.
+		bool operator==(const VertexBufferLayout& other) const { return _stride == other._stride && _attributes == other._attributes; }
 	};
 
+	class CPUIndexBuffer;
+
 	// Use VertexBuffer for sole attachments to a VAO. In other words, a VertexBuffer stores all attributes in a VertexBufferLayout.
+	// The VAO is the layout's shared VertexFormat, so bind_vao() swaps this buffer and its attached index buffer into it.
 	class VertexBuffer
 	{
 		std::shared_ptr<VertexBufferLayout> _layout;
-		raii::VertexArray _vao;
+		const VertexFormat* _format = nullptr;
 		raii::GLBuffer _vb;
+		ids::GLBuffer _ib;
+		const CPUIndexBuffer* _tracked_ib = nullptr;
+#if VANGUARD_MIN_OPENGL_VERSION_IS_AT_LEAST(4, 4)
+		const StreamMirror* _stream = nullptr;
+#endif
 
-		void init() const;
+		void init();
 
 	public:
 		VertexBuffer(const std::shared_ptr<VertexBufferLayout>& layout);
@@ -95,10 +184,20 @@ namespace vg
 		VertexBuffer& operator=(VertexBuffer&&) noexcept = default;
 		
 		const std::shared_ptr<VertexBufferLayout>& layout() const { return _layout; }
-		ids::VertexArray vao() const { return _vao; }
-		ids::GLBuffer vb() const { return _vb; }
+		const VertexFormat& format() const { return *_format; }
+		ids::VertexArray vao() const { return _format->vao(); }
+		ids::GLBuffer vb() const;
 		void bind_vao() const;
 		void bind_vb() const;
+		void attach_index_buffer(ids::GLBuffer ib) { _ib = ib; _tracked_ib = nullptr; }
+		// Tracks ib rather than its current buffer name, so bind_vao() picks up the new storage after ib grows. ib must outlive this buffer and stay in place.
+		void attach_index_buffer(const CPUIndexBuffer& ib) { _tracked_ib = &ib; }
+		// Replaces the GL buffer with a new one of size bytes, keeping its first kept bytes. The shared VAO picks up the new buffer at the next bind_vao().
+		void reallocate(GLsizeiptr size, GLsizeiptr kept, bool is_mutable);
+#if VANGUARD_MIN_OPENGL_VERSION_IS_AT_LEAST(4, 4)
+		// Replaces the GL buffer with one without storage, and reads vertices from the current region of stream from then on. stream must outlive this buffer and stay in place.
+		void stream_from(const StreamMirror& stream);
+#endif
 
 		GLintptr buffer_offset(GLuint vertex, GLuint attrib) const;
 
@@ -123,23 +222,19 @@ namespace vg
 		template<typename Type>
 		void set_attribute(VoidArray& cpubuf, GLuint attrib, GLuint starting_vertex, GLuint count, const Type& obj)
 		{
-			for (GLuint i = 0; i < count; ++i)
-				cpubuf.ref<Type>(buffer_offset(starting_vertex + i, attrib)) = obj;
+			strided::fill(cpubuf, buffer_offset(starting_vertex, attrib), _layout->stride(), count, obj);
 		}
 
 		template<typename Type>
 		void set_attribute(VoidArray& cpubuf, GLuint attrib, const Type& obj)
 		{
-			GLuint vcount = vertex_count(cpubuf);
-			for (GLuint i = 0; i < vcount; ++i)
-				cpubuf.ref<Type>(buffer_offset(i, attrib)) = obj;
+			strided::fill(cpubuf, buffer_offset(0, attrib), _layout->stride(), vertex_count(cpubuf), obj);
 		}
 
 		template<typename Type, size_t N>
 		void set_attributes(VoidArray& cpubuf, GLuint attrib, GLuint starting_vertex, const std::array<Type, N>& objs)
 		{
-			for (GLuint i = 0; i < N; ++i)
-				cpubuf.ref<Type>(buffer_offset(starting_vertex + i, attrib)) = objs[i];
+			strided::scatter(cpubuf, buffer_offset(starting_vertex, attrib), _layout->stride(), objs.data(), N);
 		}
 
 		VoidArray init_immutable_cpu_buffer(GLuint vertex_count) const;
@@ -150,29 +245,42 @@ namespace vg
 	};
 
 	// Use VertexBufferBlock for separated attachments to a VAO. In other words, a VertexBufferBlock's individual buffers each store different attributes in a VertexBufferLayout.
+	// Like VertexBuffer, the VAO is a VertexFormat shared with every VertexBufferBlock that arranges the same layout into blocks the same way.
 	class VertexBufferBlock
 	{
 		std::shared_ptr<VertexBufferLayout> _layout;
-		std::vector<GLuint> _strides;
-		std::vector<GLuint> _offsets;
-		raii::VertexArray _vao;
+		const VertexFormat* _format = nullptr;
 		raii::GLBufferBlock _vbs;
+		ids::GLBuffer _ib;
+		const CPUIndexBuffer* _tracked_ib = nullptr;
 
 		void init(const std::initializer_list<std::pair<GLuint, std::initializer_list<GLuint>>>& attributes);
 
 	public:
 		VertexBufferBlock(GLuint block_count, const std::shared_ptr<VertexBufferLayout>& layout, const std::initializer_list<std::pair<GLuint, std::initializer_list<GLuint>>>& attributes);
 		VertexBufferBlock(GLuint block_count, std::shared_ptr<VertexBufferLayout>&& layout, const std::initializer_list<std::pair<GLuint, std::initializer_list<GLuint>>>& attributes);
+		// Block i stores the attributes in blocks[i], for partitions chosen at runtime.
+		VertexBufferBlock(const std::shared_ptr<VertexBufferLayout>& layout, const std::vector<std::vector<GLuint>>& blocks);
 		VertexBufferBlock(const VertexBufferBlock&) = delete;
 		VertexBufferBlock(VertexBufferBlock&&) noexcept = default;
 		VertexBufferBlock& operator=(VertexBufferBlock&&) noexcept = default;
 
 		const std::shared_ptr<VertexBufferLayout>& layout() const { return _layout; }
-		ids::VertexArray vao() const { return _vao; }
+		const VertexFormat& format() const { return *_format; }
+		ids::VertexArray vao() const { return _format->vao(); }
 		ids::GLBuffer vb(GLuint i) const { return _vbs[i]; }
-		GLuint vb_stride(GLuint i) const { return _strides[i]; }
+		GLuint vb_stride(GLuint i) const { return _format->stride(i); }
 		void bind_vb(GLuint i) const;
 		void bind_vao() const;
+#if VANGUARD_MIN_OPENGL_VERSION_IS_AT_LEAST(4, 4)
+		// Binds the VAO to read block i from the current region of streams[i] instead of this block's own storage.
+		void bind_vao(const std::vector<StreamMirror>& streams) const;
+#endif
+		void attach_index_buffer(ids::GLBuffer ib) { _ib = ib; _tracked_ib = nullptr; }
+		// Tracks ib rather than its current buffer name, so bind_vao() picks up the new storage after ib grows. ib must outlive this buffer and stay in place.
+		void attach_index_buffer(const CPUIndexBuffer& ib) { _tracked_ib = &ib; }
+		// Replaces the GL buffers with ones without storage, for blocks that have moved into streams.
+		void release_storage();
 		GLuint block_count() const { return _vbs.get_count(); }
 		GLintptr buffer_offset(GLuint i, GLuint vertex, GLuint attrib) const;
 
@@ -197,23 +305,19 @@ namespace vg
 		template<typename Type>
 		void set_attribute(VoidArray& cpubuf, GLuint i, GLuint attrib, GLuint starting_vertex, GLuint count, const Type& obj)
 		{
-			for (GLuint v = 0; v < count; ++v)
-				cpubuf.ref<Type>(buffer_offset(i, starting_vertex + v, attrib)) = obj;
+			strided::fill(cpubuf, buffer_offset(i, starting_vertex, attrib), vb_stride(i), count, obj);
 		}
 
 		template<typename Type>
 		void set_attribute(VoidArray& cpubuf, GLuint i, GLuint attrib, const Type& obj)
 		{
-			GLuint vcount = vertex_count(i, cpubuf);
-			for (GLuint v = 0; v < vcount; ++v)
-				cpubuf.ref<Type>(buffer_offset(i, v, attrib)) = obj;
+			strided::fill(cpubuf, buffer_offset(i, 0, attrib), vb_stride(i), vertex_count(i, cpubuf), obj);
 		}
 
 		template<typename Type, size_t N>
 		void set_attributes(VoidArray& cpubuf, GLuint i, GLuint attrib, GLuint starting_vertex, const std::array<Type, N>& objs)
 		{
-			for (GLuint v = 0; v < N; ++v)
-				cpubuf.ref<Type>(buffer_offset(i, starting_vertex + v, attrib)) = objs[v];
+			strided::scatter(cpubuf, buffer_offset(i, starting_vertex, attrib), vb_stride(i), objs.data(), N);
 		}
 
 		VoidArray init_immutable_cpu_buffer(GLuint i, GLuint vertex_count) const;
@@ -224,13 +328,14 @@ namespace vg
 	};
 
 	// Use MultiVertexBuffer for a group of sole attachments to a group of VAOs. In other words, a MultiVertexBuffer is just a fixed-size vector of VertexBuffer-VertexArray pairs that are stored optimally in GPU/CPU memory.
+	// Buffers with the same layout share that layout's VertexFormat, so bind_vao(i) swaps buffer i into it.
 	class MultiVertexBuffer
 	{
 		std::vector<std::shared_ptr<VertexBufferLayout>> _layouts;
-		raii::VertexArrayBlock _vaos;
+		std::vector<const VertexFormat*> _formats;
 		raii::GLBufferBlock _vbs;
 
-		void init() const;
+		void init();
 
 	public:
 		MultiVertexBuffer(const std::vector<std::shared_ptr<VertexBufferLayout>>& layouts);
@@ -241,7 +346,7 @@ namespace vg
 		MultiVertexBuffer& operator=(MultiVertexBuffer&&) noexcept = default;
 
 		const std::shared_ptr<VertexBufferLayout>& layout(GLuint i) const { return _layouts[i]; }
-		ids::VertexArray vao(GLuint i) const { return _vaos[i]; }
+		ids::VertexArray vao(GLuint i) const { return _formats[i]->vao(); }
 		ids::GLBuffer vb(GLuint i) const { return _vbs[i]; }
 		void bind_vao(GLuint i) const;
 		void bind_vb(GLuint i) const;
@@ -270,23 +375,19 @@ namespace vg
 		template<typename Type>
 		void set_attribute(GLuint i, VoidArray& cpubuf, GLuint attrib, GLuint starting_vertex, GLuint count, const Type& obj)
 		{
-			for (GLuint v = 0; v < count; ++v)
-				cpubuf.ref<Type>(buffer_offset(i, starting_vertex + v, attrib)) = obj;
+			strided::fill(cpubuf, buffer_offset(i, starting_vertex, attrib), _layouts[i]->stride(), count, obj);
 		}
 
 		template<typename Type>
 		void set_attribute(GLuint i, VoidArray& cpubuf, GLuint attrib, const Type& obj)
 		{
-			GLuint vcount = vertex_count(i, cpubuf);
-			for (GLuint v = 0; v < vcount; ++v)
-				cpubuf.ref<Type>(buffer_offset(i, v, attrib)) = obj;
+			strided::fill(cpubuf, buffer_offset(i, 0, attrib), _layouts[i]->stride(), vertex_count(i, cpubuf), obj);
 		}
 
 		template<typename Type, size_t N>
 		void set_attributes(GLuint i, VoidArray& cpubuf, GLuint attrib, GLuint starting_vertex, const std::array<Type, N>& objs)
 		{
-			for (GLuint v = 0; v < N; ++v)
-				cpubuf.ref<Type>(buffer_offset(i, starting_vertex + v, attrib)) = objs[v];
+			strided::scatter(cpubuf, buffer_offset(i, starting_vertex, attrib), _layouts[i]->stride(), objs.data(), N);
 		}
 
 		VoidArray init_immutable_cpu_buffer(GLuint i, GLuint vertex_count) const;
@@ -302,7 +403,7 @@ namespace vg
 		IndexDataType idt;
 
 	public:
-		IndexBuffer(IndexDataType idt) : idt(idt) {}
+		IndexBuffer(IndexDataType idt) : idt(idt) { buffers::set_category(_ib, MemoryCategory::INDEX_BUFFER); }
 
 		ids::GLBuffer ib() const { return _ib; }
 		void bind_to_vertex_array(ids::VertexArray va) const { bind_index_buffer_to_vertex_array(_ib, va); }
@@ -310,8 +411,8 @@ namespace vg
 		IndexDataType data_type() const { return idt; }
 		GLsizei query_size() const { return GLsizei(buffers::size(_ib) / index_data_type_size(idt)); }
 
-		void init_immutable(const void* cpubuf, GLsizei size) const { bind(); buffers::init_immutable(BufferTarget::INDEX, size, cpubuf); }
-		void init_mutable(const void* cpubuf, GLsizei size) const { bind(); buffers::init_mutable(BufferTarget::INDEX, size, cpubuf); }
+		void init_immutable(const void* cpubuf, GLsizei size) const { buffers::init_immutable(_ib, size, cpubuf); }
+		void init_mutable(const void* cpubuf, GLsizei size) const { buffers::init_mutable(_ib, size, cpubuf); }
 	};
 
 	class IndexBufferBlock
@@ -320,8 +421,8 @@ namespace vg
 		std::vector<IndexDataType> _idts;
 
 	public:
-		IndexBufferBlock(const std::vector<IndexDataType>& idts) : _ibs((GLuint)idts.size()), _idts(idts) {}
-		IndexBufferBlock(std::vector<IndexDataType>&& idts) : _ibs((GLuint)idts.size()), _idts(std::move(idts)) {}
+		IndexBufferBlock(const std::vector<IndexDataType>& idts) : _ibs((GLuint)idts.size()), _idts(idts) { buffers::set_category(_ibs, MemoryCategory::INDEX_BUFFER); }
+		IndexBufferBlock(std::vector<IndexDataType>&& idts) : _ibs((GLuint)idts.size()), _idts(std::move(idts)) { buffers::set_category(_ibs, MemoryCategory::INDEX_BUFFER); }
 
 		ids::GLBuffer ib(GLuint i) const { return _ibs[i]; }
 		void bind_to_vertex_array(GLuint i, ids::VertexArray va) const { bind_index_buffer_to_vertex_array(_ibs[i], va); }
@@ -329,18 +430,25 @@ namespace vg
 		IndexDataType data_type(GLuint i) const { return _idts[i]; }
 		GLsizei query_size(GLuint i) const { return GLsizei(buffers::size(_ibs[i]) / index_data_type_size(_idts[i])); }
 
-		void init_immutable(GLuint i, const void* cpubuf, GLsizei size) const { bind(i); buffers::init_immutable(BufferTarget::INDEX, size, cpubuf); }
-		void init_mutable(GLuint i, const void* cpubuf, GLsizei size) const { bind(i); buffers::init_mutable(BufferTarget::INDEX, size, cpubuf); }
+		void init_immutable(GLuint i, const void* cpubuf, GLsizei size) const { buffers::init_immutable(_ibs[i], size, cpubuf); }
+		void init_mutable(GLuint i, const void* cpubuf, GLsizei size) const { buffers::init_mutable(_ibs[i], size, cpubuf); }
 	};
 
+	// CPUIndexBuffer's GL storage has a capacity in indices. init_*() size it to the CPU copy, and reserve(), resize() and push_back() grow it geometrically, copying the
+	// existing indices across on the GPU. Growing replaces the buffer name, so attach it to vertex buffers with attach_index_buffer(const CPUIndexBuffer&).
 	class CPUIndexBuffer
 	{
 		raii::GLBuffer _ib;
 		IndexDataType idt;
 		VoidArray cpubuf;
+		GLsizei _capacity = 0;
+		bool _is_mutable = true;
+		UploadStrategy _upload_strategy = UploadStrategy::SUBDATA;
+
+		void allocate(GLsizei capacity, GLsizei kept, bool is_mutable);
 
 	public:
-		CPUIndexBuffer(IndexDataType idt) : idt(idt) {}
+		CPUIndexBuffer(IndexDataType idt) : idt(idt) { buffers::set_category(_ib, MemoryCategory::INDEX_BUFFER); }
 
 		const VoidArray& buffer() const { return cpubuf; }
 		VoidArray& buffer() { return cpubuf; }
@@ -350,13 +458,25 @@ namespace vg
 		IndexDataType data_type() const { return idt; }
 		GLsizei size() const { return GLsizei(cpubuf.size() / index_data_type_size(idt)); }
 
+		GLsizei capacity() const { return _capacity; }
+
 		void init_immutable(GLsizei count) { cpubuf.resize(count * index_data_type_size(idt)); init_immutable(); }
-		void init_immutable() { bind(); buffers::init_immutable(BufferTarget::INDEX, cpubuf.size(), cpubuf); }
+		void init_immutable();
 		void init_mutable(GLsizei count) { cpubuf.resize(count * index_data_type_size(idt)); init_mutable(); }
-		void init_mutable() { bind(); buffers::init_mutable(BufferTarget::INDEX, cpubuf.size(), cpubuf); }
+		void init_mutable();
 
 		void init_immutable_quads(GLuint num_quads);
 		void init_mutable_quads(GLuint num_quads);
+
+		void reserve(GLsizei capacity);
+		// New indices are left for the caller to write and subsend().
+		void resize(GLsizei count);
+		void push_back(const void* indices, GLsizei count);
+		void subsend(GLsizei first, GLsizei count) const;
+
+		// Used by subsend() while the storage is mutable. Immutable storage is created without MAP_WRITE, so it always uploads with SUBDATA.
+		void set_upload_strategy(UploadStrategy strategy) { _upload_strategy = strategy; }
+		UploadStrategy upload_strategy() const { return _upload_strategy; }
 	};
 
 	class CPUIndexBufferBlock
@@ -384,30 +504,83 @@ namespace vg
 		void init_mutable_quads(GLuint i, GLuint num_quads);
 	};
 
+	class CPUVertexBufferBlock;
+
 	class CPUVertexBuffer
 	{
 		VertexBuffer _vb;
 		VoidArray _cpubuf;
 		GLuint _vertex_count;
+		GLuint _vertex_capacity;
+		bool _is_mutable;
+		UploadStrategy _upload_strategy = UploadStrategy::SUBDATA;
+		mutable DirtyRanges _dirty;
+#if VANGUARD_MIN_OPENGL_VERSION_IS_AT_LEAST(4, 4)
+		// Heap allocated, so the VertexBuffer's pointer to it survives moves.
+		std::unique_ptr<StreamMirror> _stream;
+#endif
+
+		void upload(size_t offset, size_t bytes) const;
 
 	public:
 		CPUVertexBuffer(VertexBuffer&& vb, GLuint vertex_count, bool is_mutable);
+		CPUVertexBuffer(VertexBuffer&& vb, const CPUVertexBufferBlock& source, bool is_mutable);
 
 		const std::shared_ptr<VertexBufferLayout>& layout() const { return _vb.layout(); }
+		const VertexBuffer& vertex_buffer() const { return _vb; }
+		const VoidArray& buffer() const { return _cpubuf; }
 		ids::VertexArray vao() const { return _vb.vao(); }
 		ids::GLBuffer vb() const { return _vb.vb(); }
 		void bind_vao() const { _vb.bind_vao(); }
 		void bind_vb() const { _vb.bind_vb(); }
+		void attach_index_buffer(ids::GLBuffer ib) { _vb.attach_index_buffer(ib); }
+		void attach_index_buffer(const CPUIndexBuffer& ib) { _vb.attach_index_buffer(ib); }
 
 		GLintptr buffer_offset(GLuint vertex, GLuint attrib) const { return _vb.buffer_offset(vertex, attrib); }
 
 		GLuint vertex_count() const { return _vertex_count; }
+		// Vertices the GPU buffer was allocated for.
+		GLuint vertex_capacity() const { return _vertex_capacity; }
+
+		// Used by the subsend functions and flush() while the storage is mutable. Immutable storage is created without MAP_WRITE, so it always uploads with SUBDATA.
+		// Under ORPHAN every upload rewrites the whole buffer, so pair it with buffers that change all over each frame. While the buffer has spare vertex capacity,
+		// the spare tail has no CPU copy, so ORPHAN uploads fall back to INVALIDATE.
+		void set_upload_strategy(UploadStrategy strategy) { _upload_strategy = strategy; }
+		UploadStrategy upload_strategy() const { return _upload_strategy; }
+
+#if VANGUARD_MIN_OPENGL_VERSION_IS_AT_LEAST(4, 4)
+		// Moves the GPU copy into frames_in_flight regions of persistently mapped storage. flush() and the subsend functions then memcpy into a region instead of calling
+		// glBufferSubData, moving on to the next region, after waiting on its fence, once bind_vao() has bound the current one. Draws see a flush from the next bind_vao(),
+		// so flush once per frame before binding for the frame's draws. The upload strategy no longer applies.
+		void stream(GLuint frames_in_flight = 3);
+#endif
+		bool is_streaming() const;
 
 		void subsend_full() const;
 		void subsend(size_t offset, size_t bytes) const;
 		void subsend_single(GLuint vertex) const;
 		void subsend_single(GLuint vertex, GLuint attrib) const;
 
+		// Removes count vertices at first. Later vertices move down with memmove on the CPU copy and buffer-to-buffer copies on the GPU, so nothing is re-uploaded,
+		// unless the tail is so much longer than the gap that the copies would outnumber one upload, in which case the moved tail is marked dirty instead.
+		void erase_vertices(GLuint first, GLuint count);
+		// Opens count zeroed vertices at first, moving later vertices up the same way. The new vertices are marked dirty.
+		void insert_vertices(GLuint first, GLuint count);
+
+		// Growing past vertex_capacity() reallocates the GL buffer and copies the existing vertices across on the GPU. resize() and push_back_vertices() grow it geometrically,
+		// so streaming geometry doesn't need a worst-case allocation up front.
+		void reserve(GLuint vertex_capacity);
+		// New vertices are zeroed and marked dirty.
+		void resize(GLuint vertex_count);
+		// Appends count vertices, zeroed or copied from vertices (interleaved, layout stride), and returns the first one.
+		GLuint push_back_vertices(GLuint count);
+		GLuint push_back_vertices(const void* vertices, GLuint count);
+
+		// Writes through the mutable accessors are recorded as dirty ranges, and flush() uploads them with one glBufferSubData per disjoint range. Use mark_dirty() after writing through at().
+		void mark_dirty(size_t offset_bytes, size_t bytes) { _dirty.mark(offset_bytes, bytes); }
+		bool is_dirty() const { return !_dirty.empty(); }
+		void flush();
+
 		template<typename Type>
 		const Type& ref(GLuint vertex, GLuint attrib) const
 		{
@@ -417,7 +590,10 @@ namespace vg
 		template<typename Type>
 		Type& ref(GLuint vertex, GLuint attrib)
 		{
-			return _cpubuf.ref<Type>(buffer_offset(vertex, attrib));
+			GLintptr offset = buffer_offset(vertex, attrib);
+			Type& obj = _cpubuf.ref<Type>(offset);
+			_dirty.mark(offset, sizeof(Type));
+			return obj;
 		}
 
 		template<typename Type>
@@ -429,7 +605,9 @@ namespace vg
 		template<typename Type>
 		Type& ref(size_t offset_bytes)
 		{
-			return _cpubuf.ref<Type>(offset_bytes);
+			Type& obj = _cpubuf.ref<Type>(offset_bytes);
+			_dirty.mark(offset_bytes, sizeof(Type));
+			return obj;
 		}
 
 		template<typename Type>
@@ -457,22 +635,64 @@ namespace vg
 		template<typename Type>
 		void set_attribute(GLuint attrib, GLuint starting_vertex, GLuint count, const Type& obj)
 		{
-			for (GLuint i = 0; i < count; ++i)
-				_cpubuf.ref<Type>(buffer_offset(starting_vertex + i, attrib)) = obj;
+			GLintptr offset = buffer_offset(starting_vertex, attrib);
+			strided::fill(_cpubuf, offset, _vb.layout()->stride(), count, obj);
+			_dirty.mark(offset, strided::span(_vb.layout()->stride(), count, sizeof(Type)));
 		}
 
 		template<typename Type>
 		void set_attribute(GLuint attrib, const Type& obj)
 		{
-			for (GLuint i = 0; i < _vertex_count; ++i)
-				_cpubuf.ref<Type>(buffer_offset(i, attrib)) = obj;
+			set_attribute(attrib, 0, _vertex_count, obj);
+		}
+
+		template<typename Type>
+		void set_attributes(GLuint attrib, GLuint starting_vertex, const Type* objs, GLuint count)
+		{
+			GLintptr offset = buffer_offset(starting_vertex, attrib);
+			strided::scatter(_cpubuf, offset, _vb.layout()->stride(), objs, count);
+			_dirty.mark(offset, strided::span(_vb.layout()->stride(), count, sizeof(Type)));
 		}
 
 		template<typename Type, size_t N>
 		void set_attributes(GLuint attrib, GLuint starting_vertex, const std::array<Type, N>& objs)
 		{
-			for (GLuint i = 0; i < N; ++i)
-				_cpubuf.ref<Type>(buffer_offset(starting_vertex + i, attrib)) = objs[i];
+			set_attributes(attrib, starting_vertex, objs.data(), (GLuint)N);
+		}
+
+		template<typename Type>
+		void get_attributes(GLuint attrib, GLuint starting_vertex, Type* objs, GLuint count) const
+		{
+			strided::gather(_cpubuf, buffer_offset(starting_vertex, attrib), _vb.layout()->stride(), objs, count);
+		}
+
+		// Writes float vectors into an attribute stored as half, normalized integers or 2_10_10_10_REV, encoding them on the way in.
+		template<glm::length_t L>
+		void set_encoded_attributes(GLuint attrib, GLuint starting_vertex, const glm::vec<L, float>* objs, GLuint count)
+		{
+			const VertexAttribute& a = _vb.layout()->attributes()[attrib];
+			packing::Encoding encoding = a.encoding(L);
+			GLintptr offset = buffer_offset(starting_vertex, attrib);
+			strided::check_span(_cpubuf, offset, _vb.layout()->stride(), count, a.bytes());
+			if (count == 0)
+				return;
+			packing::encode(encoding, L, _cpubuf.at(offset), _vb.layout()->stride(), glm::value_ptr(objs[0]), count);
+			_dirty.mark(offset, strided::span(_vb.layout()->stride(), count, a.bytes()));
+		}
+
+		template<glm::length_t L>
+		void set_encoded_attribute(GLuint attrib, GLuint starting_vertex, GLuint count, const glm::vec<L, float>& obj)
+		{
+			const VertexAttribute& a = _vb.layout()->attributes()[attrib];
+			packing::Encoding encoding = a.encoding(L);
+			char encoded[sizeof(glm::vec4)];
+			packing::encode(encoding, L, encoded, 0, glm::value_ptr(obj), 1);
+			GLintptr offset = buffer_offset(starting_vertex, attrib);
+			strided::check_span(_cpubuf, offset, _vb.layout()->stride(), count, a.bytes());
+			if (count == 0)
+				return;
+			strided::fill(_cpubuf.at(offset), _vb.layout()->stride(), count, encoded, packing::encoded_size(encoding, L));
+			_dirty.mark(offset, strided::span(_vb.layout()->stride(), count, a.bytes()));
 		}
 	};
 
@@ -480,29 +700,53 @@ namespace vg
 	{
 		VertexBufferBlock _vbb;
 		std::vector<std::pair<VoidArray, GLuint>> _cpubuf_and_vcs;
+		mutable std::vector<DirtyRanges> _dirty;
+#if VANGUARD_MIN_OPENGL_VERSION_IS_AT_LEAST(4, 4)
+		// One per block while streaming.
+		mutable std::vector<StreamMirror> _streams;
+#endif
+
+		void upload(GLuint i, size_t offset, size_t bytes) const;
 
 	public:
 		CPUVertexBufferBlock(VertexBufferBlock&& vbb, const std::vector<GLuint>& vertex_counts, const std::vector<bool>& is_mutables);
 		CPUVertexBufferBlock(VertexBufferBlock&& vbb, GLuint vertex_count, const std::vector<bool>& is_mutables);
 		CPUVertexBufferBlock(VertexBufferBlock&& vbb, const std::vector<GLuint>& vertex_counts, bool is_mutable);
 		CPUVertexBufferBlock(VertexBufferBlock&& vbb, GLuint vertex_count, bool is_mutable);
+		CPUVertexBufferBlock(VertexBufferBlock&& vbb, const CPUVertexBuffer& source, bool is_mutable);
 
 		const std::shared_ptr<VertexBufferLayout>& layout() const { return _vbb.layout(); }
+		const VertexBufferBlock& vertex_buffer_block() const { return _vbb; }
+		const VoidArray& buffer(GLuint i) const { return _cpubuf_and_vcs[i].first; }
 		ids::VertexArray vao() const { return _vbb.vao(); }
-		ids::GLBuffer vb(GLuint i) const { return _vbb.vb(i); }
-		void bind_vao() const { _vbb.bind_vao(); }
-		void bind_vb(GLuint i) const { _vbb.bind_vb(i); }
+		ids::GLBuffer vb(GLuint i) const;
+		void bind_vao() const;
+		void bind_vb(GLuint i) const;
+		void attach_index_buffer(ids::GLBuffer ib) { _vbb.attach_index_buffer(ib); }
+		void attach_index_buffer(const CPUIndexBuffer& ib) { _vbb.attach_index_buffer(ib); }
 
 		GLintptr buffer_offset(GLuint i, GLuint vertex, GLuint attrib) const { return _vbb.buffer_offset(i, vertex, attrib); }
 
 		GLuint vertex_count(GLuint i) const { return _cpubuf_and_vcs[i].second; }
 		GLuint block_count() const { return _vbb.block_count(); }
 
+#if VANGUARD_MIN_OPENGL_VERSION_IS_AT_LEAST(4, 4)
+		// Streams every block, as CPUVertexBuffer::stream() does.
+		void stream(GLuint frames_in_flight = 3);
+#endif
+		bool is_streaming() const;
+
 		void subsend_full(GLuint i) const;
 		void subsend_all_blocks() const;
 		void subsend(GLuint i, size_t offset, size_t bytes) const;
 		void subsend_single(GLuint i, GLuint vertex, GLuint attrib) const;
 
+		// Writes through the mutable accessors are recorded as dirty ranges per buffer, and flush() uploads them with one glBufferSubData per disjoint range. Use mark_dirty() after writing through at().
+		void mark_dirty(GLuint i, size_t offset_bytes, size_t bytes) { _dirty[i].mark(offset_bytes, bytes); }
+		bool is_dirty(GLuint i) const { return !_dirty[i].empty(); }
+		void flush(GLuint i);
+		void flush();
+
 		template<typename Type>
 		const Type& ref(GLuint i, GLuint vertex, GLuint attrib) const
 		{
@@ -512,7 +756,10 @@ namespace vg
 		template<typename Type>
 		Type& ref(GLuint i, GLuint vertex, GLuint attrib)
 		{
-			return _cpubuf_and_vcs[i].first.ref<Type>(buffer_offset(i, vertex, attrib));
+			GLintptr offset = buffer_offset(i, vertex, attrib);
+			Type& obj = _cpubuf_and_vcs[i].first.ref<Type>(offset);
+			_dirty[i].mark(offset, sizeof(Type));
+			return obj;
 		}
 
 		template<typename Type>
@@ -524,7 +771,9 @@ namespace vg
 		template<typename Type>
 		Type& ref(GLuint i, size_t offset_bytes)
 		{
-			return _cpubuf_and_vcs[i].first.ref<Type>(offset_bytes);
+			Type& obj = _cpubuf_and_vcs[i].first.ref<Type>(offset_bytes);
+			_dirty[i].mark(offset_bytes, sizeof(Type));
+			return obj;
 		}
 
 		template<typename Type>
@@ -552,23 +801,64 @@ namespace vg
 		template<typename Type>
 		void set_attribute(GLuint i, GLuint attrib, GLuint starting_vertex, GLuint count, const Type& obj)
 		{
-			for (GLuint n = 0; n < count; ++n)
-				_cpubuf_and_vcs[i].first.ref<Type>(buffer_offset(i, starting_vertex + n, attrib)) = obj;
+			GLintptr offset = buffer_offset(i, starting_vertex, attrib);
+			strided::fill(_cpubuf_and_vcs[i].first, offset, _vbb.vb_stride(i), count, obj);
+			_dirty[i].mark(offset, strided::span(_vbb.vb_stride(i), count, sizeof(Type)));
 		}
 
 		template<typename Type>
 		void set_attribute(GLuint i, GLuint attrib, const Type& obj)
 		{
-			GLuint vertex_count = _cpubuf_and_vcs[i].second;
-			for (GLuint n = 0; n < vertex_count; ++n)
-				_cpubuf_and_vcs[i].first.ref<Type>(buffer_offset(i, n, attrib)) = obj;
+			set_attribute(i, attrib, 0, _cpubuf_and_vcs[i].second, obj);
+		}
+
+		template<typename Type>
+		void set_attributes(GLuint i, GLuint attrib, GLuint starting_vertex, const Type* objs, GLuint count)
+		{
+			GLintptr offset = buffer_offset(i, starting_vertex, attrib);
+			strided::scatter(_cpubuf_and_vcs[i].first, offset, _vbb.vb_stride(i), objs, count);
+			_dirty[i].mark(offset, strided::span(_vbb.vb_stride(i), count, sizeof(Type)));
 		}
 
 		template<typename Type, size_t N>
 		void set_attributes(GLuint i, GLuint attrib, GLuint starting_vertex, const std::array<Type, N>& objs)
 		{
-			for (GLuint n = 0; n < N; ++n)
-				_cpubuf_and_vcs[i].first.ref<Type>(buffer_offset(i, starting_vertex + n, attrib)) = objs[n];
+			set_attributes(i, attrib, starting_vertex, objs.data(), (GLuint)N);
+		}
+
+		template<typename Type>
+		void get_attributes(GLuint i, GLuint attrib, GLuint starting_vertex, Type* objs, GLuint count) const
+		{
+			strided::gather(_cpubuf_and_vcs[i].first, buffer_offset(i, starting_vertex, attrib), _vbb.vb_stride(i), objs, count);
+		}
+
+		// Writes float vectors into an attribute stored as half, normalized integers or 2_10_10_10_REV, encoding them on the way in.
+		template<glm::length_t L>
+		void set_encoded_attributes(GLuint i, GLuint attrib, GLuint starting_vertex, const glm::vec<L, float>* objs, GLuint count)
+		{
+			const VertexAttribute& a = _vbb.layout()->attributes()[attrib];
+			packing::Encoding encoding = a.encoding(L);
+			GLintptr offset = buffer_offset(i, starting_vertex, attrib);
+			strided::check_span(_cpubuf_and_vcs[i].first, offset, _vbb.vb_stride(i), count, a.bytes());
+			if (count == 0)
+				return;
+			packing::encode(encoding, L, _cpubuf_and_vcs[i].first.at(offset), _vbb.vb_stride(i), glm::value_ptr(objs[0]), count);
+			_dirty[i].mark(offset, strided::span(_vbb.vb_stride(i), count, a.bytes()));
+		}
+
+		template<glm::length_t L>
+		void set_encoded_attribute(GLuint i, GLuint attrib, GLuint starting_vertex, GLuint count, const glm::vec<L, float>& obj)
+		{
+			const VertexAttribute& a = _vbb.layout()->attributes()[attrib];
+			packing::Encoding encoding = a.encoding(L);
+			char encoded[sizeof(glm::vec4)];
+			packing::encode(encoding, L, encoded, 0, glm::value_ptr(obj), 1);
+			GLintptr offset = buffer_offset(i, starting_vertex, attrib);
+			strided::check_span(_cpubuf_and_vcs[i].first, offset, _vbb.vb_stride(i), count, a.bytes());
+			if (count == 0)
+				return;
+			strided::fill(_cpubuf_and_vcs[i].first.at(offset), _vbb.vb_stride(i), count, encoded, packing::encoded_size(encoding, L));
+			_dirty[i].mark(offset, strided::span(_vbb.vb_stride(i), count, a.bytes()));
 		}
 	};
 
@@ -576,6 +866,7 @@ namespace vg
 	{
 		MultiVertexBuffer _vbs;
 		std::vector<std::pair<VoidArray, GLuint>> _cpubuf_and_vcs;
+		mutable std::vector<DirtyRanges> _dirty;
 
 	public:
 		MultiCPUVertexBuffer(MultiVertexBuffer&& vbs, const std::vector<GLuint>& vertex_counts, const std::vector<bool>& is_mutables);
@@ -600,6 +891,12 @@ namespace vg
 		void subsend_single(GLuint i, GLuint vertex) const;
 		void subsend_single(GLuint i, GLuint vertex, GLuint attrib) const;
 
+		// Writes through the mutable accessors are recorded as dirty ranges per buffer, and flush() uploads them with one glBufferSubData per disjoint range. Use mark_dirty() after writing through at().
+		void mark_dirty(GLuint i, size_t offset_bytes, size_t bytes) { _dirty[i].mark(offset_bytes, bytes); }
+		bool is_dirty(GLuint i) const { return !_dirty[i].empty(); }
+		void flush(GLuint i);
+		void flush();
+
 		template<typename Type>
 		const Type& ref(GLuint i, GLuint vertex, GLuint attrib) const
 		{
@@ -609,7 +906,10 @@ namespace vg
 		template<typename Type>
 		Type& ref(GLuint i, GLuint vertex, GLuint attrib)
 		{
-			return _cpubuf_and_vcs[i].first.ref<Type>(buffer_offset(i, vertex, attrib));
+			GLintptr offset = buffer_offset(i, vertex, attrib);
+			Type& obj = _cpubuf_and_vcs[i].first.ref<Type>(offset);
+			_dirty[i].mark(offset, sizeof(Type));
+			return obj;
 		}
 
 		template<typename Type>
@@ -621,7 +921,9 @@ namespace vg
 		template<typename Type>
 		Type& ref(GLuint i, size_t offset_bytes)
 		{
-			return _cpubuf_and_vcs[i].first.ref<Type>(offset_bytes);
+			Type& obj = _cpubuf_and_vcs[i].first.ref<Type>(offset_bytes);
+			_dirty[i].mark(offset_bytes, sizeof(Type));
+			return obj;
 		}
 
 		template<typename Type>
@@ -649,48 +951,229 @@ namespace vg
 		template<typename Type>
 		void set_attribute(GLuint i, GLuint attrib, GLuint starting_vertex, GLuint count, const Type& obj)
 		{
-			for (GLuint n = 0; n < count; ++n)
-				_cpubuf_and_vcs[i].first.ref<Type>(buffer_offset(i, starting_vertex + n, attrib)) = obj;
+			GLintptr offset = buffer_offset(i, starting_vertex, attrib);
+			strided::fill(_cpubuf_and_vcs[i].first, offset, _vbs.layout(i)->stride(), count, obj);
+			_dirty[i].mark(offset, strided::span(_vbs.layout(i)->stride(), count, sizeof(Type)));
 		}
 
 		template<typename Type>
 		void set_attribute(GLuint i, GLuint attrib, const Type& obj)
 		{
-			GLuint vertex_count = _cpubuf_and_vcs[i].second;
-			for (GLuint n = 0; n < vertex_count; ++n)
-				_cpubuf_and_vcs[i].first.ref<Type>(buffer_offset(i, n, attrib)) = obj;
+			set_attribute(i, attrib, 0, _cpubuf_and_vcs[i].second, obj);
+		}
+
+		template<typename Type>
+		void set_attributes(GLuint i, GLuint attrib, GLuint starting_vertex, const Type* objs, GLuint count)
+		{
+			GLintptr offset = buffer_offset(i, starting_vertex, attrib);
+			strided::scatter(_cpubuf_and_vcs[i].first, offset, _vbs.layout(i)->stride(), objs, count);
+			_dirty[i].mark(offset, strided::span(_vbs.layout(i)->stride(), count, sizeof(Type)));
 		}
 
 		template<typename Type, size_t N>
 		void set_attributes(GLuint i, GLuint attrib, GLuint starting_vertex, const std::array<Type, N>& objs)
 		{
-			for (GLuint n = 0; n < N; ++n)
-				_cpubuf_and_vcs[i].first.ref<Type>(buffer_offset(i, starting_vertex + n, attrib)) = objs[n];
+			set_attributes(i, attrib, starting_vertex, objs.data(), (GLuint)N);
+		}
+
+		template<typename Type>
+		void get_attributes(GLuint i, GLuint attrib, GLuint starting_vertex, Type* objs, GLuint count) const
+		{
+			strided::gather(_cpubuf_and_vcs[i].first, buffer_offset(i, starting_vertex, attrib), _vbs.layout(i)->stride(), objs, count);
 		}
 	};
 
+#if VANGUARD_MIN_OPENGL_VERSION_IS_AT_LEAST(4, 4)
+	// Use StreamVertexBuffer for vertex data that is rewritten whole every frame. Vertices are written straight into persistently mapped GPU memory, so there is no CPU-side copy and no glBufferSubData.
+	// For vertices that are only partly rewritten, stream() a CPUVertexBuffer instead, which keeps the regions up to date from its CPU copy.
+	// Each frame, call begin_frame() before writing vertices and end_frame() after the draw calls that use them. Draw from first_vertex(), or pass it as the base vertex for indexed draws.
+	class StreamVertexBuffer
+	{
+		std::shared_ptr<VertexBufferLayout> _layout;
+		VertexFormat _format;
+		StreamBuffer _sb;
+		GLuint _vertex_count;
+
+		void init() const;
+		void check_span(GLintptr offset, GLuint count, size_t size) const
+		{
+			size_t bytes = strided::span(_layout->stride(), count, size);
+			if (offset + (GLsizeiptr)bytes > _sb.region_size())
+				throw offset_out_of_range(_sb.region_size(), offset, bytes);
+		}
+
+	public:
+		StreamVertexBuffer(const std::shared_ptr<VertexBufferLayout>& layout, GLuint vertex_count, GLuint frames_in_flight = 3);
+		StreamVertexBuffer(std::shared_ptr<VertexBufferLayout>&& layout, GLuint vertex_count, GLuint frames_in_flight = 3);
+		StreamVertexBuffer(const StreamVertexBuffer&) = delete;
+		StreamVertexBuffer(StreamVertexBuffer&&) noexcept = default;
+		StreamVertexBuffer& operator=(StreamVertexBuffer&&) noexcept = default;
+
+		const std::shared_ptr<VertexBufferLayout>& layout() const { return _layout; }
+		ids::VertexArray vao() const { return _format.vao(); }
+		ids::GLBuffer vb() const { return _sb.buffer(); }
+		void bind_vao() const;
+		void bind_vb() const;
+
+		GLuint vertex_count() const { return _vertex_count; }
+		GLuint first_vertex() const { return _sb.current_region() * _vertex_count; }
+		GLintptr buffer_offset(GLuint vertex, GLuint attrib) const { return _layout->buffer_offset(vertex, attrib); }
+
+		void begin_frame() { _sb.begin_region(); }
+		void end_frame() { _sb.end_region(); }
+
+		template<typename Type>
+		const Type& ref(GLuint vertex, GLuint attrib) const
+		{
+			return _sb.ref<Type>(buffer_offset(vertex, attrib));
+		}
+
+		template<typename Type>
+		Type& ref(GLuint vertex, GLuint attrib)
+		{
+			return _sb.ref<Type>(buffer_offset(vertex, attrib));
+		}
+
+		template<typename Type>
+		Type val(GLuint vertex, GLuint attrib) const
+		{
+			return _sb.ref<Type>(buffer_offset(vertex, attrib));
+		}
+
+		const void* at(size_t offset_bytes) const { return _sb.at(offset_bytes); }
+		void* at(size_t offset_bytes) { return _sb.at(offset_bytes); }
+
+		void write(GLuint first_vertex, GLuint count, const void* vertices);
+
+		template<typename Type>
+		void set_attribute(GLuint attrib, GLuint starting_vertex, GLuint count, const Type& obj)
+		{
+			GLintptr offset = buffer_offset(starting_vertex, attrib);
+			check_span(offset, count, sizeof(Type));
+			strided::fill(_sb.at(offset), _layout->stride(), count, &obj, sizeof(Type));
+		}
+
+		template<typename Type>
+		void set_attribute(GLuint attrib, const Type& obj)
+		{
+			set_attribute(attrib, 0, _vertex_count, obj);
+		}
+
+		template<typename Type>
+		void set_attributes(GLuint attrib, GLuint starting_vertex, const Type* objs, GLuint count)
+		{
+			GLintptr offset = buffer_offset(starting_vertex, attrib);
+			check_span(offset, count, sizeof(Type));
+			strided::scatter(_sb.at(offset), _layout->stride(), objs, count, sizeof(Type));
+		}
+
+		template<typename Type, size_t N>
+		void set_attributes(GLuint attrib, GLuint starting_vertex, const std::array<Type, N>& objs)
+		{
+			set_attributes(attrib, starting_vertex, objs.data(), (GLuint)N);
+		}
+	};
+#endif
+
+	// Use MeshHeap to pack many meshes that share a VertexBufferLayout into one vertex buffer and one index buffer behind a single VAO. Indices are local to their mesh:
+	// draw a mesh with base_vertex(mesh) and first_index(mesh), or draw many at once with draw::mesh_heap::multi(). The VAO is the heap's own rather than the layout's shared
+	// VertexFormat, so its buffers stay attached and the VAO alone identifies the heap to batchers.
+	class MeshHeap
+	{
+	public:
+		struct Mesh
+		{
+			GPUHeap::Handle vertices;
+			GPUHeap::Handle indices;
+		};
+
+	private:
+		std::shared_ptr<VertexBufferLayout> _layout;
+		VertexFormat _format;
+		GPUHeap _vertex_heap;
+		GPUHeap _index_heap;
+		IndexDataType _idt;
+
+		void init() const;
+
+	public:
+		MeshHeap(const std::shared_ptr<VertexBufferLayout>& layout, GLuint vertex_capacity, GLuint index_capacity, IndexDataType idt = IndexDataType::UINT);
+		MeshHeap(std::shared_ptr<VertexBufferLayout>&& layout, GLuint vertex_capacity, GLuint index_capacity, IndexDataType idt = IndexDataType::UINT);
+		MeshHeap(const MeshHeap&) = delete;
+		MeshHeap(MeshHeap&&) noexcept = default;
+		MeshHeap& operator=(MeshHeap&&) noexcept = default;
+
+		const std::shared_ptr<VertexBufferLayout>& layout() const { return _layout; }
+		ids::VertexArray vao() const { return _format.vao(); }
+		void bind_vao() const;
+		IndexDataType data_type() const { return _idt; }
+		const GPUHeap& vertex_heap() const { return _vertex_heap; }
+		const GPUHeap& index_heap() const { return _index_heap; }
+
+		Mesh allocate(GLuint vertex_count, GLuint index_count);
+		void free(Mesh mesh);
+		void write_vertices(Mesh mesh, const void* vertices) const { _vertex_heap.write(mesh.vertices, vertices); }
+		void write_indices(Mesh mesh, const void* indices) const { _index_heap.write(mesh.indices, indices); }
+
+		GLint base_vertex(Mesh mesh) const { return (GLint)_vertex_heap.offset(mesh.vertices); }
+		GLuint vertex_count(Mesh mesh) const { return _vertex_heap.count(mesh.vertices); }
+		GLuint first_index(Mesh mesh) const { return _index_heap.offset(mesh.indices); }
+		GLuint index_count(Mesh mesh) const { return _index_heap.count(mesh.indices); }
+
+		void defragment();
+	};
+
+	// CompactVBIndexer packs sub-meshes back to back in one vertex buffer. It is an implicit treap ordered by position whose nodes carry subtree vertex totals,
+	// so a sub-mesh's vertex offset, and inserting, erasing or resizing a sub-mesh, are O(log n) rather than a rewrite of every following offset.
+	// The overloads that take a CPUVertexBuffer also move the vertices after the edit, so the buffer stays compact.
 	class CompactVBIndexer
 	{
-		struct IndexedVB
+		static const GLuint NIL = GLuint(-1);
+
+		struct Node
 		{
 			GLuint vertex_count = 0;
-			GLuint vertex_offset = 0;
+			GLuint subtree_vertices = 0;
+			GLuint subtree_size = 1;
+			GLuint priority = 0;
+			GLuint left = NIL;
+			GLuint right = NIL;
 		};
 
-		std::vector<IndexedVB> indexes;
+		std::vector<Node> _nodes;
+		std::vector<GLuint> _free_nodes;
+		GLuint _root = NIL;
+		GLuint _seed = 0x9E3779B9;
+
+		GLuint subtree_size(GLuint t) const { return t == NIL ? 0 : _nodes[t].subtree_size; }
+		GLuint subtree_vertices(GLuint t) const { return t == NIL ? 0 : _nodes[t].subtree_vertices; }
+		void update(GLuint t);
+		GLuint new_node(GLuint vertex_count);
+		void split(GLuint t, GLuint pos, GLuint& left, GLuint& right);
+		GLuint merge(GLuint left, GLuint right);
+		GLuint node_at(GLuint pos) const;
+		void set_vertex_count(GLuint t, GLuint pos, GLuint vertex_count);
 
 	public:
 		CompactVBIndexer() = default;
 		CompactVBIndexer(const std::vector<GLuint>& vertex_counts);
 
-		GLuint vertex(GLuint index, GLuint local_vertex) const { return indexes[index].vertex_offset + local_vertex; }
-		GLuint vertex_count() const { return indexes.empty() ? 0 : indexes.back().vertex_offset + indexes.back().vertex_count; }
-		GLuint vertex_count(GLuint index) const { return indexes[index].vertex_count; }
+		GLuint vertex_offset(GLuint index) const;
+		GLuint vertex(GLuint index, GLuint local_vertex) const { return vertex_offset(index) + local_vertex; }
+		GLuint vertex_count() const { return subtree_vertices(_root); }
+		GLuint vertex_count(GLuint index) const { return _nodes[node_at(index)].vertex_count; }
 		
-		GLuint size() const { return indexes.size(); }
+		GLuint size() const { return subtree_size(_root); }
 		void push_back(GLuint vertex_count);
+		// Inserts before pos; pos == size() appends.
 		void insert(GLuint pos, GLuint vertex_count);
 		void erase(GLuint pos);
+		void resize(GLuint pos, GLuint vertex_count);
 		void swap(GLuint pos1, GLuint pos2);
+		void clear();
+
+		void insert(GLuint pos, GLuint vertex_count, CPUVertexBuffer& vb);
+		void erase(GLuint pos, CPUVertexBuffer& vb);
+		void resize(GLuint pos, GLuint vertex_count, CPUVertexBuffer& vb);
 	};
 }
@@ -0,0 +1,136 @@
+#include "StreamBuffer.h"
+
+#include <algorithm>
+
+#include "Vanguard.h"
+#include "Errors.h"
+
+#if VANGUARD_MIN_OPENGL_VERSION_IS_AT_LEAST(4, 4)
+
+static const int STREAM_STORAGE_FLAGS = vg::BufferImmutableUsage::MAP_WRITE | vg::BufferImmutableUsage::MAP_PERSISTENT | vg::BufferImmutableUsage::MAP_COHERENT;
+
+vg::StreamBuffer::StreamBuffer(BufferTarget target, GLsizeiptr region_size, GLuint region_count)
+	: _target(target), _region_size(region_size), _region_count(region_count), _fences(region_count, nullptr)
+{
+	buffers::set_category(_b, buffers::target_category(target));
+	buffers::init_immutable(_b, _region_size * _region_count, nullptr, STREAM_STORAGE_FLAGS);
+#if VANGUARD_MIN_OPENGL_VERSION_IS_AT_LEAST(4, 5)
+	_mapped = (char*)glMapNamedBufferRange(buffer(), 0, _region_size * _region_count, STREAM_STORAGE_FLAGS);
+#else
+	bind();
+	_mapped = (char*)glMapBufferRange((GLenum)_target, 0, _region_size * _region_count, STREAM_STORAGE_FLAGS);
+#endif
+	if (!_mapped)
+		throw Error(ErrorCode::BUFFER_MAPPING);
+}
+
+vg::StreamBuffer::StreamBuffer(StreamBuffer&& other) noexcept
+	: _b(std::move(other._b)), _target(other._target), _region_size(other._region_size), _region_count(other._region_count),
+	_current(other._current), _mapped(other._mapped), _fences(std::move(other._fences))
+{
+	other._mapped = nullptr;
+	other._region_count = 0;
+}
+
+vg::StreamBuffer& vg::StreamBuffer::operator=(StreamBuffer&& other) noexcept
+{
+	if (this != &other)
+	{
+		for (GLsync& fence : _fences)
+			fences::discard(fence);
+		_b = std::move(other._b);
+		_target = other._target;
+		_region_size = other._region_size;
+		_region_count = other._region_count;
+		_current = other._current;
+		_mapped = other._mapped;
+		_fences = std::move(other._fences);
+		other._mapped = nullptr;
+		other._region_count = 0;
+	}
+	return *this;
+}
+
+vg::StreamBuffer::~StreamBuffer()
+{
+	// Deleting the buffer implicitly unmaps it.
+	for (GLsync& fence : _fences)
+		fences::discard(fence);
+}
+
+void vg::StreamBuffer::bind() const
+{
+	buffers::bind(_b, _target);
+}
+
+void vg::StreamBuffer::begin_region()
+{
+	GLsync& fence = _fences[_current];
+	fences::wait(fence);
+	fences::discard(fence);
+}
+
+void vg::StreamBuffer::end_region()
+{
+	_fences[_current] = fences::insert();
+	_current = (_current + 1) % _region_count;
+}
+
+const void* vg::StreamBuffer::at(GLintptr offset_bytes) const
+{
+	if (offset_bytes < 0 || offset_bytes >= _region_size)
+		throw offset_out_of_range(_region_size, offset_bytes, 1);
+	return _mapped + region_offset() + offset_bytes;
+}
+
+void* vg::StreamBuffer::at(GLintptr offset_bytes)
+{
+	if (offset_bytes < 0 || offset_bytes >= _region_size)
+		throw offset_out_of_range(_region_size, offset_bytes, 1);
+	return _mapped + region_offset() + offset_bytes;
+}
+
+void vg::StreamBuffer::write(GLintptr offset_bytes, GLsizeiptr size, const void* data)
+{
+	if (offset_bytes + size > _region_size)
+		throw offset_out_of_range(_region_size, offset_bytes, size);
+	memcpy(_mapped + region_offset() + offset_bytes, data, size);
+}
+
+// Comfortably above the offset alignment any implementation asks of vertex and uniform buffer bindings.
+static const GLsizeiptr STREAM_REGION_ALIGNMENT = 256;
+
+vg::StreamMirror::StreamMirror(BufferTarget target, GLsizeiptr region_size, GLuint region_count)
+	: _sb(target, (std::max(region_size, GLsizeiptr(1)) + STREAM_REGION_ALIGNMENT - 1) / STREAM_REGION_ALIGNMENT * STREAM_REGION_ALIGNMENT, region_count), _stale(region_count)
+{
+	// No region holds anything yet.
+	for (DirtyRanges& stale : _stale)
+		stale.mark(0, _sb.region_size());
+}
+
+void vg::StreamMirror::write(const VoidArray& mirror, const DirtyRanges& dirty)
+{
+	if (_begun && _read)
+	{
+		_sb.end_region();
+		_begun = false;
+	}
+	if (!_begun)
+	{
+		_sb.begin_region();
+		_begun = true;
+		_read = false;
+	}
+	for (DirtyRanges& stale : _stale)
+		for (const DirtyRanges::Range& range : dirty.ranges())
+			stale.mark(range.begin, range.bytes());
+
+	DirtyRanges& current = _stale[_sb.current_region()];
+	size_t limit = std::min(mirror.size(), size_t(_sb.region_size()));
+	for (const DirtyRanges::Range& range : current.ranges())
+		if (range.begin < limit)
+			_sb.write(range.begin, std::min(range.end, limit) - range.begin, mirror.at(range.begin));
+	current.clear();
+}
+
+#endif
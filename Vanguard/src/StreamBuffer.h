@@ -0,0 +1,94 @@
+#pragma once
+
+#include <vector>
+
+#include "Vanguard.h"
+#include "raii/GLBuffer.h"
+#include "utils/DirtyRanges.h"
+#include "utils/VoidArray.h"
+
+namespace vg
+{
+#if VANGUARD_MIN_OPENGL_VERSION_IS_AT_LEAST(4, 4)
+	// StreamBuffer allocates immutable storage once and keeps it persistently mapped. The storage is split into region_count regions (one per frame in flight), and each region is guarded by a fence,
+	// so the CPU never writes into a region that the GPU may still be reading. Call begin_region() before writing into region(), and end_region() after the draw calls that read from it.
+	class StreamBuffer
+	{
+		raii::GLBuffer _b;
+		BufferTarget _target;
+		GLsizeiptr _region_size;
+		GLuint _region_count;
+		GLuint _current = 0;
+		char* _mapped = nullptr;
+		std::vector<GLsync> _fences;
+
+	public:
+		StreamBuffer(BufferTarget target, GLsizeiptr region_size, GLuint region_count = 3);
+		StreamBuffer(const StreamBuffer&) = delete;
+		StreamBuffer(StreamBuffer&&) noexcept;
+		StreamBuffer& operator=(StreamBuffer&&) noexcept;
+		~StreamBuffer();
+
+		ids::GLBuffer buffer() const { return _b; }
+		BufferTarget target() const { return _target; }
+		void bind() const;
+
+		GLsizeiptr region_size() const { return _region_size; }
+		GLuint region_count() const { return _region_count; }
+		GLuint current_region() const { return _current; }
+		GLintptr region_offset() const { return _current * _region_size; }
+
+		void begin_region();
+		void end_region();
+
+		const void* region() const { return _mapped + region_offset(); }
+		void* region() { return _mapped + region_offset(); }
+		const void* at(GLintptr offset_bytes) const;
+		void* at(GLintptr offset_bytes);
+		void write(GLintptr offset_bytes, GLsizeiptr size, const void* data);
+
+		template<typename Type>
+		const Type& ref(GLintptr offset_bytes) const
+		{
+			if (offset_bytes + (GLsizeiptr)sizeof(Type) > _region_size)
+				throw offset_out_of_range(_region_size, offset_bytes, sizeof(Type));
+			return *reinterpret_cast<const Type*>(_mapped + region_offset() + offset_bytes);
+		}
+
+		template<typename Type>
+		Type& ref(GLintptr offset_bytes)
+		{
+			if (offset_bytes + (GLsizeiptr)sizeof(Type) > _region_size)
+				throw offset_out_of_range(_region_size, offset_bytes, sizeof(Type));
+			return *reinterpret_cast<Type*>(_mapped + region_offset() + offset_bytes);
+		}
+	};
+
+	// StreamMirror keeps a StreamBuffer in step with a CPU copy that is modified in place, as the CPU vertex buffers' copies are. A region that was not current for a while
+	// is stale, so write() copies into it the bytes that changed meanwhile as well as the bytes dirty now. Nothing goes through glBufferSubData.
+	class StreamMirror
+	{
+		StreamBuffer _sb;
+		// Per region, the bytes of the CPU copy that changed since the region was last written.
+		std::vector<DirtyRanges> _stale;
+		bool _begun = false;
+		mutable bool _read = false;
+
+	public:
+		// region_size is rounded up so that every region starts suitably aligned for a vertex buffer binding.
+		StreamMirror(BufferTarget target, GLsizeiptr region_size, GLuint region_count = 3);
+
+		ids::GLBuffer buffer() const { return _sb.buffer(); }
+		GLsizeiptr region_size() const { return _sb.region_size(); }
+		GLuint region_count() const { return _sb.region_count(); }
+		// The region the last write() went into.
+		GLintptr region_offset() const { return _sb.region_offset(); }
+		// Call when binding the current region for draws. The next write() then fences it and moves on, instead of overwriting a region the GPU may be reading.
+		void mark_read() const { _read = true; }
+
+		// Copies the bytes of mirror that dirty marks, and those the region missed, into the current region, or into the next one once the current one was read,
+		// after waiting for the GPU to finish the draws that last read it. Bytes past region_size() are not copied.
+		void write(const VoidArray& mirror, const DirtyRanges& dirty);
+	};
+#endif
+}
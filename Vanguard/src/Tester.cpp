@@ -1,6 +1,7 @@
 #include <iostream>
 #include <string>
 #include <array>
+#include <vector>
 
 #include "Vanguard.h"
 
@@ -10,6 +11,95 @@
 #include "utils/IO.h"
 #include "raii/Texture.h"
 #include "raii/FrameBuffer.h"
+#include "ObjectPool.h"
+
+// Times BENCHMARK_FRAMES frames of creating, filling and deleting scratch buffers, against the same frames leasing them from a GLObjectPool.
+static const int BENCHMARK_FRAMES = 200;
+static const int SCRATCH_BUFFERS_PER_FRAME = 32;
+static const GLsizeiptr SCRATCH_BUFFER_SIZE = 64 * 1024;
+
+static void benchmark_object_pool()
+{
+	std::vector<char> data(SCRATCH_BUFFER_SIZE, 1);
+
+	glFinish();
+	double start = glfwGetTime();
+	for (int frame = 0; frame < BENCHMARK_FRAMES; ++frame)
+	{
+		for (int i = 0; i < SCRATCH_BUFFERS_PER_FRAME; ++i)
+		{
+			vg::raii::GLBuffer buffer;
+			vg::buffers::init_immutable(buffer, SCRATCH_BUFFER_SIZE);
+			vg::buffers::upload(buffer, 0, SCRATCH_BUFFER_SIZE, data.data(), vg::UploadStrategy::SUBDATA);
+		}
+	}
+	glFinish();
+	double churn = glfwGetTime() - start;
+
+	vg::GLObjectPool pool;
+	glFinish();
+	start = glfwGetTime();
+	for (int frame = 0; frame < BENCHMARK_FRAMES; ++frame)
+	{
+		std::vector<vg::GLObjectPool::BufferLease> leases;
+		for (int i = 0; i < SCRATCH_BUFFERS_PER_FRAME; ++i)
+		{
+			leases.push_back(pool.buffer(vg::BufferTarget::VERTEX, SCRATCH_BUFFER_SIZE));
+			vg::buffers::upload(leases.back(), 0, SCRATCH_BUFFER_SIZE, data.data(), vg::UploadStrategy::SUBDATA);
+		}
+		leases.clear();
+		pool.collect();
+	}
+	glFinish();
+	double pooled = glfwGetTime() - start;
+
+	std::cout << "Scratch buffers, " << BENCHMARK_FRAMES << " frames of " << SCRATCH_BUFFERS_PER_FRAME << ": create/delete " << churn * 1000.0 << " ms, pooled "
+		<< pooled * 1000.0 << " ms (" << pool.stats().created << " created, reuse rate " << pool.stats().reuse_rate() << ")" << std::endl;
+	pool.clear();
+}
+
+// Times BENCHMARK_FRAMES frames of rewriting every vertex's position and drawing, uploaded with glBufferSubData by subsend_full(), against the same frames streamed
+// through persistently mapped storage.
+static const GLuint STREAMED_VERTICES = 64 * 1024;
+
+static double time_vertex_updates(vg::CPUVertexBuffer& vb)
+{
+	std::vector<glm::vec2> positions(vb.vertex_count());
+	glFinish();
+	double start = glfwGetTime();
+	for (int frame = 0; frame < BENCHMARK_FRAMES; ++frame)
+	{
+		for (GLuint v = 0; v < vb.vertex_count(); ++v)
+			positions[v] = glm::vec2{ 2.0f * v / vb.vertex_count() - 1.0f, glm::sin(0.1f * frame + 0.01f * v) };
+		vb.set_attributes(0, 0, positions.data(), vb.vertex_count());
+		vb.subsend_full();
+		vb.bind_vao();
+		vg::draw::vertex_buffer::full(vb, vg::DrawMode::POINTS);
+	}
+	glFinish();
+	return glfwGetTime() - start;
+}
+
+static void benchmark_vertex_streaming(const vg::Shader& shader, const std::shared_ptr<vg::VertexBufferLayout>& layout)
+{
+	vg::bind_shader(shader);
+	vg::CPUVertexBuffer subsent(vg::VertexBuffer(layout), STREAMED_VERTICES, true);
+	subsent.set_attribute(1, glm::vec4{ 1.0f, 1.0f, 1.0f, 1.0f });
+	subsent.subsend_full();
+	double subsend = time_vertex_updates(subsent);
+
+#if VANGUARD_MIN_OPENGL_VERSION_IS_AT_LEAST(4, 4)
+	vg::CPUVertexBuffer streamed(vg::VertexBuffer(layout), STREAMED_VERTICES, true);
+	streamed.set_attribute(1, glm::vec4{ 1.0f, 1.0f, 1.0f, 1.0f });
+	streamed.stream();
+	double stream = time_vertex_updates(streamed);
+	std::cout << "Vertex updates, " << BENCHMARK_FRAMES << " frames of " << STREAMED_VERTICES << " vertices: subsend " << subsend * 1000.0 << " ms, streamed "
+		<< stream * 1000.0 << " ms" << std::endl;
+#else
+	std::cout << "Vertex updates, " << BENCHMARK_FRAMES << " frames of " << STREAMED_VERTICES << " vertices: subsend " << subsend * 1000.0 << " ms, streaming needs OpenGL 4.4" << std::endl;
+#endif
+	vg::unbind_vertex_array();
+}
 
 int main()
 {
@@ -18,8 +108,11 @@ int main()
 
 	vg::Window window(1440, 1080, "Hello World");
 
+	benchmark_object_pool();
+
 	vg::Shader shader(vg::FilePath("shaders/color.vert"), vg::FilePath("shaders/color.frag"));
-	auto vb_layout = std::make_shared<vg::VertexBufferLayout>(shader);
+	auto vb_layout = vg::layouts::canonical(shader);
+	benchmark_vertex_streaming(shader, vb_layout);
 
 	vg::CPUVertexBuffer vertex_buffer(vg::VertexBuffer(vb_layout), 4, false);
 
@@ -33,9 +126,8 @@ int main()
 	vertex_buffer.bind_vb();
 	vertex_buffer.subsend_full();
 
-	vg::CPUIndexBuffer index_buffer(vg::IndexDataType::UBYTE);
-	index_buffer.bind_to_vertex_array(vertex_buffer.vao());
-	index_buffer.init_immutable_quads(1);
+	vg::QuadIndexView index_buffer = vg::quads::view(vg::IndexDataType::UBYTE, 1);
+	vg::quads::attach(vertex_buffer, vg::IndexDataType::UBYTE, 1);
 
 	vg::CPUVertexBufferBlock white_square(vg::VertexBufferBlock(2, vb_layout, { { 0, { 0 } }, { 1, { 1 } } }), 4, false);
 
@@ -47,7 +139,7 @@ int main()
 	});
 	white_square.set_attribute(1, 1, glm::vec4{ 1.0f, 1.0f, 1.0f, 1.0f });
 	white_square.subsend_all_blocks();
-	index_buffer.bind_to_vertex_array(white_square.vao());
+	vg::quads::attach(white_square, vg::IndexDataType::UBYTE, 1);
 
 	vg::CompactVBIndexer tripair_indexer({ 3, 3 });
 	vg::CPUVertexBuffer tripair(vg::VertexBuffer(vb_layout), tripair_indexer.vertex_count(), false);
@@ -70,10 +162,10 @@ int main()
 	std::string image_frag = vg::io::read_template_file("shaders/image.frag.tmpl", { { "$NUM_TEXTURE_SLOTS", std::to_string(window.constants().max_texture_image_units)}});
 	vg::Shader img_shader(image_vert, image_frag);
 	// It is possible to have a vertex buffer with only one vertex's attribute, but only if setting the divisor. This works even with non-instanced rendering
-	auto img_layout = std::make_shared<vg::VertexBufferLayout>(img_shader, vg::VertexAttributeSpecificationList{ {}, {}, { { 1, 1 } } });
+	auto img_layout = vg::layouts::canonical(img_shader, vg::VertexAttributeSpecificationList{ {}, {}, { { 1, 1 } } });
 
 	vg::CPUVertexBufferBlock sprite(vg::VertexBufferBlock(2, img_layout, { { 0, { 0, 2, 3 } }, { 1, { 1 } } }), { 4, 1 }, false);
-	index_buffer.bind_to_vertex_array(sprite.vao());
+	vg::quads::attach(sprite, vg::IndexDataType::UBYTE, 1);
 
 	sprite.set_attributes(0, 0, 0, std::array<glm::vec2, 4>{
 		glm::vec2{ -0.8f, -0.8f },
@@ -92,21 +184,21 @@ int main()
 	sprite.subsend_all_blocks();
 
 	vg::raii::Image2D img_einstein = vg::load_image_2d("ex/flag.png");
-	vg::raii::Texture tex_einstein;
+	vg::raii::Texture tex_einstein(vg::TextureTarget::T2D);
 	vg::image_2d::send_texture(img_einstein, tex_einstein);
 	vg::texture_params::nearest(vg::texture_params::T2D);
 
 	vg::FrameBufferObject fbo(0, 0, 1440, 1080, { 0.5f, 0.7f, 0.9f, 1.0f });
 	fbo.bind();
 
-	vg::raii::Texture color_texture;
+	vg::raii::Texture color_texture(vg::TextureTarget::T2D);
 	vg::image_2d::send_texture(1440, 1080, 4, color_texture);
 	vg::texture_params::nearest(vg::texture_params::T2D);
-	vg::raii::Texture normal_texture;
+	vg::raii::Texture normal_texture(vg::TextureTarget::T2D);
 	vg::image_2d::send_texture(1440, 1080, 4, normal_texture);
 	vg::texture_params::nearest(vg::texture_params::T2D);
 
-	vg::raii::Texture depth_texture;
+	vg::raii::Texture depth_texture(vg::TextureTarget::T2D);
 	vg::bind_texture(depth_texture, vg::TextureTarget::T2D);
 	glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT, 1440, 1080, 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
 	vg::texture_params::nearest(vg::texture_params::T2D);
@@ -128,19 +220,15 @@ int main()
 		vertex_buffer.bind_vao();
 		vg::draw::index_buffer::full(index_buffer, vg::DrawMode::TRIANGLES);
 
-		vertex_buffer.bind_vb();
 		vertex_buffer.ref<glm::vec4>(0, 1).x = glm::sqrt(0.5f * (1.0f + (float)glm::sin(glfwGetTime() + 0 * glm::pi<float>() / 3)));
-		vertex_buffer.subsend_single(0, 1);
 		vertex_buffer.ref<glm::vec4>(1, 1).y = glm::sqrt(0.5f * (1.0f + (float)glm::sin(glfwGetTime() + 1 * glm::pi<float>() / 3)));
-		vertex_buffer.subsend_single(1, 1);
 		vertex_buffer.ref<glm::vec4>(2, 1).z = glm::sqrt(0.5f * (1.0f + (float)glm::sin(glfwGetTime() + 2 * glm::pi<float>() / 3)));
-		vertex_buffer.subsend_single(2, 1);
+		vertex_buffer.flush();
 
 		fbo.draw_into(vg::framebuffers::Attachment::COLOR0);
 
 		white_square.ref<glm::vec2>(0, 0, 0).x -= float(0.008f * glm::sin(glfwGetTime() * 20.0f));
-		white_square.bind_vb(0);
-		white_square.subsend_single(0, 0, 0);
+		white_square.flush(0);
 
 		white_square.bind_vao();
 		vg::draw::index_buffer::full(index_buffer, vg::DrawMode::TRIANGLES);
@@ -161,23 +249,21 @@ int main()
 		vg::bind_texture(normal_texture, vg::TextureTarget::T2D);
 		
 		sprite.bind_vao();
-		sprite.bind_vb(1);
 		
 		sprite.set_attribute(1, 1, GLint(0));
-		sprite.subsend_full(1);
+		sprite.flush(1);
 		vg::draw::index_buffer::full(index_buffer, vg::DrawMode::TRIANGLES);
 		
 		sprite.set_attribute(1, 1, GLint(1));
-		sprite.subsend_full(1);
+		sprite.flush(1);
 		vg::draw::index_buffer::full(index_buffer, vg::DrawMode::TRIANGLES);
 		
 		sprite.set_attribute(1, 1, GLint(2));
-		sprite.subsend_full(1);
+		sprite.flush(1);
 		vg::draw::index_buffer::full(index_buffer, vg::DrawMode::TRIANGLES);
 
 		sprite.ref<glm::vec2>(0, 0, 0).x += 0.002f;
-		sprite.bind_vb(0);
-		sprite.subsend_single(0, 0, 0);
+		sprite.flush(0);
 		};
 
 	for (;;)
@@ -0,0 +1,57 @@
+#include "TypedVertexBuffer.h"
+
+#include "Errors.h"
+
+// GLhalf is GLushort, and packed attributes are one 32-bit word, so those members are accepted by storage size as well as by exact type.
+static bool stores_as(const vg::StaticAttributeType& member, const vg::VertexAttribute& attribute)
+{
+	using DataType = vg::VertexAttribute::DataType;
+	if (!member.is_known || member.type == attribute.get_type())
+		return true;
+	if (attribute.get_type() == DataType::HALF)
+		return member.type == DataType::USHORT;
+	if (attribute.is_packed())
+		return member.type == DataType::INT || member.type == DataType::UINT;
+	return false;
+}
+
+static std::string component_description(const vg::StaticAttributeType& member)
+{
+	return std::string(member.is_integer ? "integer" : "floating-point") + " components of GL type " + std::to_string((GLenum)member.type + GL_BYTE);
+}
+
+static std::string fetch_description(const vg::VertexAttribute& attribute)
+{
+	return "stores GL type " + std::to_string(attribute.type_as_gl_enum()) + (attribute.is_integer() ? " fetched as integers" : " fetched as floats");
+}
+
+void vg::validate_static_layout(const VertexBufferLayout& layout, const GLuint* attribute_sizes, const StaticAttributeType* attribute_types, GLuint attribute_count)
+{
+	const auto& attributes = layout.attributes();
+	GLuint runtime = 0;
+	GLuint offset = 0;
+	for (GLuint i = 0; i < attribute_count; ++i)
+	{
+		if (runtime >= attributes.size())
+			throw Error(ErrorCode::VERTEX_LAYOUT_MISMATCH, "static attribute " + std::to_string(i) + " is past the end of the shader layout ("
+				+ std::to_string(attributes.size()) + " attributes)");
+		if (attributes[runtime].get_offset() != offset)
+			throw Error(ErrorCode::VERTEX_LAYOUT_MISMATCH, "static attribute " + std::to_string(i) + " at offset " + std::to_string(offset)
+				+ " does not start a shader attribute (next one is at offset " + std::to_string(attributes[runtime].get_offset()) + ")");
+
+		GLuint covered = 0;
+		while (covered < attribute_sizes[i] && runtime < attributes.size())
+		{
+			if (!stores_as(attribute_types[i], attributes[runtime]))
+				throw Error(ErrorCode::VERTEX_LAYOUT_MISMATCH, "static attribute " + std::to_string(i) + " has " + component_description(attribute_types[i])
+					+ ", but the shader attribute at location " + std::to_string(attributes[runtime].get_location()) + " " + fetch_description(attributes[runtime]));
+			covered += attributes[runtime++].bytes();
+		}
+		if (covered != attribute_sizes[i])
+			throw Error(ErrorCode::VERTEX_LAYOUT_MISMATCH, "static attribute " + std::to_string(i) + " is " + std::to_string(attribute_sizes[i])
+				+ " bytes, but the shader attributes it overlaps are " + std::to_string(covered) + " bytes");
+		offset += attribute_sizes[i];
+	}
+	if (runtime != attributes.size() || offset != layout.stride())
+		throw Error(ErrorCode::VERTEX_LAYOUT_MISMATCH, "static vertex is " + std::to_string(offset) + " bytes, but the shader layout's stride is " + std::to_string(layout.stride()));
+}
@@ -0,0 +1,191 @@
+#pragma once
+
+#include <array>
+#include <cstring>
+#include <tuple>
+#include <type_traits>
+
+#include "Renderable.h"
+
+namespace vg
+{
+	// The component type of a static attribute. is_known is false for member types whose components validate() cannot see, which are then only checked by size.
+	struct StaticAttributeType
+	{
+		VertexAttribute::DataType type = VertexAttribute::DataType::FLOAT;
+		bool is_integer = false;
+		bool is_known = false;
+	};
+
+	template<typename Type>
+	struct StaticAttributeComponent { using type = Type; };
+	template<glm::length_t L, typename Type, glm::qualifier Q>
+	struct StaticAttributeComponent<glm::vec<L, Type, Q>> { using type = Type; };
+	template<glm::length_t C, glm::length_t R, typename Type, glm::qualifier Q>
+	struct StaticAttributeComponent<glm::mat<C, R, Type, Q>> { using type = Type; };
+	template<typename Type, size_t N>
+	struct StaticAttributeComponent<std::array<Type, N>> { using type = Type; };
+
+	template<typename Attribute>
+	constexpr StaticAttributeType static_attribute_type()
+	{
+		using Component = typename StaticAttributeComponent<Attribute>::type;
+		if constexpr (std::is_same_v<Component, GLfloat>)
+			return { VertexAttribute::DataType::FLOAT, false, true };
+		else if constexpr (std::is_same_v<Component, GLdouble>)
+			return { VertexAttribute::DataType::DOUBLE, false, true };
+		else if constexpr (std::is_same_v<Component, GLbyte>)
+			return { VertexAttribute::DataType::CHAR, true, true };
+		else if constexpr (std::is_same_v<Component, GLubyte>)
+			return { VertexAttribute::DataType::UCHAR, true, true };
+		else if constexpr (std::is_same_v<Component, GLshort>)
+			return { VertexAttribute::DataType::SHORT, true, true };
+		else if constexpr (std::is_same_v<Component, GLushort>)
+			return { VertexAttribute::DataType::USHORT, true, true };
+		else if constexpr (std::is_same_v<Component, GLint>)
+			return { VertexAttribute::DataType::INT, true, true };
+		else if constexpr (std::is_same_v<Component, GLuint>)
+			return { VertexAttribute::DataType::UINT, true, true };
+		else
+			return {};
+	}
+
+	// Throws unless the attribute sizes, laid out back to back, cover the attributes of layout exactly, and each static attribute's components are stored as the shader attributes
+	// it covers expect. A static attribute may span several runtime attributes, as a matrix spans one per column.
+	extern void validate_static_layout(const VertexBufferLayout& layout, const GLuint* attribute_sizes, const StaticAttributeType* attribute_types, GLuint attribute_count);
+
+	// StaticVertexLayout describes a vertex at compile time: Vertex is a plain struct whose members are Attributes, in order and without padding. Offsets and stride are constexpr,
+	// and validate() checks them and the attributes' component types once against the VertexBufferLayout reflected from a shader.
+	template<typename VertexType, typename... Attributes>
+	struct StaticVertexLayout
+	{
+		using Vertex = VertexType;
+		template<GLuint A>
+		using Attribute = std::tuple_element_t<A, std::tuple<Attributes...>>;
+
+		static constexpr GLuint attribute_count = sizeof...(Attributes);
+		static constexpr GLuint stride = sizeof(Vertex);
+		static constexpr std::array<GLuint, attribute_count> sizes = { sizeof(Attributes)... };
+		static constexpr std::array<StaticAttributeType, attribute_count> types = { static_attribute_type<Attributes>()... };
+		static constexpr std::array<GLuint, attribute_count> offsets = [] {
+			std::array<GLuint, attribute_count> o{};
+			GLuint offset = 0;
+			for (GLuint i = 0; i < attribute_count; ++i)
+			{
+				o[i] = offset;
+				offset += sizes[i];
+			}
+			return o;
+			}();
+		template<GLuint A>
+		static constexpr GLuint offset = offsets[A];
+
+		static_assert(attribute_count > 0, "a static vertex layout needs at least one attribute");
+		static_assert(std::is_trivially_copyable_v<Vertex>, "vertex type must be trivially copyable");
+		static_assert(stride == (sizeof(Attributes) + ...), "vertex type must be tightly packed: its size must equal the sum of its attribute sizes");
+
+		static void validate(const VertexBufferLayout& layout) { validate_static_layout(layout, sizes.data(), types.data(), attribute_count); }
+
+		static std::shared_ptr<VertexBufferLayout> make_layout(const Shader& shader)
+		{
+			auto layout = layouts::canonical(shader);
+			validate(*layout);
+			return layout;
+		}
+	};
+
+	// TypedCPUVertexBuffer is a CPUVertexBuffer whose CPU copy is an array of Layout::Vertex. The layout is validated once at construction, so accessors need neither offset lookups nor
+	// bounds checks: ref(vertex) is the vertex struct itself, and ref<A>(vertex) is its attribute A at a constexpr offset.
+	template<typename Layout>
+	class TypedCPUVertexBuffer
+	{
+	public:
+		using Vertex = typename Layout::Vertex;
+		template<GLuint A>
+		using Attribute = typename Layout::template Attribute<A>;
+
+	private:
+		VertexBuffer _vb;
+		std::vector<Vertex> _vertices;
+		mutable DirtyRanges _dirty;
+
+		template<GLuint A>
+		static Attribute<A>* attribute(Vertex* v) { return reinterpret_cast<Attribute<A>*>(reinterpret_cast<std::byte*>(v) + Layout::template offset<A>); }
+		template<GLuint A>
+		static const Attribute<A>* attribute(const Vertex* v) { return reinterpret_cast<const Attribute<A>*>(reinterpret_cast<const std::byte*>(v) + Layout::template offset<A>); }
+
+	public:
+		TypedCPUVertexBuffer(VertexBuffer&& vb, GLuint vertex_count, bool is_mutable)
+			: _vb(std::move(vb)), _vertices(vertex_count)
+		{
+			Layout::validate(*_vb.layout());
+			if (is_mutable)
+				buffers::init_mutable(_vb.vb(), bytes(), _vertices.data());
+			else
+				buffers::init_immutable(_vb.vb(), bytes(), _vertices.data());
+		}
+
+		const std::shared_ptr<VertexBufferLayout>& layout() const { return _vb.layout(); }
+		const VertexBuffer& vertex_buffer() const { return _vb; }
+		ids::VertexArray vao() const { return _vb.vao(); }
+		ids::GLBuffer vb() const { return _vb.vb(); }
+		void bind_vao() const { _vb.bind_vao(); }
+		void bind_vb() const { _vb.bind_vb(); }
+		void attach_index_buffer(ids::GLBuffer ib) { _vb.attach_index_buffer(ib); }
+
+		GLuint vertex_count() const { return (GLuint)_vertices.size(); }
+		GLsizeiptr bytes() const { return (GLsizeiptr)_vertices.size() * Layout::stride; }
+		const Vertex* data() const { return _vertices.data(); }
+
+		void subsend_full() const
+		{
+			buffers::subsend(_vb.vb(), 0, bytes(), _vertices.data());
+			_dirty.clear();
+		}
+
+		void flush() const
+		{
+			for (const DirtyRanges::Range& range : _dirty.ranges())
+				buffers::subsend(_vb.vb(), range.begin, range.bytes(), reinterpret_cast<const std::byte*>(_vertices.data()) + range.begin);
+			_dirty.clear();
+		}
+
+		void mark_dirty(GLuint first_vertex, GLuint count) const { _dirty.mark((size_t)first_vertex * Layout::stride, (size_t)count * Layout::stride); }
+		bool is_dirty() const { return !_dirty.empty(); }
+
+		const Vertex& ref(GLuint vertex) const { return _vertices[vertex]; }
+		Vertex& ref(GLuint vertex)
+		{
+			mark_dirty(vertex, 1);
+			return _vertices[vertex];
+		}
+
+		template<GLuint A>
+		const Attribute<A>& ref(GLuint vertex) const { return *attribute<A>(&_vertices[vertex]); }
+		template<GLuint A>
+		Attribute<A>& ref(GLuint vertex)
+		{
+			_dirty.mark((size_t)vertex * Layout::stride + Layout::template offset<A>, sizeof(Attribute<A>));
+			return *attribute<A>(&_vertices[vertex]);
+		}
+
+		void set_vertex(GLuint vertex, const Vertex& v) { ref(vertex) = v; }
+		void set_vertices(GLuint first_vertex, GLuint count, const Vertex* vertices)
+		{
+			std::memcpy(&_vertices[first_vertex], vertices, (size_t)count * Layout::stride);
+			mark_dirty(first_vertex, count);
+		}
+
+		template<GLuint A>
+		void set_attribute(GLuint first_vertex, GLuint count, const Attribute<A>& value)
+		{
+			for (GLuint v = first_vertex; v < first_vertex + count; ++v)
+				*attribute<A>(&_vertices[v]) = value;
+			if (count > 0)
+				_dirty.mark((size_t)first_vertex * Layout::stride + Layout::template offset<A>, (size_t)(count - 1) * Layout::stride + sizeof(Attribute<A>));
+		}
+
+		template<GLuint A>
+		void set_attribute(const Attribute<A>& value) { set_attribute<A>(0, vertex_count(), value); }
+	};
+}
@@ -4,6 +4,7 @@
 
 #include "Errors.h"
 #include "Input.h"
+#include "QuadIndices.h"
 #include "raii/Shader.h"
 #include "raii/Texture.h"
 
@@ -22,13 +23,13 @@ void vg::init(const vg::InitializationConfiguration& config)
 
 void vg::terminate()
 {
+	quads::release();
 	glfwTerminate();
 }
 
 void vg::new_frame()
 {
 	glfwPollEvents();
-	update_bound_shader();
 }
 
 bool vg::min_opengl_version_is_at_least(GLuint major, GLuint minor)
@@ -127,3 +128,47 @@ void vg::clear_buffer()
 {
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 }
+
+
+GLsync vg::fences::insert()
+{
+	return glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+bool vg::fences::is_signaled(GLsync fence)
+{
+	if (!fence)
+		return true;
+	GLenum status = glClientWaitSync(fence, 0, 0);
+	if (status == GL_WAIT_FAILED)
+		throw Error(ErrorCode::FENCE_WAIT);
+	return status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED;
+}
+
+void vg::fences::wait(GLsync fence)
+{
+	if (!fence)
+		return;
+	// The first poll doesn't flush, so a fence that has already passed costs nothing. Later polls flush so that the fence is guaranteed to eventually signal.
+	GLbitfield flags = 0;
+	GLuint64 timeout_ns = 0;
+	for (;;)
+	{
+		GLenum status = glClientWaitSync(fence, flags, timeout_ns);
+		if (status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED)
+			return;
+		else if (status == GL_WAIT_FAILED)
+			throw Error(ErrorCode::FENCE_WAIT);
+		flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+		timeout_ns = 1'000'000;
+	}
+}
+
+void vg::fences::discard(GLsync& fence)
+{
+	if (fence)
+	{
+		glDeleteSync(fence);
+		fence = nullptr;
+	}
+}
@@ -22,8 +22,8 @@
 #ifndef VANGUARD_MIN_OPENGL_VERSION_MINOR
 #define VANGUARD_MIN_OPENGL_VERSION_MINOR 5
 #endif
-#define VANGUARD_MIN_OPENGL_VERSION_IS_AT_LEAST(major, minor) VANGUARD_MIN_OPENGL_VERSION_MAJOR > major || (VANGUARD_MIN_OPENGL_VERSION_MAJOR == major && VANGUARD_MIN_OPENGL_VERSION_MINOR >= minor)
-#define VANGUARD_MIN_OPENGL_VERSION_IS_AT_MOST(major, minor) VANGUARD_MIN_OPENGL_VERSION_MAJOR < major || (VANGUARD_MIN_OPENGL_VERSION_MAJOR == major && VANGUARD_MIN_OPENGL_VERSION_MINOR <= minor)
+#define VANGUARD_MIN_OPENGL_VERSION_IS_AT_LEAST(major, minor) (VANGUARD_MIN_OPENGL_VERSION_MAJOR > major || (VANGUARD_MIN_OPENGL_VERSION_MAJOR == major && VANGUARD_MIN_OPENGL_VERSION_MINOR >= minor))
+#define VANGUARD_MIN_OPENGL_VERSION_IS_AT_MOST(major, minor) (VANGUARD_MIN_OPENGL_VERSION_MAJOR < major || (VANGUARD_MIN_OPENGL_VERSION_MAJOR == major && VANGUARD_MIN_OPENGL_VERSION_MINOR <= minor))
 
 #include "Vendor.h"
 
@@ -55,4 +55,12 @@ namespace vg
 
 	extern void set_clear_color(glm::vec4 rgba);
 	extern void clear_buffer();
+
+	namespace fences
+	{
+		extern GLsync insert();
+		extern bool is_signaled(GLsync fence);
+		extern void wait(GLsync fence);
+		extern void discard(GLsync& fence);
+	}
 }
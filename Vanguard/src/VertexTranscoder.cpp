@@ -0,0 +1,97 @@
+#include "VertexTranscoder.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "Errors.h"
+
+// Vertices per tile. Large enough to amortize the per-run setup, small enough that a tile of a wide interleaved vertex stays within L1.
+static const GLuint TILE_VERTICES = 256;
+
+struct Run
+{
+	GLuint block;
+	size_t interleaved_offset;
+	size_t block_offset;
+	size_t bytes;
+};
+
+static std::vector<Run> runs(const vg::VertexBufferLayout& layout, const vg::VertexFormat& format)
+{
+	const auto& attributes = layout.attributes();
+	if (attributes.size() != format.attribute_count())
+		throw vg::Error(vg::ErrorCode::VERTEX_LAYOUT_MISMATCH, "layout has " + std::to_string(attributes.size()) + " attributes, but the block format has "
+			+ std::to_string(format.attribute_count()));
+
+	std::vector<Run> rs;
+	for (GLuint b = 0; b < format.block_count(); ++b)
+	{
+		for (GLuint attrib : format.block_attributes(b))
+		{
+			size_t interleaved_offset = attributes[attrib].get_offset();
+			size_t block_offset = format.offset(attrib);
+			size_t bytes = attributes[attrib].bytes();
+			if (!rs.empty() && rs.back().block == b && rs.back().interleaved_offset + rs.back().bytes == interleaved_offset && rs.back().block_offset + rs.back().bytes == block_offset)
+				rs.back().bytes += bytes;
+			else
+				rs.push_back({ b, interleaved_offset, block_offset, bytes });
+		}
+	}
+	return rs;
+}
+
+void vg::transcode::to_blocks(const VertexBufferLayout& layout, const VoidArray& interleaved, const VertexFormat& format, std::vector<VoidArray>& blocks)
+{
+	std::vector<Run> rs = runs(layout, format);
+	size_t stride = layout.stride();
+	GLuint vertex_count = stride == 0 ? 0 : GLuint(interleaved.size() / stride);
+
+	blocks.resize(format.block_count());
+	for (GLuint b = 0; b < format.block_count(); ++b)
+		blocks[b].resize((size_t)vertex_count * format.stride(b));
+
+	const char* src = (const char*)(const void*)interleaved;
+	for (GLuint first = 0; first < vertex_count; first += TILE_VERTICES)
+	{
+		GLuint count = std::min(TILE_VERTICES, vertex_count - first);
+		for (const Run& run : rs)
+		{
+			size_t block_stride = format.stride(run.block);
+			char* dst = (char*)(void*)blocks[run.block];
+			strided::copy(dst + first * block_stride + run.block_offset, block_stride, src + first * stride + run.interleaved_offset, stride, count, run.bytes);
+		}
+	}
+}
+
+void vg::transcode::to_interleaved(const VertexFormat& format, const std::vector<const VoidArray*>& blocks, GLuint vertex_count, const VertexBufferLayout& layout, VoidArray& interleaved)
+{
+	std::vector<Run> rs = runs(layout, format);
+	size_t stride = layout.stride();
+	if (blocks.size() != format.block_count())
+		throw block_index_out_of_range(format.block_count(), blocks.size());
+	for (GLuint b = 0; b < format.block_count(); ++b)
+	{
+		size_t needed = (size_t)vertex_count * format.stride(b);
+		if (blocks[b]->size() < needed)
+			throw offset_out_of_range(blocks[b]->size(), 0, needed);
+	}
+
+	interleaved.resize((size_t)vertex_count * stride);
+	char* dst = (char*)(void*)interleaved;
+	size_t covered = 0;
+	for (const Run& run : rs)
+		covered += run.bytes;
+	if (covered < stride)
+		std::memset(dst, 0, interleaved.size());
+
+	for (GLuint first = 0; first < vertex_count; first += TILE_VERTICES)
+	{
+		GLuint count = std::min(TILE_VERTICES, vertex_count - first);
+		for (const Run& run : rs)
+		{
+			size_t block_stride = format.stride(run.block);
+			const char* src = (const char*)(const void*)*blocks[run.block];
+			strided::copy(dst + first * stride + run.interleaved_offset, stride, src + first * block_stride + run.block_offset, block_stride, count, run.bytes);
+		}
+	}
+}
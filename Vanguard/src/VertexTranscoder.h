@@ -0,0 +1,17 @@
+#pragma once
+
+#include "Renderable.h"
+
+namespace vg
+{
+	// transcode converts vertex data between the interleaved arrangement of a VertexBufferLayout (one buffer, layout stride) and the block arrangement of a VertexFormat,
+	// such as a VertexBufferBlock's. Attributes that sit next to each other in both arrangements are moved together as one run, and runs are copied with the strided kernels
+	// a tile of vertices at a time, so the source tile stays in cache while every block takes its share of it.
+	namespace transcode
+	{
+		// Splits interleaved into one VoidArray per block of format, resizing blocks to fit. Attributes of layout that format does not place in any block are dropped.
+		extern void to_blocks(const VertexBufferLayout& layout, const VoidArray& interleaved, const VertexFormat& format, std::vector<VoidArray>& blocks);
+		// Joins the first vertex_count vertices of each block into interleaved, resizing it to fit. Attributes that format does not place in any block are zeroed.
+		extern void to_interleaved(const VertexFormat& format, const std::vector<const VoidArray*>& blocks, GLuint vertex_count, const VertexBufferLayout& layout, VoidArray& interleaved);
+	}
+}
@@ -1,10 +1,15 @@
 #include "FrameBuffer.h"
 
 #include "Errors.h"
+#include "GLState.h"
 
 vg::raii::FrameBuffer::FrameBuffer()
 {
+#if VANGUARD_MIN_OPENGL_VERSION_IS_AT_LEAST(4, 5)
+	glCreateFramebuffers(1, (GLuint*)&_f);
+#else
 	glGenFramebuffers(1, (GLuint*)&_f);
+#endif
 }
 
 vg::raii::FrameBuffer::FrameBuffer(FrameBuffer&& other) noexcept
@@ -17,6 +22,7 @@ vg::raii::FrameBuffer& vg::raii::FrameBuffer::operator=(FrameBuffer&& other) noe
 {
 	if (this != &other)
 	{
+		state::forget_framebuffers((GLuint*)&_f, 1);
 		glDeleteFramebuffers(1, (GLuint*)&_f);
 		_f = other._f;
 		other._f = ids::FrameBuffer(0);
@@ -26,13 +32,19 @@ vg::raii::FrameBuffer& vg::raii::FrameBuffer::operator=(FrameBuffer&& other) noe
 
 vg::raii::FrameBuffer::~FrameBuffer()
 {
+	state::forget_framebuffers((GLuint*)&_f, 1);
 	glDeleteFramebuffers(1, (GLuint*)&_f);
 }
 
 vg::raii::FrameBufferBlock::FrameBufferBlock(GLuint count)
 	: count(count)
 {
+	_fs = new ids::FrameBuffer[count];
+#if VANGUARD_MIN_OPENGL_VERSION_IS_AT_LEAST(4, 5)
+	glCreateFramebuffers(count, (GLuint*)_fs);
+#else
 	glGenFramebuffers(count, (GLuint*)_fs);
+#endif
 }
 
 vg::raii::FrameBufferBlock::FrameBufferBlock(FrameBufferBlock&& other) noexcept
@@ -46,7 +58,9 @@ vg::raii::FrameBufferBlock& vg::raii::FrameBufferBlock::operator=(FrameBufferBlo
 {
 	if (this != &other)
 	{
+		state::forget_framebuffers((GLuint*)_fs, count);
 		glDeleteFramebuffers(count, (GLuint*)_fs);
+		delete[] _fs;
 		_fs = other._fs;
 		other._fs = nullptr;
 		count = other.count;
@@ -57,7 +71,9 @@ vg::raii::FrameBufferBlock& vg::raii::FrameBufferBlock::operator=(FrameBufferBlo
 
 vg::raii::FrameBufferBlock::~FrameBufferBlock()
 {
+	state::forget_framebuffers((GLuint*)_fs, count);
 	glDeleteFramebuffers(count, (GLuint*)_fs);
+	delete[] _fs;
 }
 
 vg::ids::FrameBuffer vg::raii::FrameBufferBlock::operator[](GLuint i) const
@@ -69,12 +85,12 @@ vg::ids::FrameBuffer vg::raii::FrameBufferBlock::operator[](GLuint i) const
 
 void vg::framebuffers::bind(ids::FrameBuffer fb, Target target)
 {
-	glBindFramebuffer((GLenum)target, fb);
+	state::bind_framebuffer((GLenum)target, fb);
 }
 
 void vg::framebuffers::unbind(Target target)
 {
-	glBindFramebuffer((GLenum)target, 0);
+	state::bind_framebuffer((GLenum)target, 0);
 }
 
 void vg::framebuffers::attach_texture(ids::Texture texture, Attachment attachment, Target target)
@@ -1,11 +1,18 @@
 #include "GLBuffer.h"
 
+#include <algorithm>
+
 #include "Vanguard.h"
 #include "Errors.h"
+#include "GLState.h"
 
 vg::raii::GLBuffer::GLBuffer()
 {
+#if VANGUARD_MIN_OPENGL_VERSION_IS_AT_LEAST(4, 5)
+	glCreateBuffers(1, (GLuint*)&_b);
+#else
 	glGenBuffers(1, (GLuint*)&_b);
+#endif
 }
 
 vg::raii::GLBuffer::GLBuffer(GLBuffer&& other) noexcept
@@ -18,6 +25,8 @@ vg::raii::GLBuffer& vg::raii::GLBuffer::operator=(GLBuffer&& other) noexcept
 {
 	if (this != &other)
 	{
+		state::forget_buffers((GLuint*)&_b, 1);
+		buffers::forget_metadata((GLuint*)&_b, 1);
 		glDeleteBuffers(1, (GLuint*)&_b);
 		_b = other._b;
 		other._b = B(0);
@@ -27,6 +36,8 @@ vg::raii::GLBuffer& vg::raii::GLBuffer::operator=(GLBuffer&& other) noexcept
 
 vg::raii::GLBuffer::~GLBuffer()
 {
+	state::forget_buffers((GLuint*)&_b, 1);
+	buffers::forget_metadata((GLuint*)&_b, 1);
 	glDeleteBuffers(1, (GLuint*)&_b);
 }
 
@@ -34,7 +45,11 @@ vg::raii::GLBufferBlock::GLBufferBlock(GLuint count)
 	: count(count)
 {
 	_bs = new B[count];
+#if VANGUARD_MIN_OPENGL_VERSION_IS_AT_LEAST(4, 5)
+	glCreateBuffers(count, (GLuint*)_bs);
+#else
 	glGenBuffers(count, (GLuint*)_bs);
+#endif
 }
 
 vg::raii::GLBufferBlock::GLBufferBlock(GLBufferBlock&& other) noexcept
@@ -48,6 +63,8 @@ vg::raii::GLBufferBlock& vg::raii::GLBufferBlock::operator=(GLBufferBlock&& othe
 {
 	if (this != &other)
 	{
+		state::forget_buffers((GLuint*)_bs, count);
+		buffers::forget_metadata((GLuint*)_bs, count);
 		glDeleteBuffers(count, (GLuint*)_bs);
 		delete[] _bs;
 		_bs = other._bs;
@@ -60,6 +77,8 @@ vg::raii::GLBufferBlock& vg::raii::GLBufferBlock::operator=(GLBufferBlock&& othe
 
 vg::raii::GLBufferBlock::~GLBufferBlock()
 {
+	state::forget_buffers((GLuint*)_bs, count);
+	buffers::forget_metadata((GLuint*)_bs, count);
 	glDeleteBuffers(count, (GLuint*)_bs);
 	delete[] _bs;
 }
@@ -73,7 +92,11 @@ vg::ids::GLBuffer vg::raii::GLBufferBlock::operator[](GLuint i) const
 
 vg::raii::VertexArray::VertexArray()
 {
+#if VANGUARD_MIN_OPENGL_VERSION_IS_AT_LEAST(4, 5)
+	glCreateVertexArrays(1, (GLuint*)&_vao);
+#else
 	glGenVertexArrays(1, (GLuint*)&_vao);
+#endif
 }
 
 vg::raii::VertexArray::VertexArray(VertexArray&& other) noexcept
@@ -86,6 +109,7 @@ vg::raii::VertexArray& vg::raii::VertexArray::operator=(VertexArray&& other) noe
 {
 	if (this != &other)
 	{
+		state::forget_vertex_arrays((GLuint*)&_vao, 1);
 		glDeleteVertexArrays(1, (GLuint*)&_vao);
 		_vao = other._vao;
 		other._vao = V(0);
@@ -95,19 +119,24 @@ vg::raii::VertexArray& vg::raii::VertexArray::operator=(VertexArray&& other) noe
 
 vg::raii::VertexArray::~VertexArray()
 {
+	state::forget_vertex_arrays((GLuint*)&_vao, 1);
 	glDeleteVertexArrays(1, (GLuint*)&_vao);
 }
 
 void vg::raii::VertexArray::bind() const
 {
-	glBindVertexArray(_vao);;
+	state::bind_vertex_array(_vao);
 }
 
 vg::raii::VertexArrayBlock::VertexArrayBlock(GLuint count)
 	: count(count)
 {
 	_vaos = new V[count];
+#if VANGUARD_MIN_OPENGL_VERSION_IS_AT_LEAST(4, 5)
+	glCreateVertexArrays(count, (GLuint*)_vaos);
+#else
 	glGenVertexArrays(count, (GLuint*)_vaos);
+#endif
 }
 
 vg::raii::VertexArrayBlock::VertexArrayBlock(VertexArrayBlock&& other) noexcept
@@ -121,6 +150,7 @@ vg::raii::VertexArrayBlock& vg::raii::VertexArrayBlock::operator=(VertexArrayBlo
 {
 	if (this != &other)
 	{
+		state::forget_vertex_arrays((GLuint*)_vaos, count);
 		glDeleteVertexArrays(count, (GLuint*)_vaos);
 		delete[] _vaos;
 		_vaos = other._vaos;
@@ -133,6 +163,7 @@ vg::raii::VertexArrayBlock& vg::raii::VertexArrayBlock::operator=(VertexArrayBlo
 
 vg::raii::VertexArrayBlock::~VertexArrayBlock()
 {
+	state::forget_vertex_arrays((GLuint*)_vaos, count);
 	glDeleteVertexArrays(count, (GLuint*)_vaos);
 	delete[] _vaos;
 }
@@ -148,7 +179,7 @@ void vg::raii::VertexArrayBlock::bind(GLuint i) const
 {
 	if (i >= count)
 		throw block_index_out_of_range(count, i);
-	glBindVertexArray(_vaos[i]);
+	state::bind_vertex_array(_vaos[i]);
 }
 
 GLintptr vg::index_data_type_size(IndexDataType idt)
@@ -165,31 +196,49 @@ GLintptr vg::index_data_type_size(IndexDataType idt)
 
 void vg::bind_index_buffer_to_vertex_array(ids::GLBuffer ib, ids::VertexArray va)
 {
-	glBindVertexArray(va);
+#if VANGUARD_MIN_OPENGL_VERSION_IS_AT_LEAST(4, 5)
+	glVertexArrayElementBuffer(va, ib);
+	state::set_vertex_array_index_buffer(va, ib);
+#else
+	state::bind_vertex_array(va);
 	buffers::bind(ib, BufferTarget::INDEX);
-	glBindVertexArray(0);
+	state::bind_vertex_array(0);
+#endif
 }
 
 void vg::bind_index_buffers_to_vertex_arrays(const ids::GLBuffer* ibs, const ids::VertexArray* vas, GLuint count)
 {
+#if VANGUARD_MIN_OPENGL_VERSION_IS_AT_LEAST(4, 5)
 	for (GLuint i = 0; i < count; ++i)
 	{
-		glBindVertexArray(vas[i]);
+		glVertexArrayElementBuffer(vas[i], ibs[i]);
+		state::set_vertex_array_index_buffer(vas[i], ibs[i]);
+	}
+#else
+	for (GLuint i = 0; i < count; ++i)
+	{
+		state::bind_vertex_array(vas[i]);
 		buffers::bind(ibs[i], BufferTarget::INDEX);
 	}
-	glBindVertexArray(0);
+	state::bind_vertex_array(0);
+#endif
+}
+
+void vg::bind_vertex_array(ids::VertexArray va)
+{
+	state::bind_vertex_array(va);
 }
 
 void vg::unbind_vertex_array()
 {
 	buffers::unbind(BufferTarget::VERTEX);
-	glBindVertexArray(0);
+	state::bind_vertex_array(0);
 }
 
 vg::GPUIndirectArrays::GPUIndirectArrays()
 {
-	bind();
-	buffers::init_immutable(BufferTarget::DRAW_INDIRECT, sizeof(IndirectArraysCmd));
+	buffers::set_category(b, MemoryCategory::INDIRECT_BUFFER);
+	buffers::init_immutable(b, sizeof(IndirectArraysCmd));
 }
 
 void vg::GPUIndirectArrays::bind() const
@@ -199,34 +248,34 @@ void vg::GPUIndirectArrays::bind() const
 
 void vg::GPUIndirectArrays::send_vertex_count(GLuint vertex_count) const
 {
-	buffers::subsend(BufferTarget::DRAW_INDIRECT, 0, sizeof(GLuint), &vertex_count);
+	buffers::subsend(b, 0, sizeof(GLuint), &vertex_count);
 }
 
 void vg::GPUIndirectArrays::send_instance_count(GLuint instance_count) const
 {
-	buffers::subsend(BufferTarget::DRAW_INDIRECT, sizeof(GLuint), sizeof(GLuint), &instance_count);
+	buffers::subsend(b, sizeof(GLuint), sizeof(GLuint), &instance_count);
 }
 
 void vg::GPUIndirectArrays::send_first_vertex(GLuint first_vertex) const
 {
-	buffers::subsend(BufferTarget::DRAW_INDIRECT, 2 * sizeof(GLuint), sizeof(GLuint), &first_vertex);
+	buffers::subsend(b, 2 * sizeof(GLuint), sizeof(GLuint), &first_vertex);
 }
 
 void vg::GPUIndirectArrays::send_first_instance(GLuint first_instance) const
 {
-	buffers::subsend(BufferTarget::DRAW_INDIRECT, 3 * sizeof(GLuint), sizeof(GLuint), &first_instance);
+	buffers::subsend(b, 3 * sizeof(GLuint), sizeof(GLuint), &first_instance);
 }
 
 void vg::GPUIndirectArrays::send_cmd(IndirectArraysCmd cmd) const
 {
-	buffers::subsend(BufferTarget::DRAW_INDIRECT, 0, sizeof(IndirectArraysCmd), &cmd);
+	buffers::subsend(b, 0, sizeof(IndirectArraysCmd), &cmd);
 }
 
 vg::GPUIndirectArraysBlock::GPUIndirectArraysBlock(GLuint count)
 	: count(count)
 {
-	bind();
-	buffers::init_immutable(BufferTarget::DRAW_INDIRECT, count * sizeof(IndirectArraysCmd));
+	buffers::set_category(b, MemoryCategory::INDIRECT_BUFFER);
+	buffers::init_immutable(b, count * sizeof(IndirectArraysCmd));
 }
 
 void vg::GPUIndirectArraysBlock::bind() const
@@ -238,35 +287,35 @@ void vg::GPUIndirectArraysBlock::send_vertex_count(GLuint i, GLuint vertex_count
 {
 	if (i >= count)
 		throw block_index_out_of_range(count, i);
-	buffers::subsend(BufferTarget::DRAW_INDIRECT, i * sizeof(IndirectArraysCmd), sizeof(GLuint), &vertex_count);
+	buffers::subsend(b, i * sizeof(IndirectArraysCmd), sizeof(GLuint), &vertex_count);
 }
 
 void vg::GPUIndirectArraysBlock::send_instance_count(GLuint i, GLuint instance_count) const
 {
 	if (i >= count)
 		throw block_index_out_of_range(count, i);
-	buffers::subsend(BufferTarget::DRAW_INDIRECT, sizeof(GLuint) + i * sizeof(IndirectArraysCmd), sizeof(GLuint), &instance_count);
+	buffers::subsend(b, sizeof(GLuint) + i * sizeof(IndirectArraysCmd), sizeof(GLuint), &instance_count);
 }
 
 void vg::GPUIndirectArraysBlock::send_first_vertex(GLuint i, GLuint first_vertex) const
 {
 	if (i >= count)
 		throw block_index_out_of_range(count, i);
-	buffers::subsend(BufferTarget::DRAW_INDIRECT, 2 * sizeof(GLuint) + i * sizeof(IndirectArraysCmd), sizeof(GLuint), &first_vertex);
+	buffers::subsend(b, 2 * sizeof(GLuint) + i * sizeof(IndirectArraysCmd), sizeof(GLuint), &first_vertex);
 }
 
 void vg::GPUIndirectArraysBlock::send_first_instance(GLuint i, GLuint first_instance) const
 {
 	if (i >= count)
 		throw block_index_out_of_range(count, i);
-	buffers::subsend(BufferTarget::DRAW_INDIRECT, 3 * sizeof(GLuint) + i * sizeof(IndirectArraysCmd), sizeof(GLuint), &first_instance);
+	buffers::subsend(b, 3 * sizeof(GLuint) + i * sizeof(IndirectArraysCmd), sizeof(GLuint), &first_instance);
 }
 
 void vg::GPUIndirectArraysBlock::send_cmd(GLuint i, IndirectArraysCmd cmd) const
 {
 	if (i >= count)
 		throw block_index_out_of_range(count, i);
-	buffers::subsend(BufferTarget::DRAW_INDIRECT, i * sizeof(IndirectArraysCmd), sizeof(IndirectArraysCmd), &cmd);
+	buffers::subsend(b, i * sizeof(IndirectArraysCmd), sizeof(IndirectArraysCmd), &cmd);
 }
 
 void vg::GPUIndirectArraysBlock::send_cmds(GLuint first, GLuint count, IndirectArraysCmd* cmds) const
@@ -274,13 +323,62 @@ void vg::GPUIndirectArraysBlock::send_cmds(GLuint first, GLuint count, IndirectA
 	GLuint last = first + count - 1;
 	if (last >= this->count)
 		throw block_index_out_of_range(this->count, last);
-	buffers::subsend(BufferTarget::DRAW_INDIRECT, first * sizeof(IndirectArraysCmd), count * sizeof(IndirectArraysCmd), cmds);
+	buffers::subsend(b, first * sizeof(IndirectArraysCmd), count * sizeof(IndirectArraysCmd), cmds);
+}
+
+// Unchanged commands that flush() uploads to join two changed runs. A few hundred bytes of extra upload costs less than another glBufferSubData call.
+static const size_t INDIRECT_FLUSH_MAX_GAP = 32;
+
+vg::CPUIndirectArraysBlock::CPUIndirectArraysBlock(GLuint count)
+	: g(count), _cmds(count, IndirectArraysCmd{}), _dirty(count)
+{
+	_dirty.mark(0, count);
+}
+
+const vg::IndirectArraysCmd& vg::CPUIndirectArraysBlock::cmd(GLuint i) const
+{
+	if (i >= _cmds.size())
+		throw block_index_out_of_range(_cmds.size(), i);
+	return _cmds[i];
+}
+
+vg::IndirectArraysCmd& vg::CPUIndirectArraysBlock::cmd(GLuint i)
+{
+	if (i >= _cmds.size())
+		throw block_index_out_of_range(_cmds.size(), i);
+	_dirty.mark(i);
+	return _cmds[i];
+}
+
+void vg::CPUIndirectArraysBlock::set_cmds(GLuint first, GLuint count, const IndirectArraysCmd* cmds)
+{
+	mark_dirty(first, count);
+	std::copy(cmds, cmds + count, _cmds.begin() + first);
+}
+
+void vg::CPUIndirectArraysBlock::mark_dirty(GLuint first, GLuint count)
+{
+	if (count == 0)
+		return;
+	GLuint last = first + count - 1;
+	if (last >= _cmds.size())
+		throw block_index_out_of_range(_cmds.size(), last);
+	_dirty.mark(first, count);
+}
+
+void vg::CPUIndirectArraysBlock::flush()
+{
+	if (_dirty.empty())
+		return;
+	for (const DirtyBitmap::Run& run : _dirty.runs(INDIRECT_FLUSH_MAX_GAP))
+		g.send_cmds(GLuint(run.begin), GLuint(run.count()), &_cmds[run.begin]);
+	_dirty.clear();
 }
 
 vg::GPUIndirectElements::GPUIndirectElements()
 {
-	bind();
-	buffers::init_immutable(BufferTarget::DRAW_INDIRECT, sizeof(IndirectElementsCmd));
+	buffers::set_category(b, MemoryCategory::INDIRECT_BUFFER);
+	buffers::init_immutable(b, sizeof(IndirectElementsCmd));
 }
 
 void vg::GPUIndirectElements::bind() const
@@ -290,39 +388,39 @@ void vg::GPUIndirectElements::bind() const
 
 void vg::GPUIndirectElements::send_index_count(GLuint index_count) const
 {
-	buffers::subsend(BufferTarget::DRAW_INDIRECT, 0, sizeof(GLuint), &index_count);
+	buffers::subsend(b, 0, sizeof(GLuint), &index_count);
 }
 
 void vg::GPUIndirectElements::send_instance_count(GLuint instance_count) const
 {
-	buffers::subsend(BufferTarget::DRAW_INDIRECT, sizeof(GLuint), sizeof(GLuint), &instance_count);
+	buffers::subsend(b, sizeof(GLuint), sizeof(GLuint), &instance_count);
 }
 
 void vg::GPUIndirectElements::send_first_index(GLuint first_index) const
 {
-	buffers::subsend(BufferTarget::DRAW_INDIRECT, 2 * sizeof(GLuint), sizeof(GLuint), &first_index);
+	buffers::subsend(b, 2 * sizeof(GLuint), sizeof(GLuint), &first_index);
 }
 
 void vg::GPUIndirectElements::send_base_vertex(GLuint base_vertex) const
 {
-	buffers::subsend(BufferTarget::DRAW_INDIRECT, 3 * sizeof(GLuint), sizeof(GLuint), &base_vertex);
+	buffers::subsend(b, 3 * sizeof(GLuint), sizeof(GLuint), &base_vertex);
 }
 
 void vg::GPUIndirectElements::send_first_instance(GLuint first_instance) const
 {
-	buffers::subsend(BufferTarget::DRAW_INDIRECT, 4 * sizeof(GLuint), sizeof(GLuint), &first_instance);
+	buffers::subsend(b, 4 * sizeof(GLuint), sizeof(GLuint), &first_instance);
 }
 
 void vg::GPUIndirectElements::send_cmd(IndirectElementsCmd cmd) const
 {
-	buffers::subsend(BufferTarget::DRAW_INDIRECT, 0, sizeof(IndirectElementsCmd), &cmd);
+	buffers::subsend(b, 0, sizeof(IndirectElementsCmd), &cmd);
 }
 
 vg::GPUIndirectElementsBlock::GPUIndirectElementsBlock(GLuint count)
 	: count(count)
 {
-	bind();
-	buffers::init_immutable(BufferTarget::DRAW_INDIRECT, count * sizeof(IndirectElementsCmd));
+	buffers::set_category(b, MemoryCategory::INDIRECT_BUFFER);
+	buffers::init_immutable(b, count * sizeof(IndirectElementsCmd));
 }
 
 void vg::GPUIndirectElementsBlock::bind() const
@@ -334,42 +432,42 @@ void vg::GPUIndirectElementsBlock::send_index_count(GLuint i, GLuint index_count
 {
 	if (i >= count)
 		throw block_index_out_of_range(count, i);
-	buffers::subsend(BufferTarget::DRAW_INDIRECT, i * sizeof(IndirectElementsCmd), sizeof(GLuint), &index_count);
+	buffers::subsend(b, i * sizeof(IndirectElementsCmd), sizeof(GLuint), &index_count);
 }
 
 void vg::GPUIndirectElementsBlock::send_instance_count(GLuint i, GLuint instance_count) const
 {
 	if (i >= count)
 		throw block_index_out_of_range(count, i);
-	buffers::subsend(BufferTarget::DRAW_INDIRECT, sizeof(GLuint) + i * sizeof(IndirectElementsCmd), sizeof(GLuint), &instance_count);
+	buffers::subsend(b, sizeof(GLuint) + i * sizeof(IndirectElementsCmd), sizeof(GLuint), &instance_count);
 }
 
 void vg::GPUIndirectElementsBlock::send_first_index(GLuint i, GLuint first_index) const
 {
 	if (i >= count)
 		throw block_index_out_of_range(count, i);
-	buffers::subsend(BufferTarget::DRAW_INDIRECT, 2 * sizeof(GLuint) + i * sizeof(IndirectElementsCmd), sizeof(GLuint), &first_index);
+	buffers::subsend(b, 2 * sizeof(GLuint) + i * sizeof(IndirectElementsCmd), sizeof(GLuint), &first_index);
 }
 
 void vg::GPUIndirectElementsBlock::send_base_vertex(GLuint i, GLuint base_vertex) const
 {
 	if (i >= count)
 		throw block_index_out_of_range(count, i);
-	buffers::subsend(BufferTarget::DRAW_INDIRECT, 3 * sizeof(GLuint) + i * sizeof(IndirectElementsCmd), sizeof(GLuint), &base_vertex);
+	buffers::subsend(b, 3 * sizeof(GLuint) + i * sizeof(IndirectElementsCmd), sizeof(GLuint), &base_vertex);
 }
 
 void vg::GPUIndirectElementsBlock::send_first_instance(GLuint i, GLuint first_instance) const
 {
 	if (i >= count)
 		throw block_index_out_of_range(count, i);
-	buffers::subsend(BufferTarget::DRAW_INDIRECT, 4 * sizeof(GLuint) + i * sizeof(IndirectElementsCmd), sizeof(GLuint), &first_instance);
+	buffers::subsend(b, 4 * sizeof(GLuint) + i * sizeof(IndirectElementsCmd), sizeof(GLuint), &first_instance);
 }
 
 void vg::GPUIndirectElementsBlock::send_cmd(GLuint i, IndirectElementsCmd cmd) const
 {
 	if (i >= count)
 		throw block_index_out_of_range(count, i);
-	buffers::subsend(BufferTarget::DRAW_INDIRECT, i * sizeof(IndirectElementsCmd), sizeof(IndirectElementsCmd), &cmd);
+	buffers::subsend(b, i * sizeof(IndirectElementsCmd), sizeof(IndirectElementsCmd), &cmd);
 }
 
 void vg::GPUIndirectElementsBlock::send_cmds(GLuint first, GLuint count, IndirectElementsCmd* cmds) const
@@ -377,27 +475,193 @@ void vg::GPUIndirectElementsBlock::send_cmds(GLuint first, GLuint count, Indirec
 	GLuint last = first + count - 1;
 	if (last >= this->count)
 		throw block_index_out_of_range(this->count, last);
-	buffers::subsend(BufferTarget::DRAW_INDIRECT, first * sizeof(IndirectElementsCmd), count * sizeof(IndirectElementsCmd), cmds);
+	buffers::subsend(b, first * sizeof(IndirectElementsCmd), count * sizeof(IndirectElementsCmd), cmds);
+}
+
+vg::CPUIndirectElementsBlock::CPUIndirectElementsBlock(GLuint count, IndexDataType idt)
+	: g(count), _cmds(count, IndirectElementsCmd{}), _dirty(count), idt(idt)
+{
+	_dirty.mark(0, count);
+}
+
+const vg::IndirectElementsCmd& vg::CPUIndirectElementsBlock::cmd(GLuint i) const
+{
+	if (i >= _cmds.size())
+		throw block_index_out_of_range(_cmds.size(), i);
+	return _cmds[i];
+}
+
+vg::IndirectElementsCmd& vg::CPUIndirectElementsBlock::cmd(GLuint i)
+{
+	if (i >= _cmds.size())
+		throw block_index_out_of_range(_cmds.size(), i);
+	_dirty.mark(i);
+	return _cmds[i];
+}
+
+void vg::CPUIndirectElementsBlock::set_cmds(GLuint first, GLuint count, const IndirectElementsCmd* cmds)
+{
+	mark_dirty(first, count);
+	std::copy(cmds, cmds + count, _cmds.begin() + first);
+}
+
+void vg::CPUIndirectElementsBlock::mark_dirty(GLuint first, GLuint count)
+{
+	if (count == 0)
+		return;
+	GLuint last = first + count - 1;
+	if (last >= _cmds.size())
+		throw block_index_out_of_range(_cmds.size(), last);
+	_dirty.mark(first, count);
+}
+
+void vg::CPUIndirectElementsBlock::flush()
+{
+	if (_dirty.empty())
+		return;
+	for (const DirtyBitmap::Run& run : _dirty.runs(INDIRECT_FLUSH_MAX_GAP))
+		g.send_cmds(GLuint(run.begin), GLuint(run.count()), &_cmds[run.begin]);
+	_dirty.clear();
 }
 
 void vg::buffers::bind(ids::GLBuffer b, BufferTarget target)
 {
-	glBindBuffer((GLenum)target, b);
+	state::bind_buffer((GLenum)target, b);
 }
 
 void vg::buffers::unbind(BufferTarget target)
 {
-	glBindBuffer((GLenum)target, 0);
+	state::bind_buffer((GLenum)target, 0);
+}
+
+// Indexed by buffer name, which GL hands out small and dense. known marks the names that have a record.
+static struct
+{
+	std::vector<vg::BufferMetadata> records;
+	std::vector<bool> known;
+	// Set apart from records, since a buffer is usually tagged before its storage is specified. Kept across respecification, and reset to BUFFER when the name is deleted.
+	std::vector<vg::MemoryCategory> categories;
+} metadata_registry;
+
+static void reserve_metadata(GLuint b)
+{
+	if (b >= metadata_registry.records.size())
+	{
+		metadata_registry.records.resize(std::max<size_t>(b + 1, 2 * metadata_registry.records.size()));
+		metadata_registry.known.resize(metadata_registry.records.size());
+		metadata_registry.categories.resize(metadata_registry.records.size(), vg::MemoryCategory::BUFFER);
+	}
+}
+
+// target_category is the category of the target the storage was specified through, and only applies to buffers that no wrapper tagged.
+static void record_metadata(GLuint b, GLsizeiptr size, GLenum usage, bool is_mutable, vg::MemoryCategory target_category = vg::MemoryCategory::BUFFER)
+{
+	if (b == 0 || b == GLuint(-1))
+		return;
+	reserve_metadata(b);
+	vg::MemoryCategory& category = metadata_registry.categories[b];
+	if (metadata_registry.known[b])
+		vg::memory::release(category, metadata_registry.records[b].size);
+	else if (category == vg::MemoryCategory::BUFFER)
+		category = target_category;
+	vg::memory::allocate(category, size);
+	metadata_registry.records[b] = { size, usage, is_mutable };
+	metadata_registry.known[b] = true;
+}
+
+const vg::BufferMetadata* vg::buffers::metadata(ids::GLBuffer buf)
+{
+	GLuint b = buf;
+	return b < metadata_registry.known.size() && metadata_registry.known[b] ? &metadata_registry.records[b] : nullptr;
+}
+
+void vg::buffers::forget_metadata(const GLuint* bufs, GLuint count)
+{
+	for (GLuint i = 0; i < count; ++i)
+	{
+		GLuint b = bufs[i];
+		if (b >= metadata_registry.known.size())
+			continue;
+		if (metadata_registry.known[b])
+			memory::release(metadata_registry.categories[b], metadata_registry.records[b].size);
+		metadata_registry.known[b] = false;
+		metadata_registry.categories[b] = MemoryCategory::BUFFER;
+	}
+}
+
+void vg::buffers::set_category(ids::GLBuffer buf, MemoryCategory category)
+{
+	GLuint b = buf;
+	if (b == 0)
+		return;
+	reserve_metadata(b);
+	if (metadata_registry.known[b])
+		memory::recategorize(metadata_registry.categories[b], category, metadata_registry.records[b].size);
+	metadata_registry.categories[b] = category;
+}
+
+void vg::buffers::set_category(const raii::GLBufferBlock& bufs, MemoryCategory category)
+{
+	for (GLuint i = 0; i < bufs.get_count(); ++i)
+		set_category(bufs[i], category);
+}
+
+vg::MemoryCategory vg::buffers::category(ids::GLBuffer buf)
+{
+	GLuint b = buf;
+	return b < metadata_registry.categories.size() ? metadata_registry.categories[b] : MemoryCategory::BUFFER;
+}
+
+vg::MemoryCategory vg::buffers::target_category(BufferTarget target)
+{
+	switch (target)
+	{
+	case BufferTarget::VERTEX: return MemoryCategory::VERTEX_BUFFER;
+	case BufferTarget::INDEX: return MemoryCategory::INDEX_BUFFER;
+	case BufferTarget::DRAW_INDIRECT:
+	case BufferTarget::DISPATCH_INDIRECT: return MemoryCategory::INDIRECT_BUFFER;
+	case BufferTarget::UNIFORM: return MemoryCategory::UNIFORM_BUFFER;
+	default: return MemoryCategory::BUFFER;
+	}
+}
+
+// The buffer GL actually has bound to target. The state cache can be stale after raw glBindBuffer calls, and metadata recorded against a stale entry would land on another buffer.
+static GLuint queried_binding(vg::BufferTarget target)
+{
+	GLenum binding;
+	switch (target)
+	{
+	case vg::BufferTarget::VERTEX: binding = GL_ARRAY_BUFFER_BINDING; break;
+	case vg::BufferTarget::ATOMIC_COUNTER: binding = GL_ATOMIC_COUNTER_BUFFER_BINDING; break;
+	case vg::BufferTarget::COPY_READ: binding = GL_COPY_READ_BUFFER_BINDING; break;
+	case vg::BufferTarget::COPY_WRITE: binding = GL_COPY_WRITE_BUFFER_BINDING; break;
+	case vg::BufferTarget::DISPATCH_INDIRECT: binding = GL_DISPATCH_INDIRECT_BUFFER_BINDING; break;
+	case vg::BufferTarget::DRAW_INDIRECT: binding = GL_DRAW_INDIRECT_BUFFER_BINDING; break;
+	case vg::BufferTarget::INDEX: binding = GL_ELEMENT_ARRAY_BUFFER_BINDING; break;
+	case vg::BufferTarget::PIXEL_READ: binding = GL_PIXEL_PACK_BUFFER_BINDING; break;
+	case vg::BufferTarget::PIXEL_UNPACK: binding = GL_PIXEL_UNPACK_BUFFER_BINDING; break;
+	case vg::BufferTarget::QUERY: binding = GL_QUERY_BUFFER_BINDING; break;
+	case vg::BufferTarget::SHADER_STORAGE: binding = GL_SHADER_STORAGE_BUFFER_BINDING; break;
+	case vg::BufferTarget::TEXTURE: binding = GL_TEXTURE_BUFFER_BINDING; break;
+	case vg::BufferTarget::TRANSFORM_FEEDBACK: binding = GL_TRANSFORM_FEEDBACK_BUFFER_BINDING; break;
+	case vg::BufferTarget::UNIFORM: binding = GL_UNIFORM_BUFFER_BINDING; break;
+	default: return 0;
+	}
+	GLint bound = 0;
+	glGetIntegerv(binding, &bound);
+	return GLuint(bound);
 }
 
 void vg::buffers::init_immutable(BufferTarget target, GLsizeiptr size, const void* data, int usage)
 {
 	glBufferStorage((GLenum)target, size, data, usage);
+	record_metadata(queried_binding(target), size, usage, false, target_category(target));
 }
 
 void vg::buffers::init_mutable(BufferTarget target, GLsizeiptr size, const void* data, BufferMutableUsage usage)
 {
 	glBufferData((GLenum)target, size, data, (GLenum)usage);
+	record_metadata(queried_binding(target), size, (GLenum)usage, true, target_category(target));
 }
 
 void vg::buffers::subsend(BufferTarget target, GLintptr offset_bytes, GLsizeiptr size, const void* data)
@@ -419,11 +683,67 @@ void vg::buffers::submap(BufferTarget target, GLintptr offset_bytes, GLsizeiptr
 	glUnmapBuffer((GLenum)target);
 }
 
+static GLbitfield map_access(vg::UploadStrategy strategy)
+{
+	switch (strategy)
+	{
+	case vg::UploadStrategy::ORPHAN: return GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT;
+	case vg::UploadStrategy::INVALIDATE: return GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT;
+	case vg::UploadStrategy::UNSYNCHRONIZED: return GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_FLUSH_EXPLICIT_BIT;
+	default: return GL_MAP_WRITE_BIT;
+	}
+}
+
+// Orphaning discards the whole buffer, so an ORPHAN write that doesn't cover all of it would leave the rest undefined.
+static void check_orphan_range(GLsizeiptr buffer_size, GLintptr offset_bytes, GLsizeiptr size)
+{
+	if (offset_bytes != 0 || size != buffer_size)
+		throw vg::Error(vg::ErrorCode::INVALID_UPLOAD_RANGE, "ORPHAN must rewrite all " + std::to_string(buffer_size) + " bytes of the buffer, not "
+			+ std::to_string(size) + " bytes at offset " + std::to_string(offset_bytes));
+}
+
+static GLsizeiptr bound_buffer_size(vg::BufferTarget target)
+{
+	GLuint bound = vg::state::bound_buffer((GLenum)target);
+	if (bound != GLuint(-1))
+		return vg::buffers::size(vg::ids::GLBuffer(bound));
+	GLint64 size;
+	glGetBufferParameteri64v((GLenum)target, GL_BUFFER_SIZE, &size);
+	return GLsizeiptr(size);
+}
+
+void vg::buffers::map(BufferTarget target, const void* data, size_t size, UploadStrategy strategy)
+{
+	submap(target, 0, size, data, strategy);
+}
+
+void vg::buffers::submap(BufferTarget target, GLintptr offset_bytes, GLsizeiptr length_bytes, const void* data, UploadStrategy strategy)
+{
+	if (strategy == UploadStrategy::SUBDATA)
+	{
+		subsend(target, offset_bytes, length_bytes, data);
+		return;
+	}
+	if (strategy == UploadStrategy::ORPHAN)
+		check_orphan_range(bound_buffer_size(target), offset_bytes, length_bytes);
+	void* client = glMapBufferRange((GLenum)target, offset_bytes, length_bytes, map_access(strategy));
+	if (!client)
+		throw Error(ErrorCode::BUFFER_MAPPING, "cannot map " + std::to_string(length_bytes) + " bytes at offset " + std::to_string(offset_bytes));
+	memcpy(client, data, length_bytes);
+	if (strategy == UploadStrategy::UNSYNCHRONIZED)
+		glFlushMappedBufferRange((GLenum)target, 0, length_bytes);
+	glUnmapBuffer((GLenum)target);
+}
+
 void vg::buffers::copy_gl_buffer(ids::GLBuffer b_src, ids::GLBuffer b_dst, GLintptr offset_src_bytes, GLintptr offset_dst_bytes, GLsizeiptr size)
 {
+#if VANGUARD_MIN_OPENGL_VERSION_IS_AT_LEAST(4, 5)
+	glCopyNamedBufferSubData(b_src, b_dst, offset_src_bytes, offset_dst_bytes, size);
+#else
 	bind(b_src, BufferTarget::COPY_READ);
 	bind(b_dst, BufferTarget::COPY_WRITE);
 	glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, offset_src_bytes, offset_dst_bytes, size);
+#endif
 }
 
 void vg::buffers::copy_bound_gl_buffers(GLintptr offset_src_bytes, GLintptr offset_dst_bytes, GLsizeiptr size)
@@ -440,18 +760,144 @@ vg::VoidArray vg::buffers::read(BufferTarget target, GLintptr offset_bytes, GLsi
 
 bool vg::buffers::is_mutable(ids::GLBuffer buf)
 {
+	if (const BufferMetadata* record = metadata(buf))
+		return record->is_mutable;
 	GLint imm;
+#if VANGUARD_MIN_OPENGL_VERSION_IS_AT_LEAST(4, 5)
+	glGetNamedBufferParameteriv(buf, GL_BUFFER_IMMUTABLE_STORAGE, &imm);
+#else
 	bind(buf, BufferTarget::QUERY);
 	glGetBufferParameteriv((GLenum)BufferTarget::QUERY, GL_BUFFER_IMMUTABLE_STORAGE, &imm);
 	unbind(BufferTarget::QUERY);
+#endif
 	return imm == GL_FALSE;
 }
 
 GLuint vg::buffers::size(ids::GLBuffer buf)
 {
+	if (const BufferMetadata* record = metadata(buf))
+		return GLuint(record->size);
 	GLint size;
+#if VANGUARD_MIN_OPENGL_VERSION_IS_AT_LEAST(4, 5)
+	glGetNamedBufferParameteriv(buf, GL_BUFFER_SIZE, &size);
+#else
 	bind(buf, BufferTarget::QUERY);
 	glGetBufferParameteriv((GLenum)BufferTarget::QUERY, GL_BUFFER_SIZE, &size);
 	unbind(BufferTarget::QUERY);
+#endif
 	return size;
 }
+
+void vg::buffers::init_immutable(ids::GLBuffer b, GLsizeiptr size, const void* data, int usage)
+{
+#if VANGUARD_MIN_OPENGL_VERSION_IS_AT_LEAST(4, 5)
+	glNamedBufferStorage(b, size, data, usage);
+	record_metadata(b, size, usage, false);
+#else
+	bind(b, BufferTarget::COPY_WRITE);
+	glBufferStorage(GL_COPY_WRITE_BUFFER, size, data, usage);
+	record_metadata(b, size, usage, false);
+#endif
+}
+
+void vg::buffers::init_mutable(ids::GLBuffer b, GLsizeiptr size, const void* data, BufferMutableUsage usage)
+{
+#if VANGUARD_MIN_OPENGL_VERSION_IS_AT_LEAST(4, 5)
+	glNamedBufferData(b, size, data, (GLenum)usage);
+	record_metadata(b, size, (GLenum)usage, true);
+#else
+	bind(b, BufferTarget::COPY_WRITE);
+	glBufferData(GL_COPY_WRITE_BUFFER, size, data, (GLenum)usage);
+	record_metadata(b, size, (GLenum)usage, true);
+#endif
+}
+
+void vg::buffers::subsend(ids::GLBuffer b, GLintptr offset_bytes, GLsizeiptr size, const void* data)
+{
+#if VANGUARD_MIN_OPENGL_VERSION_IS_AT_LEAST(4, 5)
+	glNamedBufferSubData(b, offset_bytes, size, data);
+#else
+	bind(b, BufferTarget::COPY_WRITE);
+	subsend(BufferTarget::COPY_WRITE, offset_bytes, size, data);
+#endif
+}
+
+void vg::buffers::upload(ids::GLBuffer b, GLintptr offset_bytes, GLsizeiptr size, const void* data, UploadStrategy strategy)
+{
+	if (strategy == UploadStrategy::SUBDATA)
+	{
+		subsend(b, offset_bytes, size, data);
+		return;
+	}
+#if VANGUARD_MIN_OPENGL_VERSION_IS_AT_LEAST(4, 5)
+	if (strategy == UploadStrategy::ORPHAN)
+		check_orphan_range(buffers::size(b), offset_bytes, size);
+	void* client = glMapNamedBufferRange(b, offset_bytes, size, map_access(strategy));
+	if (!client)
+		throw Error(ErrorCode::BUFFER_MAPPING, "cannot map " + std::to_string(size) + " bytes at offset " + std::to_string(offset_bytes));
+	memcpy(client, data, size);
+	if (strategy == UploadStrategy::UNSYNCHRONIZED)
+		glFlushMappedNamedBufferRange(b, 0, size);
+	glUnmapNamedBuffer(b);
+#else
+	bind(b, BufferTarget::COPY_WRITE);
+	submap(BufferTarget::COPY_WRITE, offset_bytes, size, data, strategy);
+#endif
+}
+
+void vg::buffers::upload_ranges(ids::GLBuffer b, const DirtyRanges& ranges, const void* data, UploadStrategy strategy)
+{
+	if (ranges.empty())
+		return;
+	const char* bytes = (const char*)data;
+	if (strategy == UploadStrategy::ORPHAN)
+	{
+		upload(b, 0, buffers::size(b), data, strategy);
+		return;
+	}
+	if (strategy != UploadStrategy::UNSYNCHRONIZED || ranges.ranges().size() == 1)
+	{
+		for (const DirtyRanges::Range& range : ranges.ranges())
+			upload(b, range.begin, range.bytes(), bytes + range.begin, strategy);
+		return;
+	}
+
+	// The span is mapped without invalidation, since the clean gaps between ranges must survive.
+	GLintptr span_begin = ranges.ranges().front().begin;
+	GLsizeiptr span = ranges.ranges().back().end - span_begin;
+	GLbitfield access = GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_FLUSH_EXPLICIT_BIT;
+#if VANGUARD_MIN_OPENGL_VERSION_IS_AT_LEAST(4, 5)
+	char* client = (char*)glMapNamedBufferRange(b, span_begin, span, access);
+#else
+	bind(b, BufferTarget::COPY_WRITE);
+	char* client = (char*)glMapBufferRange(GL_COPY_WRITE_BUFFER, span_begin, span, access);
+#endif
+	if (!client)
+		throw Error(ErrorCode::BUFFER_MAPPING, "cannot map " + std::to_string(span) + " bytes at offset " + std::to_string(span_begin));
+	for (const DirtyRanges::Range& range : ranges.ranges())
+	{
+		memcpy(client + (range.begin - span_begin), bytes + range.begin, range.bytes());
+#if VANGUARD_MIN_OPENGL_VERSION_IS_AT_LEAST(4, 5)
+		glFlushMappedNamedBufferRange(b, range.begin - span_begin, range.bytes());
+#else
+		glFlushMappedBufferRange(GL_COPY_WRITE_BUFFER, range.begin - span_begin, range.bytes());
+#endif
+	}
+#if VANGUARD_MIN_OPENGL_VERSION_IS_AT_LEAST(4, 5)
+	glUnmapNamedBuffer(b);
+#else
+	glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+#endif
+}
+
+vg::VoidArray vg::buffers::read(ids::GLBuffer b, GLintptr offset_bytes, GLsizeiptr size)
+{
+#if VANGUARD_MIN_OPENGL_VERSION_IS_AT_LEAST(4, 5)
+	VoidArray data(size);
+	glGetNamedBufferSubData(b, offset_bytes, size, data);
+	return data;
+#else
+	bind(b, BufferTarget::COPY_WRITE);
+	return read(BufferTarget::COPY_WRITE, offset_bytes, size);
+#endif
+}
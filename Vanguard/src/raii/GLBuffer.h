@@ -1,7 +1,10 @@
 #pragma once
 
 #include "Vendor.h"
+#include "Memory.h"
 #include "utils/VoidArray.h"
+#include "utils/DirtyBitmap.h"
+#include "utils/DirtyRanges.h"
 
 namespace vg
 {
@@ -105,6 +108,7 @@ namespace vg
 
 	extern void bind_index_buffer_to_vertex_array(ids::GLBuffer ib, ids::VertexArray va);
 	extern void bind_index_buffers_to_vertex_arrays(const ids::GLBuffer* ibs, const ids::VertexArray* vas, GLuint count);
+	extern void bind_vertex_array(ids::VertexArray va);
 	extern void unbind_vertex_array();
 
 	struct IndirectArraysCmd
@@ -171,6 +175,37 @@ namespace vg
 		void send_cmd() const { g.send_cmd(cmd); }
 	};
 
+	// Keeps a CPU copy of every command in a GPUIndirectArraysBlock. Commands changed through cmd() or the setters are marked in a bitmap, and flush() uploads the changed runs
+	// with one glBufferSubData each, uploading short unchanged gaps rather than splitting around them. All commands start zeroed and dirty.
+	class CPUIndirectArraysBlock
+	{
+		GPUIndirectArraysBlock g;
+		std::vector<IndirectArraysCmd> _cmds;
+		DirtyBitmap _dirty;
+
+	public:
+		CPUIndirectArraysBlock(GLuint count);
+
+		const GPUIndirectArraysBlock& gpu_arrays() const { return g; }
+
+		void bind() const { g.bind(); }
+
+		GLuint get_count() const { return g.get_count(); }
+
+		const IndirectArraysCmd& cmd(GLuint i) const;
+		IndirectArraysCmd& cmd(GLuint i);
+
+		void set_vertex_count(GLuint i, GLuint vertex_count) { cmd(i).vertex_count = vertex_count; }
+		void set_instance_count(GLuint i, GLuint instance_count) { cmd(i).instance_count = instance_count; }
+		void set_first_vertex(GLuint i, GLuint first_vertex) { cmd(i).first_vertex = first_vertex; }
+		void set_first_instance(GLuint i, GLuint first_instance) { cmd(i).first_instance = first_instance; }
+		void set_cmds(GLuint first, GLuint count, const IndirectArraysCmd* cmds);
+
+		void mark_dirty(GLuint first, GLuint count);
+		bool is_dirty() const { return !_dirty.empty(); }
+		void flush();
+	};
+
 	enum class IndexDataType
 	{
 		UBYTE = GL_UNSIGNED_BYTE,
@@ -249,6 +284,39 @@ namespace vg
 		void send_cmd() const { g.send_cmd(cmd); }
 	};
 
+	// The GPUIndirectElementsBlock counterpart of CPUIndirectArraysBlock.
+	class CPUIndirectElementsBlock
+	{
+		GPUIndirectElementsBlock g;
+		std::vector<IndirectElementsCmd> _cmds;
+		DirtyBitmap _dirty;
+
+	public:
+		IndexDataType idt;
+
+		CPUIndirectElementsBlock(GLuint count, IndexDataType idt);
+
+		const GPUIndirectElementsBlock& gpu_elements() const { return g; }
+
+		void bind() const { g.bind(); }
+
+		GLuint get_count() const { return g.get_count(); }
+
+		const IndirectElementsCmd& cmd(GLuint i) const;
+		IndirectElementsCmd& cmd(GLuint i);
+
+		void set_index_count(GLuint i, GLuint index_count) { cmd(i).index_count = index_count; }
+		void set_instance_count(GLuint i, GLuint instance_count) { cmd(i).instance_count = instance_count; }
+		void set_first_index(GLuint i, GLuint first_index) { cmd(i).first_index = first_index; }
+		void set_base_vertex(GLuint i, GLuint base_vertex) { cmd(i).base_vertex = base_vertex; }
+		void set_first_instance(GLuint i, GLuint first_instance) { cmd(i).first_instance = first_instance; }
+		void set_cmds(GLuint first, GLuint count, const IndirectElementsCmd* cmds);
+
+		void mark_dirty(GLuint first, GLuint count);
+		bool is_dirty() const { return !_dirty.empty(); }
+		void flush();
+	};
+
 	enum class BufferTarget
 	{
 		VERTEX = GL_ARRAY_BUFFER,
@@ -293,6 +361,32 @@ namespace vg
 		};
 	}
 
+	// How new data reaches a buffer the GPU may still be reading. Which strategy avoids a stall depends on the driver, so it is chosen per buffer.
+	// Every strategy but SUBDATA maps the buffer, which needs mutable storage or immutable storage created with BufferImmutableUsage::MAP_WRITE.
+	enum class UploadStrategy
+	{
+		// glBufferSubData. The driver may have to wait for draws that read the buffer, or copy the data aside until they finish.
+		SUBDATA,
+		// Maps with GL_MAP_INVALIDATE_BUFFER_BIT, so draws in flight keep the old storage and the write gets fresh storage. Since the whole old storage is discarded,
+		// an ORPHAN write must cover the whole buffer, from offset 0, and a partial one throws.
+		ORPHAN,
+		// Maps the written range with GL_MAP_INVALIDATE_RANGE_BIT. The rest of the buffer is kept.
+		INVALIDATE,
+		// Maps with GL_MAP_UNSYNCHRONIZED_BIT and flushes the written ranges explicitly. It never waits: the caller must know the GPU is done with those ranges,
+		// from a fence or because no pending draw reads them.
+		UNSYNCHRONIZED
+	};
+
+	// How a buffer's storage was last specified. The buffers::init_* functions record it for each buffer they initialize, so that size and mutability are answered
+	// without a GL query, which would wait on the pipeline.
+	struct BufferMetadata
+	{
+		GLsizeiptr size = 0;
+		// BufferImmutableUsage flags for immutable storage, a BufferMutableUsage value for mutable storage.
+		GLenum usage = 0;
+		bool is_mutable = true;
+	};
+
 	namespace buffers
 	{
 		extern void bind(ids::GLBuffer b, BufferTarget target);
@@ -302,10 +396,33 @@ namespace vg
 		extern void subsend(BufferTarget target, GLintptr offset_bytes, GLsizeiptr size, const void* data);
 		extern void map(BufferTarget target, void* data, size_t size);
 		extern void submap(BufferTarget target, GLintptr offset_bytes, GLsizeiptr length_bytes, void* data);
+		extern void map(BufferTarget target, const void* data, size_t size, UploadStrategy strategy);
+		extern void submap(BufferTarget target, GLintptr offset_bytes, GLsizeiptr length_bytes, const void* data, UploadStrategy strategy);
 		extern void copy_gl_buffer(ids::GLBuffer b_src, ids::GLBuffer b_dst, GLintptr offset_src_bytes, GLintptr offset_dst_bytes, GLsizeiptr size);
 		extern void copy_bound_gl_buffers(GLintptr offset_src_bytes, GLintptr offset_dst_bytes, GLsizeiptr size);
 		extern VoidArray read(BufferTarget target, GLintptr offset_bytes, GLsizeiptr size);
+		// Answered from the recorded metadata. Buffers whose storage was specified with raw GL calls fall back to a query. Storage specified through a target is recorded against the buffer GL reports bound there.
 		extern bool is_mutable(ids::GLBuffer buf);
 		extern GLuint size(ids::GLBuffer buf);
+		// The recorded metadata of buf, or nullptr if none was recorded.
+		extern const BufferMetadata* metadata(ids::GLBuffer buf);
+		// Drops the records of deleted buffers and releases their bytes from memory accounting. The raii destructors call it.
+		extern void forget_metadata(const GLuint* bufs, GLuint count);
+		// The memory category buf's storage is counted under. Wrappers tag the buffers they own, and untagged buffers take the category of the target their storage
+		// is specified through. Tagging a buffer that already has storage moves its bytes to the new category.
+		extern void set_category(ids::GLBuffer buf, MemoryCategory category);
+		extern void set_category(const raii::GLBufferBlock& bufs, MemoryCategory category);
+		extern MemoryCategory category(ids::GLBuffer buf);
+		extern MemoryCategory target_category(BufferTarget target);
+
+		// Named variants edit a buffer without binding it to a target. They use DSA on 4.5+, and otherwise go through the COPY_WRITE target, which no VAO or draw call reads from.
+		extern void init_immutable(ids::GLBuffer b, GLsizeiptr size, const void* data = nullptr, int usage = BufferImmutableUsage::DYNAMIC_STORAGE);
+		extern void init_mutable(ids::GLBuffer b, GLsizeiptr size, const void* data = nullptr, BufferMutableUsage usage = BufferMutableUsage::DYNAMIC_DRAW);
+		extern void subsend(ids::GLBuffer b, GLintptr offset_bytes, GLsizeiptr size, const void* data);
+		extern void upload(ids::GLBuffer b, GLintptr offset_bytes, GLsizeiptr size, const void* data, UploadStrategy strategy);
+		// Uploads each range of ranges from the same offsets of data, which mirrors the buffer from offset 0. UNSYNCHRONIZED maps the span of all ranges once and flushes each range;
+		// ORPHAN uploads the whole buffer, so under it data must hold all size(b) bytes.
+		extern void upload_ranges(ids::GLBuffer b, const DirtyRanges& ranges, const void* data, UploadStrategy strategy);
+		extern VoidArray read(ids::GLBuffer b, GLintptr offset_bytes, GLsizeiptr size);
 	}
 }
@@ -2,6 +2,7 @@
 
 #include "utils/IO.h"
 #include "Errors.h"
+#include "GLState.h"
 
 static GLenum subshader_type(vg::SubshaderType type)
 {
@@ -331,6 +332,7 @@ vg::Shader& vg::Shader::operator=(Shader&& other) noexcept
 {
 	if (this != &other)
 	{
+		state::forget_program(_s);
 		glDeleteProgram(_s);
 		_s = other._s;
 		other._s = 0;
@@ -343,6 +345,7 @@ vg::Shader& vg::Shader::operator=(Shader&& other) noexcept
 
 vg::Shader::~Shader()
 {
+	state::forget_program(_s);
 	glDeleteProgram(_s);
 }
 
@@ -354,27 +357,19 @@ GLint vg::Shader::uniform_location(const std::string& name) const
 	return iter->second.location;
 }
 
-static GLuint bound_shader = 0;
-
 void vg::bind_shader(const Shader& shader)
 {
-	if (shader != bound_shader)
-	{
-		glUseProgram(shader);
-		bound_shader = shader;
-	}
+	state::use_program(shader);
 }
 
 void vg::unbind_shader()
 {
-	if (bound_shader)
-	{
-		glUseProgram(0);
-		bound_shader = 0;
-	}
+	state::use_program(0);
 }
 
 void vg::update_bound_shader()
 {
-	glGetIntegerv(GL_CURRENT_PROGRAM, reinterpret_cast<GLint*>(&bound_shader));
+	GLint program;
+	glGetIntegerv(GL_CURRENT_PROGRAM, &program);
+	state::set_bound_program(program);
 }
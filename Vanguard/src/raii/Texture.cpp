@@ -3,7 +3,11 @@
 #include <stb/stb_image.h>
 #include <stb/stb_image_write.h>
 
+#include <unordered_map>
+
 #include "Errors.h"
+#include "GLState.h"
+#include "Memory.h"
 
 void vg::texture_params::min_filter(Target target, MinFilter filter)
 {
@@ -233,11 +237,77 @@ void vg::texture_params::nearest(ids::Texture texture)
 
 #endif
 
+// The images whose storage was specified through tex::, per texture name, so that respecifying an image replaces its bytes in memory accounting and deleting
+// the texture releases them. Each image is one level of one face.
+struct TextureImageRecord
+{
+	GLenum image_target;
+	GLint level;
+	GLenum internal_format;
+	size_t bytes;
+};
+
+static std::unordered_map<GLuint, std::vector<TextureImageRecord>> texture_images;
+
+static GLenum binding_target(GLenum image_target)
+{
+	return image_target >= GL_TEXTURE_CUBE_MAP_POSITIVE_X && image_target <= GL_TEXTURE_CUBE_MAP_NEGATIVE_Z ? GL_TEXTURE_CUBE_MAP : image_target;
+}
+
+// Images are specified on the texture bound to their target. Proxy targets allocate nothing, and have no binding in the state cache, so they are skipped along with
+// targets whose bound texture the cache doesn't know.
+static void record_texture_image(GLenum image_target, GLint level, vg::CHPP chpp, size_t texels)
+{
+	GLuint texture = vg::state::bound_texture(binding_target(image_target));
+	if (texture == 0 || texture == GLuint(-1))
+		return;
+	GLenum internal_format = vg::chpp_internal_format(chpp);
+	// chpp_internal_format() has 8 bits per channel.
+	size_t bytes = texels * chpp;
+	auto& images = texture_images[texture];
+	for (TextureImageRecord& image : images)
+	{
+		if (image.image_target == image_target && image.level == level)
+		{
+			vg::memory::release_texture(image.internal_format, image.level, image.bytes);
+			vg::memory::allocate_texture(internal_format, level, bytes);
+			image.internal_format = internal_format;
+			image.bytes = bytes;
+			return;
+		}
+	}
+	images.push_back({ image_target, level, internal_format, bytes });
+	vg::memory::allocate_texture(internal_format, level, bytes);
+}
+
+static void forget_texture_images(const GLuint* textures, GLuint count)
+{
+	for (GLuint i = 0; i < count; ++i)
+	{
+		auto iter = texture_images.find(textures[i]);
+		if (iter == texture_images.end())
+			continue;
+		for (const TextureImageRecord& image : iter->second)
+			vg::memory::release_texture(image.internal_format, image.level, image.bytes);
+		texture_images.erase(iter);
+	}
+}
+
 vg::raii::Texture::Texture()
 {
 	glGenTextures(1, (GLuint*)&_t);
 }
 
+vg::raii::Texture::Texture(TextureTarget target)
+{
+#if VANGUARD_MIN_OPENGL_VERSION_IS_AT_LEAST(4, 5)
+	glCreateTextures((GLenum)target, 1, (GLuint*)&_t);
+#else
+	glGenTextures(1, (GLuint*)&_t);
+	bind_texture(_t, target);
+#endif
+}
+
 vg::raii::Texture::Texture(Texture&& other) noexcept
 	: _t(other._t)
 {
@@ -248,6 +318,8 @@ vg::raii::Texture& vg::raii::Texture::operator=(Texture&& other) noexcept
 {
 	if (this != &other)
 	{
+		state::forget_textures((GLuint*)&_t, 1);
+		forget_texture_images((GLuint*)&_t, 1);
 		glDeleteTextures(1, (GLuint*)&_t);
 		_t = other._t;
 		other._t = T(0);
@@ -257,6 +329,8 @@ vg::raii::Texture& vg::raii::Texture::operator=(Texture&& other) noexcept
 
 vg::raii::Texture::~Texture()
 {
+	state::forget_textures((GLuint*)&_t, 1);
+	forget_texture_images((GLuint*)&_t, 1);
 	glDeleteTextures(1, (GLuint*)&_t);
 }
 
@@ -267,6 +341,19 @@ vg::raii::TextureBlock::TextureBlock(GLuint count)
 	glGenTextures(count, reinterpret_cast<GLuint*>(_ts));
 }
 
+vg::raii::TextureBlock::TextureBlock(GLuint count, TextureTarget target)
+	: count(count)
+{
+	_ts = new ids::Texture[count];
+#if VANGUARD_MIN_OPENGL_VERSION_IS_AT_LEAST(4, 5)
+	glCreateTextures((GLenum)target, count, reinterpret_cast<GLuint*>(_ts));
+#else
+	glGenTextures(count, reinterpret_cast<GLuint*>(_ts));
+	for (GLuint i = 0; i < count; ++i)
+		bind_texture(_ts[i], target);
+#endif
+}
+
 vg::raii::TextureBlock::TextureBlock(TextureBlock&& other) noexcept
 	: _ts(other._ts), count(other.count)
 {
@@ -278,6 +365,8 @@ vg::raii::TextureBlock& vg::raii::TextureBlock::operator=(TextureBlock&& other)
 {
 	if (this != &other)
 	{
+		state::forget_textures((GLuint*)_ts, count);
+		forget_texture_images((GLuint*)_ts, count);
 		glDeleteTextures(count, (GLuint*)_ts);
 		delete[] _ts;
 		_ts = other._ts;
@@ -290,6 +379,8 @@ vg::raii::TextureBlock& vg::raii::TextureBlock::operator=(TextureBlock&& other)
 
 vg::raii::TextureBlock::~TextureBlock()
 {
+	state::forget_textures((GLuint*)_ts, count);
+	forget_texture_images((GLuint*)_ts, count);
 	glDeleteTextures(count, (GLuint*)_ts);
 	delete[] _ts;
 }
@@ -304,29 +395,29 @@ vg::ids::Texture vg::raii::TextureBlock::operator[](GLuint i) const
 void vg::select_texture_slot(GLuint slot)
 {
 	if (slot >= 0 && slot < 32)
-		glActiveTexture(GL_TEXTURE0 + slot);
+		state::active_texture(slot);
 	else
 		throw Error(ErrorCode::INVALID_TEXTURE_SLOT);
 }
 
 void vg::bind_texture(vg::ids::Texture texture, TextureTarget target)
 {
-	glBindTexture((GLenum)target, texture);
+	state::bind_texture((GLenum)target, texture);
 }
 
 void vg::unbind_texture(TextureTarget target)
 {
-	glBindTexture((GLenum)target, 0);
+	state::bind_texture((GLenum)target, 0);
 }
 
 void vg::bind_texture_to_slot(ids::Texture texture, GLuint slot)
 {
-	glBindTextureUnit(slot, texture);
+	state::bind_texture_unit(slot, texture);
 }
 
 void vg::bind_textures_to_slots(const ids::Texture* textures, GLuint first_slot, GLuint count)
 {
-	glBindTextures(first_slot, count, (const GLuint*)textures);
+	state::bind_texture_units(first_slot, count, (const GLuint*)textures);
 }
 
 GLint vg::chpp_alignment(CHPP chpp)
@@ -379,26 +470,33 @@ GLint vg::chpp_internal_format(CHPP chpp)
 void vg::tex::image_1d(int width, CHPP chpp, const void* pixels, Target1D target, DataType data_type, int border, int level)
 {
 	glTexImage1D((GLenum)target, level, chpp_internal_format(chpp), width, border, chpp_format(chpp), (GLenum)data_type, pixels);
+	record_texture_image((GLenum)target, level, chpp, size_t(width + 2 * border));
 }
 
 void vg::tex::image_2d(int width, int height, CHPP chpp, const void* pixels, ImageTarget2D target, DataType data_type, int border, int level)
 {
 	glTexImage2D((GLenum)target, level, chpp_internal_format(chpp), width, height, border, chpp_format(chpp), (GLenum)data_type, pixels);
+	record_texture_image((GLenum)target, level, chpp, size_t(width + 2 * border) * (height + 2 * border));
 }
 
 void vg::tex::image_3d(int width, int height, int depth, CHPP chpp, const void* pixels, ImageTarget3D target, DataType data_type, int border, int level)
 {
 	glTexImage3D((GLenum)target, level, chpp_internal_format(chpp), width, height, depth, border, chpp_format(chpp), (GLenum)data_type, pixels);
+	record_texture_image((GLenum)target, level, chpp, size_t(width + 2 * border) * (height + 2 * border) * (depth + 2 * border));
 }
 
 void vg::tex::multisample_2d(GLsizei samples, int width, int height, CHPP chpp, bool fixed, bool proxy)
 {
 	glTexImage2DMultisample(proxy ? GL_PROXY_TEXTURE_2D_MULTISAMPLE : GL_TEXTURE_2D_MULTISAMPLE, samples, chpp_internal_format(chpp), width, height, fixed);
+	if (!proxy)
+		record_texture_image(GL_TEXTURE_2D_MULTISAMPLE, 0, chpp, size_t(samples) * width * height);
 }
 
 void vg::tex::multisample_3d(GLsizei samples, int width, int height, int depth, CHPP chpp, bool fixed, bool proxy)
 {
 	glTexImage3DMultisample(proxy ? GL_PROXY_TEXTURE_2D_MULTISAMPLE_ARRAY : GL_TEXTURE_2D_MULTISAMPLE_ARRAY, samples, chpp_internal_format(chpp), width, height, depth, fixed);
+	if (!proxy)
+		record_texture_image(GL_TEXTURE_2D_MULTISAMPLE_ARRAY, 0, chpp, size_t(samples) * width * height * depth);
 }
 
 void vg::tex::subimage_1d(int xoff, int width, CHPP chpp, const void* pixels, DataType data_type, int level)
@@ -419,16 +517,19 @@ void vg::tex::subimage_3d(int xoff, int yoff, int zoff, int width, int height, i
 void vg::tex::copy_image_1d(int x, int y, int width, CHPP chpp, int border, int level)
 {
 	glCopyTexImage1D(GL_TEXTURE_1D, level, chpp_internal_format(chpp), x, y, width, border);
+	record_texture_image(GL_TEXTURE_1D, level, chpp, size_t(width + 2 * border));
 }
 
 void vg::tex::copy_image_2d(int x, int y, int width, int height, CHPP chpp, int border, int level)
 {
 	glCopyTexImage2D(GL_TEXTURE_2D, level, chpp_internal_format(chpp), x, y, width, height, border);
+	record_texture_image(GL_TEXTURE_2D, level, chpp, size_t(width + 2 * border) * (height + 2 * border));
 }
 
 void vg::tex::copy_image_cube_map(int x, int y, int width, int height, CHPP chpp, CubeMapFaceTarget target, int border, int level)
 {
 	glCopyTexImage2D((GLenum)target, level, chpp_internal_format(chpp), x, y, width, height, border);
+	record_texture_image((GLenum)target, level, chpp, size_t(width + 2 * border) * (height + 2 * border));
 }
 
 void vg::tex::copy_subimage_1d(int xoff, int x, int y, int width, int level)
@@ -23,6 +23,21 @@ namespace vg
 		};
 	}
 
+	enum class TextureTarget
+	{
+		T1D = GL_TEXTURE_1D,
+		T2D = GL_TEXTURE_2D,
+		T1D_ARRAY = GL_TEXTURE_1D_ARRAY,
+		RECTANGLE = GL_TEXTURE_RECTANGLE,
+		T3D = GL_TEXTURE_3D,
+		T2D_ARRAY = GL_TEXTURE_2D_ARRAY,
+		CUBE_MAP = GL_TEXTURE_CUBE_MAP,
+		CUBE_MAP_ARRAY = GL_TEXTURE_CUBE_MAP_ARRAY,
+		T2D_MULTISAMPLE = GL_TEXTURE_2D_MULTISAMPLE,
+		T2D_MULTISAMPLE_ARRAY = GL_TEXTURE_2D_MULTISAMPLE_ARRAY,
+		BUFFER = GL_TEXTURE_BUFFER
+	};
+
 	namespace raii
 	{
 		class Texture
@@ -32,6 +47,7 @@ namespace vg
 
 		public:
 			Texture();
+			Texture(TextureTarget target);
 			Texture(const Texture&) = delete;
 			Texture(Texture&&) noexcept;
 			Texture& operator=(Texture&&) noexcept;
@@ -48,6 +64,7 @@ namespace vg
 
 		public:
 			TextureBlock(GLuint count);
+			TextureBlock(GLuint count, TextureTarget target);
 			TextureBlock(const TextureBlock&) = delete;
 			TextureBlock(TextureBlock&&) noexcept;
 			TextureBlock& operator=(TextureBlock&&) noexcept;
@@ -58,21 +75,6 @@ namespace vg
 		};
 	}
 
-	enum class TextureTarget
-	{
-		T1D = GL_TEXTURE_1D,
-		T2D = GL_TEXTURE_2D,
-		T1D_ARRAY = GL_TEXTURE_1D_ARRAY,
-		RECTANGLE = GL_TEXTURE_RECTANGLE,
-		T3D = GL_TEXTURE_3D,
-		T2D_ARRAY = GL_TEXTURE_2D_ARRAY,
-		CUBE_MAP = GL_TEXTURE_CUBE_MAP,
-		CUBE_MAP_ARRAY = GL_TEXTURE_CUBE_MAP_ARRAY,
-		T2D_MULTISAMPLE = GL_TEXTURE_2D_MULTISAMPLE,
-		T2D_MULTISAMPLE_ARRAY = GL_TEXTURE_2D_MULTISAMPLE_ARRAY,
-		BUFFER = GL_TEXTURE_BUFFER
-	};
-
 	enum class MinFilter
 	{
 		NEAREST = GL_NEAREST,
@@ -399,11 +401,11 @@ namespace vg
 			
 		public:
 			Image2D(int width, int height, CHPP chpp)
-				: _w(width), _h(height), _c(chpp), _pxs(width * height * chpp * sizeof(DT))
+				: _pxs(width * height * chpp * sizeof(DT)), _w(width), _h(height), _c(chpp)
 			{
 			}
 			Image2D(vg::Image&& img)
-				: _w(img.width), _h(img.height), _c(img.chpp), _pxs(img.bytes(), img.pixels)
+				: _pxs(img.bytes(), img.pixels), _w(img.width), _h(img.height), _c(img.chpp)
 			{
 			}
 
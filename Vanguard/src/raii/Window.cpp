@@ -3,6 +3,7 @@
 #include "Vanguard.h"
 #include "Errors.h"
 #include "Input.h"
+#include "GLState.h"
 #include "raii/FrameBuffer.h"
 
 // LATER use Logger instead
@@ -141,6 +142,7 @@ void vg::Window::focus() const
 void vg::Window::focus_context() const
 {
 	glfwMakeContextCurrent(_w);
+	state::invalidate();
 }
 
 bool vg::Window::should_close() const
@@ -0,0 +1,67 @@
+#include "DirtyBitmap.h"
+
+#include <algorithm>
+#include <bit>
+
+vg::DirtyBitmap::DirtyBitmap(size_t size)
+	: _words((size + 63) / 64, 0), _size(size)
+{
+}
+
+void vg::DirtyBitmap::mark(size_t first, size_t count)
+{
+	if (count == 0)
+		return;
+	size_t last = first + count - 1;
+	for (size_t w = first >> 6; w <= last >> 6; ++w)
+	{
+		uint64_t mask = ~uint64_t(0);
+		if (w == first >> 6)
+			mask &= ~uint64_t(0) << (first & 63);
+		if (w == last >> 6)
+			mask &= ~uint64_t(0) >> (63 - (last & 63));
+		_words[w] |= mask;
+	}
+	_any = true;
+}
+
+void vg::DirtyBitmap::clear()
+{
+	if (!_any)
+		return;
+	std::fill(_words.begin(), _words.end(), 0);
+	_any = false;
+}
+
+// The first element at or after i whose bit equals set, or size() if there is none. Bits past size() are never set, so a search for an unmarked element stops there too.
+size_t vg::DirtyBitmap::next(size_t i, bool set) const
+{
+	if (i >= _size)
+		return _size;
+	size_t w = i >> 6;
+	uint64_t bits = (set ? _words[w] : ~_words[w]) & (~uint64_t(0) << (i & 63));
+	while (bits == 0)
+	{
+		if (++w == _words.size())
+			return _size;
+		bits = set ? _words[w] : ~_words[w];
+	}
+	return std::min(w * 64 + std::countr_zero(bits), _size);
+}
+
+std::vector<vg::DirtyBitmap::Run> vg::DirtyBitmap::runs(size_t max_gap) const
+{
+	std::vector<Run> rs;
+	if (!_any)
+		return rs;
+	for (size_t begin = next(0, true); begin < _size; begin = next(begin, true))
+	{
+		size_t end = next(begin, false);
+		if (!rs.empty() && begin - rs.back().end <= max_gap)
+			rs.back().end = end;
+		else
+			rs.push_back({ begin, end });
+		begin = end;
+	}
+	return rs;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace vg
+{
+	// DirtyBitmap records which fixed-size elements of a buffer were modified since the last flush, one bit each. Marking is a single OR however scattered the writes,
+	// and runs() walks the bitmap a word at a time, so elements that are far apart or dense are both cheap to track. For byte ranges of varying size, use DirtyRanges.
+	class DirtyBitmap
+	{
+	public:
+		struct Run
+		{
+			size_t begin;
+			size_t end;
+
+			size_t count() const { return end - begin; }
+		};
+
+	private:
+		std::vector<uint64_t> _words;
+		size_t _size = 0;
+		bool _any = false;
+
+		size_t next(size_t i, bool set) const;
+
+	public:
+		explicit DirtyBitmap(size_t size = 0);
+
+		size_t size() const { return _size; }
+		void mark(size_t i) { _words[i >> 6] |= uint64_t(1) << (i & 63); _any = true; }
+		void mark(size_t first, size_t count);
+		bool test(size_t i) const { return (_words[i >> 6] >> (i & 63)) & 1; }
+		void clear();
+		bool empty() const { return !_any; }
+		// The marked elements as sorted runs. Runs separated by max_gap or fewer unmarked elements are joined, for when uploading a short clean gap is cheaper than another upload.
+		std::vector<Run> runs(size_t max_gap = 0) const;
+	};
+}
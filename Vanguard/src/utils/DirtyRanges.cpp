@@ -0,0 +1,34 @@
+#include "DirtyRanges.h"
+
+#include <algorithm>
+
+void vg::DirtyRanges::mark(size_t offset_bytes, size_t bytes)
+{
+	if (bytes == 0)
+		return;
+	size_t begin = offset_bytes;
+	size_t end = offset_bytes + bytes;
+
+	// Writes usually progress forward through a buffer, so check the last range before searching.
+	if (_ranges.empty() || _ranges.back().end < begin)
+	{
+		_ranges.push_back({ begin, end });
+		return;
+	}
+
+	auto first = std::lower_bound(_ranges.begin(), _ranges.end(), begin, [](const Range& range, size_t b) { return range.end < b; });
+	auto last = first;
+	while (last != _ranges.end() && last->begin <= end)
+	{
+		begin = std::min(begin, last->begin);
+		end = std::max(end, last->end);
+		++last;
+	}
+	if (first == last)
+		_ranges.insert(first, { begin, end });
+	else
+	{
+		*first = { begin, end };
+		_ranges.erase(first + 1, last);
+	}
+}
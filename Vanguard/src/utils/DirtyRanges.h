@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace vg
+{
+	// DirtyRanges records the byte ranges of a buffer that were modified since the last flush. Ranges are kept sorted, and overlapping or adjacent ranges are merged as they are marked,
+	// so flushing only needs one upload per disjoint range.
+	class DirtyRanges
+	{
+	public:
+		struct Range
+		{
+			size_t begin;
+			size_t end;
+
+			size_t bytes() const { return end - begin; }
+		};
+
+	private:
+		std::vector<Range> _ranges;
+
+	public:
+		void mark(size_t offset_bytes, size_t bytes);
+		void clear() { _ranges.clear(); }
+		bool empty() const { return _ranges.empty(); }
+		const std::vector<Range>& ranges() const { return _ranges; }
+	};
+}
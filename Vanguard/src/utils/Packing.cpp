@@ -0,0 +1,179 @@
+#include "Packing.h"
+
+#include <cstring>
+
+#include <glm/simd/platform.h>
+
+// Same detection as Strided.cpp. F16C ships with every AVX2 CPU, and MSVC has no separate switch for it.
+#if (GLM_ARCH & GLM_ARCH_SSE2_BIT) || defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define VANGUARD_PACKING_SSE2
+#endif
+#if defined(__F16C__) || defined(__AVX2__)
+#define VANGUARD_PACKING_F16C
+#endif
+
+#if defined(VANGUARD_PACKING_F16C)
+#include <immintrin.h>
+#elif defined(VANGUARD_PACKING_SSE2)
+#include <emmintrin.h>
+#endif
+
+using Encoding = vg::packing::Encoding;
+
+size_t vg::packing::encoded_size(Encoding encoding, GLuint components)
+{
+	switch (encoding)
+	{
+	case Encoding::FLOAT: return components * sizeof(GLfloat);
+	case Encoding::HALF: return components * sizeof(GLhalf);
+	case Encoding::UNORM8:
+	case Encoding::SNORM8: return components * sizeof(GLubyte);
+	case Encoding::UNORM16:
+	case Encoding::SNORM16: return components * sizeof(GLushort);
+	case Encoding::UNORM_2_10_10_10:
+	case Encoding::SNORM_2_10_10_10: return sizeof(GLuint);
+	}
+	return 0;
+}
+
+// Each element is widened to 4 lanes, so vec2 UVs, vec3 normals and vec4 colours share one conversion; components beyond the input read as 0.
+static glm::vec4 load_scalar(const float* src, GLuint components)
+{
+	glm::vec4 v(0.0f);
+	std::memcpy(&v, src, components * sizeof(float));
+	return v;
+}
+
+template<Encoding E>
+static void encode_scalar(char* dst, const float* src, GLuint components)
+{
+	glm::vec4 v = load_scalar(src, components);
+	if constexpr (E == Encoding::UNORM_2_10_10_10 || E == Encoding::SNORM_2_10_10_10)
+	{
+		GLuint w = E == Encoding::UNORM_2_10_10_10 ? vg::packing::unorm_2_10_10_10(v) : vg::packing::snorm_2_10_10_10(v);
+		std::memcpy(dst, &w, sizeof(w));
+	}
+	else
+	{
+		for (GLuint c = 0; c < components; ++c)
+		{
+			if constexpr (E == Encoding::HALF)
+				reinterpret_cast<GLhalf*>(dst)[c] = vg::packing::half(v[c]);
+			else if constexpr (E == Encoding::UNORM8)
+				reinterpret_cast<GLubyte*>(dst)[c] = vg::packing::unorm8(v[c]);
+			else if constexpr (E == Encoding::SNORM8)
+				reinterpret_cast<GLbyte*>(dst)[c] = vg::packing::snorm8(v[c]);
+			else if constexpr (E == Encoding::UNORM16)
+				reinterpret_cast<GLushort*>(dst)[c] = vg::packing::unorm16(v[c]);
+			else if constexpr (E == Encoding::SNORM16)
+				reinterpret_cast<GLshort*>(dst)[c] = vg::packing::snorm16(v[c]);
+		}
+	}
+}
+
+#ifdef VANGUARD_PACKING_SSE2
+static __m128 load(const float* src, GLuint components)
+{
+	if (components == 4)
+		return _mm_loadu_ps(src);
+	float v[4] = {};
+	std::memcpy(v, src, components * sizeof(float));
+	return _mm_loadu_ps(v);
+}
+
+static __m128i normalize(__m128 v, float lo, float hi, __m128 scale)
+{
+	v = _mm_min_ps(_mm_max_ps(v, _mm_set1_ps(lo)), _mm_set1_ps(hi));
+	return _mm_cvtps_epi32(_mm_mul_ps(v, scale));
+}
+
+template<Encoding E>
+static void encode_simd(char* dst, const float* src, GLuint components)
+{
+	__m128 v = load(src, components);
+	if constexpr (E == Encoding::UNORM8)
+	{
+		__m128i i = normalize(v, 0.0f, 1.0f, _mm_set1_ps(255.0f));
+		i = _mm_packus_epi16(_mm_packs_epi32(i, i), i);
+		int packed = _mm_cvtsi128_si32(i);
+		std::memcpy(dst, &packed, components);
+	}
+	else if constexpr (E == Encoding::SNORM8)
+	{
+		__m128i i = normalize(v, -1.0f, 1.0f, _mm_set1_ps(127.0f));
+		i = _mm_packs_epi16(_mm_packs_epi32(i, i), i);
+		int packed = _mm_cvtsi128_si32(i);
+		std::memcpy(dst, &packed, components);
+	}
+	else if constexpr (E == Encoding::UNORM16)
+	{
+		// SSE2 only packs with signed saturation, so values are biased into the signed range and the sign bit is flipped back after packing.
+		__m128i i = _mm_sub_epi32(normalize(v, 0.0f, 1.0f, _mm_set1_ps(65535.0f)), _mm_set1_epi32(32768));
+		i = _mm_xor_si128(_mm_packs_epi32(i, i), _mm_set1_epi16((short)0x8000));
+		alignas(16) GLushort packed[8];
+		_mm_store_si128((__m128i*)packed, i);
+		std::memcpy(dst, packed, components * sizeof(GLushort));
+	}
+	else if constexpr (E == Encoding::SNORM16)
+	{
+		__m128i i = normalize(v, -1.0f, 1.0f, _mm_set1_ps(32767.0f));
+		i = _mm_packs_epi32(i, i);
+		alignas(16) GLshort packed[8];
+		_mm_store_si128((__m128i*)packed, i);
+		std::memcpy(dst, packed, components * sizeof(GLshort));
+	}
+	else if constexpr (E == Encoding::UNORM_2_10_10_10 || E == Encoding::SNORM_2_10_10_10)
+	{
+		__m128i i = E == Encoding::UNORM_2_10_10_10 ? normalize(v, 0.0f, 1.0f, _mm_setr_ps(1023.0f, 1023.0f, 1023.0f, 3.0f))
+			: normalize(v, -1.0f, 1.0f, _mm_setr_ps(511.0f, 511.0f, 511.0f, 1.0f));
+		i = _mm_and_si128(i, _mm_setr_epi32(0x3FF, 0x3FF, 0x3FF, 0x3));
+		alignas(16) GLuint lanes[4];
+		_mm_store_si128((__m128i*)lanes, i);
+		GLuint packed = lanes[0] | (lanes[1] << 10) | (lanes[2] << 20) | (lanes[3] << 30);
+		std::memcpy(dst, &packed, sizeof(packed));
+	}
+	else if constexpr (E == Encoding::HALF)
+	{
+#ifdef VANGUARD_PACKING_F16C
+		__m128i h = _mm_cvtps_ph(v, _MM_FROUND_TO_NEAREST_INT);
+		alignas(16) GLhalf packed[8];
+		_mm_store_si128((__m128i*)packed, h);
+		std::memcpy(dst, packed, components * sizeof(GLhalf));
+#else
+		encode_scalar<E>(dst, src, components);
+#endif
+	}
+}
+#endif
+
+template<Encoding E>
+static void encode_all(char* dst, size_t dst_stride, const float* src, GLuint components, size_t count)
+{
+	for (size_t i = 0; i < count; ++i, dst += dst_stride, src += components)
+	{
+#ifdef VANGUARD_PACKING_SSE2
+		encode_simd<E>(dst, src, components);
+#else
+		encode_scalar<E>(dst, src, components);
+#endif
+	}
+}
+
+void vg::packing::encode(Encoding encoding, GLuint components, void* dst, size_t dst_stride, const float* src, size_t count)
+{
+	char* d = (char*)dst;
+	switch (encoding)
+	{
+	case Encoding::FLOAT:
+		for (size_t i = 0; i < count; ++i, d += dst_stride, src += components)
+			std::memcpy(d, src, components * sizeof(float));
+		break;
+	case Encoding::HALF: encode_all<Encoding::HALF>(d, dst_stride, src, components, count); break;
+	case Encoding::UNORM8: encode_all<Encoding::UNORM8>(d, dst_stride, src, components, count); break;
+	case Encoding::SNORM8: encode_all<Encoding::SNORM8>(d, dst_stride, src, components, count); break;
+	case Encoding::UNORM16: encode_all<Encoding::UNORM16>(d, dst_stride, src, components, count); break;
+	case Encoding::SNORM16: encode_all<Encoding::SNORM16>(d, dst_stride, src, components, count); break;
+	case Encoding::UNORM_2_10_10_10: encode_all<Encoding::UNORM_2_10_10_10>(d, dst_stride, src, components, count); break;
+	case Encoding::SNORM_2_10_10_10: encode_all<Encoding::SNORM_2_10_10_10>(d, dst_stride, src, components, count); break;
+	}
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "Vendor.h"
+
+#include <glm/gtc/packing.hpp>
+
+namespace vg
+{
+	// Encoders from float vectors to the compact formats a VertexAttribute can be overridden to store: half floats, normalized 8/16-bit integers and 2_10_10_10_REV words.
+	// Normalized encoders clamp to the representable range and round to nearest, which is the inverse of how GL normalizes them on fetch.
+	namespace packing
+	{
+		enum class Encoding : char
+		{
+			FLOAT,
+			HALF,
+			UNORM8,
+			SNORM8,
+			UNORM16,
+			SNORM16,
+			UNORM_2_10_10_10,
+			SNORM_2_10_10_10
+		};
+
+		// Bytes taken by one element of components floats, once encoded. 2_10_10_10 elements are always one word.
+		extern size_t encoded_size(Encoding encoding, GLuint components);
+
+		inline GLhalf half(float f) { return glm::packHalf1x16(f); }
+		inline GLubyte unorm8(float f) { return glm::packUnorm1x8(f); }
+		inline GLbyte snorm8(float f) { return (GLbyte)glm::packSnorm1x8(f); }
+		inline GLushort unorm16(float f) { return glm::packUnorm1x16(f); }
+		inline GLshort snorm16(float f) { return (GLshort)glm::packSnorm1x16(f); }
+		inline GLuint unorm_2_10_10_10(const glm::vec4& v) { return glm::packUnorm3x10_1x2(v); }
+		inline GLuint snorm_2_10_10_10(const glm::vec4& v) { return glm::packSnorm3x10_1x2(v); }
+
+		// Encodes count elements of components floats each, read tightly packed from src, to dst_stride bytes apart in dst. Each element is converted in one SIMD register where available.
+		extern void encode(Encoding encoding, GLuint components, void* dst, size_t dst_stride, const float* src, size_t count);
+	}
+}
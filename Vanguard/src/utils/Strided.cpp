@@ -0,0 +1,181 @@
+#include "Strided.h"
+
+#include <climits>
+#include <cstring>
+
+#include <glm/simd/platform.h>
+
+// glm only reports SSE/AVX through GLM_ARCH when its intrinsics are forced, so the compiler's own target macros are checked as well.
+#if (GLM_ARCH & GLM_ARCH_AVX2_BIT) || defined(__AVX2__)
+#define VANGUARD_STRIDED_AVX2
+#endif
+#if (GLM_ARCH & GLM_ARCH_SSE2_BIT) || defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define VANGUARD_STRIDED_SSE2
+#endif
+
+#if defined(VANGUARD_STRIDED_AVX2)
+#include <immintrin.h>
+#elif defined(VANGUARD_STRIDED_SSE2)
+#include <emmintrin.h>
+#endif
+
+// A memcpy of a constant size compiles to one or two register moves, so each common attribute size gets its own loop. Loops are unrolled by 4 so that stores to consecutive
+// vertices issue back to back.
+
+template<size_t Size>
+static void copy_fixed(char* dst, size_t dst_stride, const char* src, size_t src_stride, size_t count)
+{
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4, dst += 4 * dst_stride, src += 4 * src_stride)
+	{
+		std::memcpy(dst, src, Size);
+		std::memcpy(dst + dst_stride, src + src_stride, Size);
+		std::memcpy(dst + 2 * dst_stride, src + 2 * src_stride, Size);
+		std::memcpy(dst + 3 * dst_stride, src + 3 * src_stride, Size);
+	}
+	for (; i < count; ++i, dst += dst_stride, src += src_stride)
+		std::memcpy(dst, src, Size);
+}
+
+template<size_t Size>
+static void fill_fixed(char* dst, size_t dst_stride, size_t count, const char* value)
+{
+	char v[Size];
+	std::memcpy(v, value, Size);
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4, dst += 4 * dst_stride)
+	{
+		std::memcpy(dst, v, Size);
+		std::memcpy(dst + dst_stride, v, Size);
+		std::memcpy(dst + 2 * dst_stride, v, Size);
+		std::memcpy(dst + 3 * dst_stride, v, Size);
+	}
+	for (; i < count; ++i, dst += dst_stride)
+		std::memcpy(dst, v, Size);
+}
+
+#ifdef VANGUARD_STRIDED_SSE2
+template<>
+void fill_fixed<16>(char* dst, size_t dst_stride, size_t count, const char* value)
+{
+	__m128i v = _mm_loadu_si128((const __m128i*)value);
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4, dst += 4 * dst_stride)
+	{
+		_mm_storeu_si128((__m128i*)dst, v);
+		_mm_storeu_si128((__m128i*)(dst + dst_stride), v);
+		_mm_storeu_si128((__m128i*)(dst + 2 * dst_stride), v);
+		_mm_storeu_si128((__m128i*)(dst + 3 * dst_stride), v);
+	}
+	for (; i < count; ++i, dst += dst_stride)
+		_mm_storeu_si128((__m128i*)dst, v);
+}
+
+template<>
+void copy_fixed<16>(char* dst, size_t dst_stride, const char* src, size_t src_stride, size_t count)
+{
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4, dst += 4 * dst_stride, src += 4 * src_stride)
+	{
+		__m128i a = _mm_loadu_si128((const __m128i*)src);
+		__m128i b = _mm_loadu_si128((const __m128i*)(src + src_stride));
+		__m128i c = _mm_loadu_si128((const __m128i*)(src + 2 * src_stride));
+		__m128i d = _mm_loadu_si128((const __m128i*)(src + 3 * src_stride));
+		_mm_storeu_si128((__m128i*)dst, a);
+		_mm_storeu_si128((__m128i*)(dst + dst_stride), b);
+		_mm_storeu_si128((__m128i*)(dst + 2 * dst_stride), c);
+		_mm_storeu_si128((__m128i*)(dst + 3 * dst_stride), d);
+	}
+	for (; i < count; ++i, dst += dst_stride, src += src_stride)
+		_mm_storeu_si128((__m128i*)dst, _mm_loadu_si128((const __m128i*)src));
+}
+#endif
+
+#ifdef VANGUARD_STRIDED_AVX2
+template<>
+void fill_fixed<32>(char* dst, size_t dst_stride, size_t count, const char* value)
+{
+	__m256i v = _mm256_loadu_si256((const __m256i*)value);
+	for (size_t i = 0; i < count; ++i, dst += dst_stride)
+		_mm256_storeu_si256((__m256i*)dst, v);
+}
+
+template<>
+void copy_fixed<32>(char* dst, size_t dst_stride, const char* src, size_t src_stride, size_t count)
+{
+	for (size_t i = 0; i < count; ++i, dst += dst_stride, src += src_stride)
+		_mm256_storeu_si256((__m256i*)dst, _mm256_loadu_si256((const __m256i*)src));
+}
+
+// Gathers 8 strided 4-byte elements per instruction. Used for reading a float or int channel out of interleaved vertices.
+static bool gather_4(char* dst, const char* src, size_t src_stride, size_t count)
+{
+	if (src_stride > INT_MAX / 8)
+		return false;
+	__m256i offsets = _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32((int)src_stride));
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8, dst += 32, src += 8 * src_stride)
+		_mm256_storeu_si256((__m256i*)dst, _mm256_i32gather_epi32((const int*)src, offsets, 1));
+	copy_fixed<4>(dst, 4, src, src_stride, count - i);
+	return true;
+}
+#endif
+
+void vg::strided::copy(void* dst, size_t dst_stride, const void* src, size_t src_stride, size_t count, size_t size)
+{
+	char* d = (char*)dst;
+	const char* s = (const char*)src;
+	if (dst_stride == size && src_stride == size)
+	{
+		std::memcpy(d, s, count * size);
+		return;
+	}
+	switch (size)
+	{
+	case 1: copy_fixed<1>(d, dst_stride, s, src_stride, count); break;
+	case 2: copy_fixed<2>(d, dst_stride, s, src_stride, count); break;
+	case 4: copy_fixed<4>(d, dst_stride, s, src_stride, count); break;
+	case 8: copy_fixed<8>(d, dst_stride, s, src_stride, count); break;
+	case 12: copy_fixed<12>(d, dst_stride, s, src_stride, count); break;
+	case 16: copy_fixed<16>(d, dst_stride, s, src_stride, count); break;
+	case 24: copy_fixed<24>(d, dst_stride, s, src_stride, count); break;
+	case 32: copy_fixed<32>(d, dst_stride, s, src_stride, count); break;
+	default:
+		for (size_t i = 0; i < count; ++i, d += dst_stride, s += src_stride)
+			std::memcpy(d, s, size);
+	}
+}
+
+void vg::strided::fill(void* dst, size_t dst_stride, size_t count, const void* value, size_t size)
+{
+	char* d = (char*)dst;
+	const char* v = (const char*)value;
+	switch (size)
+	{
+	case 1: fill_fixed<1>(d, dst_stride, count, v); break;
+	case 2: fill_fixed<2>(d, dst_stride, count, v); break;
+	case 4: fill_fixed<4>(d, dst_stride, count, v); break;
+	case 8: fill_fixed<8>(d, dst_stride, count, v); break;
+	case 12: fill_fixed<12>(d, dst_stride, count, v); break;
+	case 16: fill_fixed<16>(d, dst_stride, count, v); break;
+	case 24: fill_fixed<24>(d, dst_stride, count, v); break;
+	case 32: fill_fixed<32>(d, dst_stride, count, v); break;
+	default:
+		for (size_t i = 0; i < count; ++i, d += dst_stride)
+			std::memcpy(d, v, size);
+	}
+}
+
+void vg::strided::scatter(void* dst, size_t dst_stride, const void* src, size_t count, size_t size)
+{
+	copy(dst, dst_stride, src, size, count, size);
+}
+
+void vg::strided::gather(void* dst, const void* src, size_t src_stride, size_t count, size_t size)
+{
+#ifdef VANGUARD_STRIDED_AVX2
+	if (size == 4 && src_stride != 4 && gather_4((char*)dst, (const char*)src, src_stride, count))
+		return;
+#endif
+	copy(dst, size, src, src_stride, count, size);
+}
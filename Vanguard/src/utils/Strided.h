@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <type_traits>
+
+#include "VoidArray.h"
+
+namespace vg
+{
+	// Kernels for one attribute interleaved across many vertices: element n of a strided side lives at base + n * stride. Sizes and strides are in bytes.
+	// The raw kernels do no range checking; the VoidArray overloads check the whole span once per call.
+	namespace strided
+	{
+		extern void copy(void* dst, size_t dst_stride, const void* src, size_t src_stride, size_t count, size_t size);
+		extern void fill(void* dst, size_t dst_stride, size_t count, const void* value, size_t size);
+		extern void scatter(void* dst, size_t dst_stride, const void* src, size_t count, size_t size);
+		extern void gather(void* dst, const void* src, size_t src_stride, size_t count, size_t size);
+
+		inline size_t span(size_t stride, size_t count, size_t size) { return count == 0 ? 0 : (count - 1) * stride + size; }
+
+		inline void check_span(const VoidArray& buf, size_t offset, size_t stride, size_t count, size_t size)
+		{
+			size_t bytes = span(stride, count, size);
+			if (offset + bytes > buf.size())
+				throw offset_out_of_range(buf.size(), offset, bytes);
+		}
+
+		template<typename Type>
+		void fill(VoidArray& buf, size_t offset, size_t stride, size_t count, const Type& value)
+		{
+			static_assert(std::is_trivially_copyable_v<Type>);
+			check_span(buf, offset, stride, count, sizeof(Type));
+			if (count > 0)
+				fill(buf.at(offset), stride, count, &value, sizeof(Type));
+		}
+
+		template<typename Type>
+		void scatter(VoidArray& buf, size_t offset, size_t stride, const Type* src, size_t count)
+		{
+			static_assert(std::is_trivially_copyable_v<Type>);
+			check_span(buf, offset, stride, count, sizeof(Type));
+			if (count > 0)
+				scatter(buf.at(offset), stride, src, count, sizeof(Type));
+		}
+
+		template<typename Type>
+		void gather(const VoidArray& buf, size_t offset, size_t stride, Type* dst, size_t count)
+		{
+			static_assert(std::is_trivially_copyable_v<Type>);
+			check_span(buf, offset, stride, count, sizeof(Type));
+			if (count > 0)
+				gather(dst, buf.at(offset), stride, count, sizeof(Type));
+		}
+	}
+}
@@ -0,0 +1,124 @@
+#include "ThreadPool.h"
+
+#include <exception>
+
+// The pool and queue index of the worker running on this thread, so that jobs a worker submits go to its own queue, and its own queue is checked first.
+static thread_local const vg::ThreadPool* worker_pool = nullptr;
+static thread_local unsigned worker_index = 0;
+
+vg::ThreadPool::ThreadPool(unsigned thread_count)
+{
+	if (thread_count == 0)
+		thread_count = std::thread::hardware_concurrency() > 1 ? std::thread::hardware_concurrency() - 1 : 1;
+	for (unsigned i = 0; i < thread_count; ++i)
+		_queues.push_back(std::make_unique<Queue>());
+	for (unsigned i = 0; i < thread_count; ++i)
+		_threads.emplace_back(&ThreadPool::work, this, i);
+}
+
+vg::ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(_sleep_mutex);
+		_stopping = true;
+	}
+	_wake.notify_all();
+	for (std::thread& thread : _threads)
+		thread.join();
+}
+
+vg::ThreadPool& vg::ThreadPool::shared()
+{
+	static ThreadPool pool;
+	return pool;
+}
+
+void vg::ThreadPool::work(unsigned index)
+{
+	worker_pool = this;
+	worker_index = index;
+	for (;;)
+	{
+		if (run_one())
+			continue;
+		std::unique_lock<std::mutex> lock(_sleep_mutex);
+		_wake.wait(lock, [this]() { return _stopping || _queued > 0; });
+		if (_stopping && _queued == 0)
+			return;
+	}
+}
+
+void vg::ThreadPool::submit(std::function<void()> job)
+{
+	unsigned index = worker_pool == this ? worker_index : _next_queue++ % (unsigned)_queues.size();
+	// Counted before it is queued, so a worker that finds the count raised may spin once, but never sleeps through a queued job.
+	{
+		std::lock_guard<std::mutex> lock(_sleep_mutex);
+		++_queued;
+	}
+	{
+		Queue& queue = *_queues[index];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		queue.jobs.push_back(std::move(job));
+	}
+	_wake.notify_one();
+}
+
+bool vg::ThreadPool::run_one()
+{
+	std::function<void()> job;
+	unsigned self = worker_pool == this ? worker_index : 0;
+	unsigned n = (unsigned)_queues.size();
+	for (unsigned i = 0; i < n && !job; ++i)
+	{
+		Queue& queue = *_queues[(self + i) % n];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (queue.jobs.empty())
+			continue;
+		if (i == 0 && worker_pool == this)
+		{
+			job = std::move(queue.jobs.back());
+			queue.jobs.pop_back();
+		}
+		else
+		{
+			job = std::move(queue.jobs.front());
+			queue.jobs.pop_front();
+		}
+	}
+	if (!job)
+		return false;
+	--_queued;
+	job();
+	return true;
+}
+
+void vg::ThreadPool::parallel_for(unsigned count, const std::function<void(unsigned)>& job)
+{
+	std::atomic<unsigned> remaining = count;
+	std::mutex error_mutex;
+	std::exception_ptr error;
+	for (unsigned i = 0; i < count; ++i)
+	{
+		submit([&, i]() {
+			try
+			{
+				job(i);
+			}
+			catch (...)
+			{
+				std::lock_guard<std::mutex> lock(error_mutex);
+				if (!error)
+					error = std::current_exception();
+			}
+			remaining.fetch_sub(1, std::memory_order_release);
+			});
+	}
+	while (remaining.load(std::memory_order_acquire) > 0)
+	{
+		if (!run_one())
+			std::this_thread::yield();
+	}
+	if (error)
+		std::rethrow_exception(error);
+}
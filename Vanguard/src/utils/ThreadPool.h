@@ -0,0 +1,54 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace vg
+{
+	// ThreadPool runs jobs on a fixed set of worker threads. Each worker has its own queue: it takes its newest job first, and when its queue is empty it steals the oldest job
+	// of another worker, so a thread that submits a burst of jobs doesn't become the only one working through them. Threads outside the pool push round-robin onto the workers' queues.
+	// Jobs must not touch GL; results are handed back to the GL thread, which uploads them.
+	class ThreadPool
+	{
+		struct Queue
+		{
+			std::mutex mutex;
+			std::deque<std::function<void()>> jobs;
+		};
+
+		std::vector<std::unique_ptr<Queue>> _queues;
+		std::vector<std::thread> _threads;
+		std::atomic<unsigned> _next_queue = 0;
+		std::mutex _sleep_mutex;
+		std::condition_variable _wake;
+		std::atomic<size_t> _queued = 0;
+		bool _stopping = false;
+
+		void work(unsigned index);
+
+	public:
+		// 0 threads means one worker per hardware thread besides the calling one, which helps while it waits.
+		explicit ThreadPool(unsigned thread_count = 0);
+		ThreadPool(const ThreadPool&) = delete;
+		// Finishes every queued job, then joins the workers.
+		~ThreadPool();
+
+		// A pool shared by the whole process, created on first use.
+		static ThreadPool& shared();
+
+		unsigned thread_count() const { return (unsigned)_threads.size(); }
+
+		// Jobs submitted directly must not throw.
+		void submit(std::function<void()> job);
+		// Runs one queued job on the calling thread, if there is one. Returns whether a job ran.
+		bool run_one();
+		// Runs job(0) ... job(count - 1) across the pool and the calling thread, and returns once all have finished. The first exception a job throws is rethrown here.
+		void parallel_for(unsigned count, const std::function<void(unsigned)>& job);
+	};
+}
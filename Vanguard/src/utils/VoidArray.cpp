@@ -2,38 +2,52 @@
 
 #include <memory>
 
+#include "Memory.h"
+
 vg::VoidArray::VoidArray(size_t size)
-    : _size(size)
+    : _size(size), _capacity(size)
 {
     _v = malloc(_size);
     if (!_v) throw std::bad_alloc();
+    memory::allocate(MemoryCategory::CPU, _capacity);
 }
 
 vg::VoidArray::VoidArray(size_t size, void* v)
-    : _size(size), _v(v)
+    : _v(v), _size(size), _capacity(size)
 {
+    if (_v)
+        memory::allocate(MemoryCategory::CPU, _capacity);
 }
 
 vg::VoidArray::VoidArray(VoidArray&& other) noexcept
-    : _v(other._v), _size(other._size)
+    : _v(other._v), _size(other._size), _capacity(other._capacity)
 {
     other._v = nullptr;
+    other._size = 0;
+    other._capacity = 0;
 }
 
 vg::VoidArray& vg::VoidArray::operator=(VoidArray&& other) noexcept
 {
     if (this != &other)
     {
+        if (_v)
+            memory::release(MemoryCategory::CPU, _capacity);
         free(_v);
         _v = other._v;
         other._v = nullptr;
         _size = other._size;
+        _capacity = other._capacity;
+        other._size = 0;
+        other._capacity = 0;
     }
     return *this;
 }
 
 vg::VoidArray::~VoidArray()
 {
+    if (_v)
+        memory::release(MemoryCategory::CPU, _capacity);
     free(_v);
 }
 
@@ -46,11 +60,36 @@ vg::VoidArray vg::VoidArray::clone() const
 
 void vg::VoidArray::resize(size_t size)
 {
-    void* r = realloc(_v, size);
+    reserve(size);
+    _size = size;
+}
+
+void vg::VoidArray::reserve(size_t capacity)
+{
+    if (capacity <= _capacity)
+        return;
+    void* r = realloc(_v, capacity);
     if (!r)
         throw std::bad_alloc();
+    // Counted before the old block is released, as realloc may hold both while it copies.
+    memory::allocate(MemoryCategory::CPU, capacity);
+    if (_v)
+        memory::release(MemoryCategory::CPU, _capacity);
     _v = r;
-    _size = size;
+    _capacity = capacity;
+}
+
+void vg::VoidArray::shrink_to_fit()
+{
+    if (_size == _capacity || _size == 0)
+        return;
+    void* r = realloc(_v, _size);
+    if (!r)
+        throw std::bad_alloc();
+    memory::allocate(MemoryCategory::CPU, _size);
+    memory::release(MemoryCategory::CPU, _capacity);
+    _v = r;
+    _capacity = _size;
 }
 
 const void* vg::VoidArray::at(size_t offset) const
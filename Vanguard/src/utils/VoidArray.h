@@ -8,6 +8,7 @@ namespace vg
 	{
 		void* _v = nullptr;
 		size_t _size;
+		size_t _capacity;
 
 	public:
 		VoidArray(size_t size = 0);
@@ -20,7 +21,11 @@ namespace vg
 		VoidArray clone() const;
 
 		size_t size() const { return _size; }
+		size_t capacity() const { return _capacity; }
+		// Growing past capacity() reallocates to exactly the new size, and shrinking keeps the allocation. Call reserve() first for amortized growth.
 		void resize(size_t size);
+		void reserve(size_t capacity);
+		void shrink_to_fit();
 
 		operator const void* () const { return _v; }
 		operator void* () { return _v; }